@@ -609,6 +609,7 @@ void REGPARAM2 chipmem_lput_actionreplay1 (uaecptr addr, uae_u32 l)
 	uae_u32 *m;
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 4);
 	if (addr == 0x60 && !is_ar_pc_in_rom())
 		action_replay_chipwrite ();
 	m = (uae_u32 *)(chipmemory + addr);
@@ -620,6 +621,7 @@ void REGPARAM2 chipmem_wput_actionreplay1 (uaecptr addr, uae_u32 w)
 
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 2);
 	if (addr == 0x60 && !is_ar_pc_in_rom())
 		action_replay_chipwrite ();
 	m = (uae_u16 *)(chipmemory + addr);
@@ -629,6 +631,7 @@ void REGPARAM2 chipmem_bput_actionreplay1 (uaecptr addr, uae_u32 b)
 {
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 1);
 	if (addr >= 0x60 && addr <= 0x63 && !is_ar_pc_in_rom())
 		action_replay_chipwrite();
 	chipmemory[addr] = b;
@@ -638,6 +641,7 @@ void REGPARAM2 chipmem_lput_actionreplay23 (uaecptr addr, uae_u32 l)
 	uae_u32 *m;
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	do_put_mem_long (m, l);
 	if (addr >= 0x40 && addr < 0x200 && action_replay_flag == ACTION_REPLAY_WAITRESET)
@@ -649,6 +653,7 @@ void REGPARAM2 chipmem_wput_actionreplay23 (uaecptr addr, uae_u32 w)
 
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	do_put_mem_word (m, w);
 	if (addr >= 0x40 && addr < 0x200 && action_replay_flag == ACTION_REPLAY_WAITRESET)
@@ -28,6 +28,12 @@
 #include "savestate.h"
 #include "debug.h"
 
+#ifdef BLITTER_DEBUG_NO_D
+#undef BLITTER_SIMD
+#endif
+
+#include "blitfill.h"
+
 /* we must not change ce-mode while blitter is running.. */
 static int blitter_cycle_exact;
 static int blt_statefile_type;
@@ -56,7 +62,6 @@ static int blitter_slowdowndebug;
 
 struct bltinfo blt_info;
 
-static uae_u8 blit_filltable[256][4][2];
 uae_u32 blit_masktable[BLITTER_MAX_WORDS];
 enum blitter_states bltstate;
 
@@ -221,32 +226,137 @@ static const int *set_cycle_diagram_type (uae_u8 diag)
 	return NULL;
 }
 
+#ifdef BLITTER_SIMD
+
+static blitter_func_simd * const *blitfunc_simd, * const *blitfunc_simd_desc;
+
+static void blitter_simd_init (void)
+{
+	int level = host_simd_level ();
+
+	blitfunc_simd = NULL;
+	blitfunc_simd_desc = NULL;
+#ifdef BLITTER_SIMD_AVX2
+	if (level >= HOST_SIMD_AVX2) {
+		blitfunc_simd = blitfunc_simd_avx2;
+		blitfunc_simd_desc = blitfunc_simd_avx2_desc;
+		write_log (L"Blitter: AVX2\n");
+		return;
+	}
+#endif
+	if (level >= HOST_SIMD_SSE2) {
+		blitfunc_simd = blitfunc_simd_sse2;
+		blitfunc_simd_desc = blitfunc_simd_sse2_desc;
+		write_log (L"Blitter: SSE2\n");
+	}
+}
+
+/* chip RAM was written behind the memory banks, drop what caches it */
+static void blitter_written (uae_s64 lo, uae_s64 hi)
+{
+	decodecache_write_range (chipmemory + lo, chipmemory + hi);
+}
+
+/* Run the blit with host pointers if every active channel stays inside
+ * plain chip RAM and D never writes a word that a source reads later. */
+static int blitter_dofast_simd (blitter_func_simd *func, uaecptr pta, uaecptr ptb, uaecptr ptc, uaecptr ptd, int desc)
+{
+	uaecptr pt[4] = { pta, ptb, ptc, ptd };
+	int mod[4] = { blt_info.bltamod, blt_info.bltbmod, blt_info.bltcmod, blt_info.bltdmod };
+	uae_s64 lo[4], hi[4];
+	uae_u8 *p[4];
+	uae_u16 last[3];
+	int w = blt_info.hblitsize * 2;
+	int i;
+
+	if (!func || currprefs.z3chipmem_size)
+		return 0;
+	for (i = 0; i < 4; i++) {
+		uae_s64 step;
+		p[i] = NULL;
+		if (!pt[i])
+			continue;
+		step = (uae_s64)(w + mod[i]) * (blt_info.vblitsize - 1);
+		if (desc) {
+			lo[i] = (uae_s64)pt[i] - (step > 0 ? step : 0) - w + 2;
+			hi[i] = (uae_s64)pt[i] - (step < 0 ? step : 0) + 2;
+		} else {
+			lo[i] = (uae_s64)pt[i] + (step < 0 ? step : 0);
+			hi[i] = (uae_s64)pt[i] + (step > 0 ? step : 0) + w;
+		}
+		if (lo[i] < 0 || hi[i] > allocated_chipmem)
+			return 0;
+		p[i] = chipmemory + pt[i];
+		/* last word of the last line, read before D can overwrite it */
+		if (i < 3)
+			last[i] = do_get_mem_word ((uae_u16*)(chipmemory + (desc ? pt[i] - step - w + 2 : pt[i] + step + w - 2)));
+	}
+	if (ptd) {
+		for (i = 0; i < 3; i++) {
+			if (!pt[i] || hi[i] <= lo[3] || lo[i] >= hi[3])
+				continue;
+			/* in place, same layout and no line overlaps itself */
+			if (pt[i] == ptd && mod[i] == mod[3] && mod[3] >= 0)
+				continue;
+			return 0;
+		}
+	}
+	func (p[0], p[1], p[2], p[3], &blt_info);
+	if (ptd)
+		blitter_written (lo[3], hi[3]);
+	if (pta)
+		blt_info.bltadat = last[0];
+	if (ptb)
+		blt_info.bltbdat = last[1];
+	if (ptc)
+		blt_info.bltcdat = last[2];
+	return 1;
+}
+
+/* Area fill pass over the D words of a blit that was done without fill.
+ * The fill carry only runs along a line, so lines can be done in any order. */
+static void blitter_fill_lines (uae_u8 *p, int desc)
+{
+	int linestep = (blt_info.hblitsize * 2 + blt_info.bltdmod) * (desc ? -1 : 1);
+	uae_u16 d = blt_info.bltddat;
+	int fc;
+
+	if (blitter_fill_area (p, blt_info.vblitsize, blt_info.hblitsize, desc ? -2 : 2, linestep,
+		blitife, (bltcon1 & 4) ? 1 : 0, &d, &fc))
+		blt_info.blitzero = 0;
+	blt_info.bltddat = d;
+	blitfc = fc;
+}
+
+/* Fill blit: the minterm part runs as a normal blit into D, the fill
+ * is done in place afterwards. Same result as filling each word before
+ * it is written because blitter_dofast_simd () only accepts blits where
+ * no source reads a D word after it has been written. */
+static int blitter_dofast_fill (blitter_func_simd *func, uaecptr pta, uaecptr ptb, uaecptr ptc, uaecptr ptd, int desc)
+{
+	int zero = blt_info.blitzero;
+
+	if (!ptd || !blitter_dofast_simd (func, pta, ptb, ptc, ptd, desc))
+		return 0;
+	blt_info.blitzero = zero;
+	blitter_fill_lines (chipmemory + ptd, desc);
+	return 1;
+}
+
+#endif
+
 void build_blitfilltable (void)
 {
-	unsigned int d, fillmask;
 	int i;
 
+#ifdef BLITTER_SIMD
+	blitter_simd_init ();
+#endif
+
 	for (i = 0; i < BLITTER_MAX_WORDS; i++)
 		blit_masktable[i] = 0xFFFF;
 
-	for (d = 0; d < 256; d++) {
-		for (i = 0; i < 4; i++) {
-			int fc = i & 1;
-			uae_u8 data = d;
-			for (fillmask = 1; fillmask != 0x100; fillmask <<= 1) {
-				uae_u16 tmp = data;
-				if (fc) {
-					if (i & 2)
-						data |= fillmask;
-					else
-						data ^= fillmask;
-				}
-				if (tmp & fillmask) fc = !fc;
-			}
-			blit_filltable[d][i][0] = data;
-			blit_filltable[d][i][1] = fc;
-		}
-	}
+	blitter_filltable_init ();
 }
 
 STATIC_INLINE void record_dma_blit (uae_u16 reg, uae_u16 dat, uae_u32 addr, int hpos)
@@ -387,6 +497,13 @@ static void blitter_dofast (void)
 		bltdpt += (blt_info.hblitsize * 2 + blt_info.bltdmod) * blt_info.vblitsize;
 	}
 
+#ifdef BLITTER_SIMD
+	if (!blitfill && blitfunc_simd && blitter_dofast_simd (blitfunc_simd[mt], bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, 0)) {
+		;
+	} else if (blitfill && blitfunc_simd && blitter_dofast_fill (blitfunc_simd[mt], bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, 0)) {
+		;
+	} else
+#endif
 #ifdef SPEEDUP
 	if (blitfunc_dofast[mt] && !blitfill) {
 		(*blitfunc_dofast[mt])(bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, &blt_info);
@@ -426,14 +543,8 @@ static void blitter_dofast (void)
 				if (dodst)
 					chipmem_agnus_wput2 (dstp, blt_info.bltddat);
 				blt_info.bltddat = blit_func (blitahold, blitbhold, blt_info.bltcdat, mt) & 0xFFFF;
-				if (blitfill) {
-					uae_u16 d = blt_info.bltddat;
-					int ifemode = blitife ? 2 : 0;
-					int fc1 = blit_filltable[d & 255][ifemode + blitfc][1];
-					blt_info.bltddat = (blit_filltable[d & 255][ifemode + blitfc][0]
-						+ (blit_filltable[d >> 8][ifemode + fc1][0] << 8));
-					blitfc = blit_filltable[d >> 8][ifemode + fc1][1];
-				}
+				if (blitfill)
+					blt_info.bltddat = blitter_fill_word (blt_info.bltddat, blitife ? 2 : 0, &blitfc);
 				if (blt_info.bltddat)
 					blt_info.blitzero = 0;
 				if (bltddatptr) {
@@ -486,6 +597,13 @@ static void blitter_dofast_desc (void)
 		bltddatptr = bltdpt;
 		bltdpt -= (blt_info.hblitsize * 2 + blt_info.bltdmod) * blt_info.vblitsize;
 	}
+#ifdef BLITTER_SIMD
+	if (!blitfill && blitfunc_simd_desc && blitter_dofast_simd (blitfunc_simd_desc[mt], bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, 1)) {
+		;
+	} else if (blitfill && blitfunc_simd_desc && blitter_dofast_fill (blitfunc_simd_desc[mt], bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, 1)) {
+		;
+	} else
+#endif
 #ifdef SPEEDUP
 	if (blitfunc_dofast_desc[mt] && !blitfill) {
 		(*blitfunc_dofast_desc[mt])(bltadatptr, bltbdatptr, bltcdatptr, bltddatptr, &blt_info);
@@ -525,14 +643,8 @@ static void blitter_dofast_desc (void)
 				if (dodst)
 					chipmem_agnus_wput2 (dstp, blt_info.bltddat);
 				blt_info.bltddat = blit_func (blitahold, blitbhold, blt_info.bltcdat, mt) & 0xFFFF;
-				if (blitfill) {
-					uae_u16 d = blt_info.bltddat;
-					int ifemode = blitife ? 2 : 0;
-					int fc1 = blit_filltable[d & 255][ifemode + blitfc][1];
-					blt_info.bltddat = (blit_filltable[d & 255][ifemode + blitfc][0]
-					+ (blit_filltable[d >> 8][ifemode + fc1][0] << 8));
-					blitfc = blit_filltable[d >> 8][ifemode + fc1][1];
-				}
+				if (blitfill)
+					blt_info.bltddat = blitter_fill_word (blt_info.bltddat, blitife ? 2 : 0, &blitfc);
 				if (blt_info.bltddat)
 					blt_info.blitzero = 0;
 				if (bltddatptr) {
@@ -759,9 +871,117 @@ static void decide_blitter_line (int hsync, int hpos)
 
 #endif
 
+/* Whole line blit in one go for immediate and non-cycle-exact blits.
+ * Same steps as blitter_read/line/line_proc/nxline/write with the state
+ * kept in locals and chip RAM accessed like chipmem_agnus_wget/wput. */
+static void blitter_line_fast (void)
+{
+	uae_u8 mt = bltcon0 & 0xff;
+	int cdma = (bltcon0 & 0x200) && dmaen (DMA_BLITTER);
+	int achan = bltcon0 & 0x800;
+	int sud = bltcon1 & 0x10, sul = bltcon1 & 0x8, aul = bltcon1 & 0x4;
+	int amod = (uae_s16)blt_info.bltamod, bmod = (uae_s16)blt_info.bltbmod, cmod = blt_info.bltcmod;
+	uae_u16 a = blinea & blt_info.bltafwm;
+	uae_u16 b = blineb;
+	uae_u16 cdat = blt_info.bltcdat, ddat = blt_info.bltddat;
+	uae_u16 last = last_custom_value1;
+	uaecptr cpt = bltcpt, dpt = bltdpt;
+	uae_u32 apt = bltapt;
+	int shift = blinea_shift, onedot = blitonedot, sign = blitsign;
+	int zero = blt_info.blitzero;
+	int n = blt_info.vblitsize;
+	int d1use = ddat1use;
+
+	do {
+		int pixel;
+
+		if (cdma) {
+			cdat = last = do_get_mem_word ((uae_u16*)(chipmemory + (cpt & chipmem_full_mask)));
+		}
+		if (d1use)
+			dpt = cpt;
+		d1use = 1;
+
+		pixel = !blitsing || !onedot;
+		ddat = blit_func ((uae_u16)(a >> shift), (b & 1) ? 0xFFFF : 0, cdat, mt);
+		onedot++;
+
+		if (achan)
+			apt += sign ? bmod : amod;
+		if (!sign) {
+			if (sud) {
+				cpt += sul ? -cmod : cmod;
+				onedot = 0;
+			} else if (sul) {
+				if (shift-- == 0) {
+					shift = 15;
+					cpt -= 2;
+				}
+			} else {
+				if (++shift == 16) {
+					shift = 0;
+					cpt += 2;
+				}
+			}
+		}
+		if (sud) {
+			if (aul) {
+				if (shift-- == 0) {
+					shift = 15;
+					cpt -= 2;
+				}
+			} else {
+				if (++shift == 16) {
+					shift = 0;
+					cpt += 2;
+				}
+			}
+		} else {
+			cpt += aul ? -cmod : cmod;
+			onedot = 0;
+		}
+		sign = 0 > (uae_s16)apt;
+
+		b = (b << 1) | (b >> 15);
+		n--;
+
+		if (pixel) {
+			if (ddat)
+				zero = 0;
+			if (cdma) {
+				uaecptr addr = dpt;
+				last = ddat;
+				addr &= chipmem_full_mask;
+				if (addr < chipmem_full_size) {
+					decodecache_write (chipmemory + addr, 2);
+					do_put_mem_word ((uae_u16*)(chipmemory + addr), ddat);
+				}
+			}
+		}
+	} while (n != 0);
+
+	bltapt = apt;
+	bltcpt = cpt;
+	bltdpt = cpt;
+	blinea_shift = shift;
+	blineb = b;
+	blitonedot = onedot;
+	blitsign = sign;
+	blitlinepixel = 0;
+	ddat1use = d1use;
+	blt_info.vblitsize = 0;
+	blt_info.bltcdat = cdat;
+	blt_info.bltddat = ddat;
+	blt_info.blitzero = zero;
+	last_custom_value1 = last;
+	bltstate = BLT_done;
+}
+
 static void actually_do_blit (void)
 {
-	if (blitline) {
+	if (blitline && !currprefs.z3chipmem_size) {
+		blitter_line_fast ();
+	} else if (blitline) {
 		do {
 			blitter_read ();
 			if (ddat1use)
@@ -993,6 +1213,84 @@ static void do_startcycles (int hpos)
 	}
 }
 
+/* Slots from last_blitter_hpos up to the returned position (at most hpos)
+   have no bitplane DMA and no other allocated cycle, canblit () is true
+   for all. The cheap bitplane check goes first, the slot bitmap is only
+   scanned when at least two slots are left. */
+static int blitter_free_until (int hpos)
+{
+	int end = bitplane_dma_free_until (last_blitter_hpos);
+
+	if (end > hpos)
+		end = hpos;
+	if (end - last_blitter_hpos < 2)
+		return last_blitter_hpos;
+	return cycle_line_next_used (last_blitter_hpos, end);
+}
+
+/* Run the cycle diagram until end when nothing competes for the bus.
+   Same steps as the decide_blitter () loop without the per cycle
+   contention checks and with the diagram position kept incrementally.
+   Returns 1 if the blit finished.  */
+static int blitter_run_free (int end)
+{
+	const int *diag = get_ch ();
+	int n = diag[0];
+	int phase = blit_cyclecounter >= n ? (blit_cyclecounter - n) % n : 0;
+	int final = blit_final;
+
+	while (last_blitter_hpos < end) {
+		int cc = blit_cyclecounter;
+		int c = cc < 0 ? 0 : (cc < n ? diag[1 + cc] : diag[1 + n + phase]);
+
+		blt_info.got_cycle = 1;
+		if (c == 0) {
+			blit_cyclecounter++;
+			if (blit_cyclecounter == 0)
+				blit_final = 0;
+			blit_totalcyclecounter++;
+			if (blit_ch == 0 && blit_cyclecounter >= blit_maxcyclecounter) {
+				blitter_done (last_blitter_hpos);
+				return 1;
+			}
+		} else {
+			blitter_nasty++;
+			if (c == 4) {
+				blitter_doddma (last_blitter_hpos);
+			} else if (blitter_vcounter1 < blt_info.vblitsize) {
+				blitter_dodma (c, last_blitter_hpos);
+			}
+			blit_cyclecounter++;
+			blit_totalcyclecounter++;
+			if (blitter_vcounter1 >= blt_info.vblitsize && blitter_vcounter2 >= blt_info.vblitsize) {
+				if (!ddat1use && !ddat2use) {
+					blitter_done (last_blitter_hpos);
+					return 1;
+				}
+			}
+		}
+		if (!blit_final && blitter_vcounter1 == blt_info.vblitsize && channel_pos (blit_cyclecounter - 1) == blit_diag[0] - 1) {
+			blitter_interrupt (last_blitter_hpos, 0);
+			blit_cyclecounter = 0;
+			blit_final = 1;
+		}
+		last_blitter_hpos++;
+
+		if (blit_final != final) {
+			final = blit_final;
+			diag = get_ch ();
+			n = diag[0];
+			phase = blit_cyclecounter >= n ? (blit_cyclecounter - n) % n : 0;
+		} else if (blit_cyclecounter > n) {
+			if (++phase == n)
+				phase = 0;
+		} else {
+			phase = 0;
+		}
+	}
+	return 0;
+}
+
 void decide_blitter (int hpos)
 {
 	int hsync = hpos < 0;
@@ -1029,6 +1327,15 @@ void decide_blitter (int hpos)
 	while (last_blitter_hpos < hpos) {
 		int c;
 
+		if (!blit_waitcyclecounter && !blit_frozen && dmaen (DMA_BLITTER)) {
+			int end = blitter_free_until (hpos);
+			if (end - last_blitter_hpos >= 2) {
+				if (blitter_run_free (end))
+					return;
+				continue;
+			}
+		}
+
 		c = channel_state (blit_cyclecounter);
 
 		for (;;) {
@@ -1126,7 +1433,7 @@ static void blitter_force_finish (void)
 		if (blitter_cycle_exact) {
 			int rounds = 10000;
 			while (bltstate != BLT_done && rounds > 0) {
-				memset (cycle_line, 0, sizeof cycle_line);
+				cycle_line_clear ();
 				decide_blitter (-1);
 				rounds--;
 			}
@@ -740,6 +740,7 @@ void cfgfile_save_options (struct zfile *f, struct uae_prefs *p, int type)
 	cfgfile_write (f, L"gfx_display", L"%d", p->gfx_display);
 	cfgfile_write_str (f, L"gfx_display_name", p->gfx_display_name);
 	cfgfile_write (f, L"gfx_framerate", L"%d", p->gfx_framerate);
+	cfgfile_dwrite (f, L"gfx_render_threads", L"%d", p->gfx_render_threads);
 	cfgfile_write (f, L"gfx_width", L"%d", p->gfx_size_win.width); /* compatibility with old versions */
 	cfgfile_write (f, L"gfx_height", L"%d", p->gfx_size_win.height); /* compatibility with old versions */
 	cfgfile_write (f, L"gfx_top_windowed", L"%d", p->gfx_size_win.x);
@@ -915,6 +916,9 @@ void cfgfile_save_options (struct zfile *f, struct uae_prefs *p, int type)
 	cfgfile_write_bool (f, L"cpu_compatible", p->cpu_compatible);
 	cfgfile_write_bool (f, L"cpu_24bit_addressing", p->address_space_24);
 	/* do not reorder end */
+	cfgfile_dwrite_bool (f, L"cpu_decode_cache", p->cpu_decode_cache);
+	cfgfile_dwrite_bool (f, L"cpu_lazy_flags", p->cpu_lazy_flags);
+	cfgfile_dwrite_bool (f, L"cpu_busywait_skip", p->cpu_busywait_skip);
 
 	if (p->cpu_cycle_exact) {
 		if (p->cpu_frequency)
@@ -1334,6 +1338,7 @@ static int cfgfile_parse_host (struct uae_prefs *p, TCHAR *option, TCHAR *value)
 
 		|| cfgfile_intval (option, value, L"gfx_display", &p->gfx_display, 1)
 		|| cfgfile_intval (option, value, L"gfx_framerate", &p->gfx_framerate, 1)
+		|| cfgfile_intval (option, value, L"gfx_render_threads", &p->gfx_render_threads, 1)
 		|| cfgfile_intval (option, value, L"gfx_width_windowed", &p->gfx_size_win.width, 1)
 		|| cfgfile_intval (option, value, L"gfx_height_windowed", &p->gfx_size_win.height, 1)
 		|| cfgfile_intval (option, value, L"gfx_top_windowed", &p->gfx_size_win.x, 1)
@@ -2013,6 +2018,9 @@ static int cfgfile_parse_hardware (struct uae_prefs *p, const TCHAR *option, TCH
 		|| cfgfile_yesno (option, value, L"genlock", &p->genlock)
 		|| cfgfile_yesno (option, value, L"cpu_compatible", &p->cpu_compatible)
 		|| cfgfile_yesno (option, value, L"cpu_24bit_addressing", &p->address_space_24)
+		|| cfgfile_yesno (option, value, L"cpu_decode_cache", &p->cpu_decode_cache)
+		|| cfgfile_yesno (option, value, L"cpu_lazy_flags", &p->cpu_lazy_flags)
+		|| cfgfile_yesno (option, value, L"cpu_busywait_skip", &p->cpu_busywait_skip)
 		|| cfgfile_yesno (option, value, L"parallel_on_demand", &p->parallel_demand)
 		|| cfgfile_yesno (option, value, L"parallel_postscript_emulation", &p->parallel_postscript_emulation)
 		|| cfgfile_yesno (option, value, L"parallel_postscript_detection", &p->parallel_postscript_detection)
@@ -3676,6 +3684,7 @@ void default_prefs (struct uae_prefs *p, int type)
 	p->optcount[5] = 0;
 
 	p->gfx_framerate = 1;
+	p->gfx_render_threads = 0;
 	p->gfx_autoframerate = 50;
 	p->gfx_size_fs.width = 800;
 	p->gfx_size_fs.height = 600;
@@ -3713,6 +3722,9 @@ void default_prefs (struct uae_prefs *p, int type)
 	p->scsi = 0;
 	p->uaeserial = 0;
 	p->cpu_idle = 0;
+	p->cpu_decode_cache = 0;
+	p->cpu_lazy_flags = 0;
+	p->cpu_busywait_skip = 0;
 	p->turbo_emulation = 0;
 	p->headless = 0;
 	p->catweasel = 0;
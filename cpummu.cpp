@@ -48,6 +48,11 @@ static struct mmu_atc_line atc_l2[2][ATC_L2_SIZE];
 static unsigned int mmu_atc_hits[ATC_L2_SIZE];
 # endif
 
+/* host pointer TLB, stored in level 1 atc lines */
+static bool mmu_host_tlb_enabled = true;
+/* only touched on the L1 refill path, live hits are in the L1 lines */
+static uae_u64 mmu_tlb_hits, mmu_tlb_misses;
+
 
 static void mmu_dump_ttr(const TCHAR * label, uae_u32 ttr)
 {
@@ -390,12 +395,36 @@ static uaecptr mmu_fill_atc_l2(uaecptr addr, bool super, bool data, bool write,
 	return desc;
 }
 
+/*
+ * Host address of a physical 4k page if it is plain RAM (or ROM when
+ * reading), anything with side effects must go through the bank handlers.
+ * Chip RAM writes also feed the copper cache and the CE2 timing, so chip
+ * RAM always uses the handlers.
+ */
+static uae_u8 *mmu_host_page(uaecptr phys, bool write)
+{
+	addrbank *ab;
+
+	if (!mmu_host_tlb_enabled)
+		return NULL;
+	phys &= ~0xfff;
+	ab = &get_mem_bank(phys);
+	if (ab == &chipmem_bank || ab == &chipmem_bank_ce2)
+		return NULL;
+	if (ab->flags != ABFLAG_RAM && (write || ab->flags != ABFLAG_ROM))
+		return NULL;
+	if (!ab->check(phys, 0x1000))
+		return NULL;
+	return ab->xlateaddr(phys);
+}
+
 static ALWAYS_INLINE bool mmu_fill_atc_l1(uaecptr addr, bool super, bool data, bool write, struct mmu_atc_line *l1)
 {
 	int idx = ATC_L2_INDEX(addr);
 	int tag = ATC_TAG(addr);
 	struct mmu_atc_line *l = &atc_l2[super ? 1 : 0][idx];
 
+	mmu_tlb_misses++;
 	if (l->tag != tag) {
 	restart:
 		mmu_fill_atc_l2(addr, super, data, write, l);
@@ -412,7 +441,10 @@ static ALWAYS_INLINE bool mmu_fill_atc_l1(uaecptr addr, bool super, bool data, b
 		if (!l->modified)
 			goto restart;
 	}
+	mmu_tlb_hits += l1->hits;
 	*l1 = *l;
+	l1->hits = 0;
+	l1->host = mmu_host_page(addr + l1->phys, write);
 #if 0
 	uaecptr phys_addr = addr + l1->phys;
 	if ((phys_addr & 0xfff00000) == 0x00f00000) {
@@ -1009,6 +1041,59 @@ static void REGPARAM2 mmu_flush_atc_all(bool global)
 	}
 }
 
+/* TTR changes can change any translation */
+void mmu_tt_modified(void)
+{
+	mmu_flush_atc_all(true);
+}
+
+/* memory banks changed, cached host pointers are not valid anymore */
+void mmu_flush_host_tlb(void)
+{
+	struct mmu_atc_line *l;
+	unsigned int i;
+
+	l = atc_l1[0][0][0];
+	for (i = 0; i < sizeof(atc_l1) / sizeof(*l); l++, i++)
+		l->tag = 0x8000;
+}
+
+/* debugger memwatch points need to see all accesses */
+void mmu_set_host_tlb(bool enable)
+{
+	mmu_host_tlb_enabled = enable;
+	mmu_flush_host_tlb();
+}
+
+void mmu_tlb_stats(void)
+{
+	struct mmu_atc_line *l;
+	unsigned int i, valid = 0, host = 0;
+	uae_u64 hits = mmu_tlb_hits, host_hits = 0, total;
+
+	l = atc_l1[0][0][0];
+	for (i = 0; i < sizeof(atc_l1) / sizeof(*l); l++, i++) {
+		hits += l->hits;
+		if (l->tag == 0x8000)
+			continue;
+		valid++;
+		if (l->host) {
+			host++;
+			host_hits += l->hits;
+		}
+	}
+	total = hits + mmu_tlb_misses;
+	console_out_f(L"MMU host TLB: %s\n", mmu_host_tlb_enabled ? L"enabled" : L"disabled");
+	console_out_f(L"%u valid ATC L1 entries, %u mapped to host memory\n", valid, host);
+	console_out_f(L"ATC L1 hits %I64u, misses %I64u, hit rate %.2f%%\n",
+		hits, mmu_tlb_misses, total ? hits * 100.0 / total : 0.0);
+	console_out_f(L"Live host mapped entries took %I64u hits\n", host_hits);
+	l = atc_l1[0][0][0];
+	for (i = 0; i < sizeof(atc_l1) / sizeof(*l); l++, i++)
+		l->hits = 0;
+	mmu_tlb_hits = mmu_tlb_misses = 0;
+}
+
 void REGPARAM2 mmu_reset(void)
 {
 	mmu_flush_atc_all(true);
@@ -54,6 +54,9 @@
 #include "ncr_scsi.h"
 #include "blkdev.h"
 #include "sampler.h"
+#ifdef HAVE_SSE2_INTRINSICS
+#include <emmintrin.h>
+#endif
 
 #define CUSTOM_DEBUG 0
 #define SPRITE_DEBUG 0
@@ -233,6 +236,8 @@ int sprite_buffer_res;
 
 #ifdef CPUEMU_12
 uae_u8 cycle_line[256];
+/* allocated cycle_line slots as a bitmap, free slots are found with a bit scan */
+static uae_u32 cycle_line_used[256 / 32];
 #endif
 
 static uae_u16 bplxdat[8];
@@ -319,6 +324,8 @@ static struct copper cop_state;
 static int copper_enabled_thisline;
 static int cop_min_waittime;
 
+static uae_u64 copper_wait_sleeps;
+
 /*
 * Statistics
 */
@@ -444,6 +451,7 @@ STATIC_INLINE void alloc_cycle (int hpos, int type)
 		write_log (L"even %d cycle %d\n", type, hpos);
 #endif
 	cycle_line[hpos] = type;
+	cycle_line_used[hpos >> 5] |= 1u << (hpos & 31);
 #endif
 }
 STATIC_INLINE void alloc_cycle_maybe (int hpos, int type)
@@ -457,6 +465,40 @@ void alloc_cycle_ext(int hpos, int type)
 	alloc_cycle (hpos, type);
 }
 
+void cycle_line_clear (void)
+{
+	memset (cycle_line, 0, sizeof cycle_line);
+	memset (cycle_line_used, 0, sizeof cycle_line_used);
+}
+
+/* first slot at or after hpos that no DMA channel has allocated */
+STATIC_INLINE int cycle_line_next_free (int hpos)
+{
+	while (hpos < maxhpos) {
+		uae_u32 v = ~cycle_line_used[hpos >> 5] >> (hpos & 31);
+		if (v) {
+			hpos += uae_ctz32 (v);
+			break;
+		}
+		hpos = (hpos | 31) + 1;
+	}
+	return hpos < maxhpos ? hpos : maxhpos;
+}
+
+/* first slot from hpos up to limit that is already allocated, limit if none */
+int cycle_line_next_used (int hpos, int limit)
+{
+	while (hpos < limit) {
+		uae_u32 v = cycle_line_used[hpos >> 5] >> (hpos & 31);
+		if (v) {
+			hpos += uae_ctz32 (v);
+			break;
+		}
+		hpos = (hpos | 31) + 1;
+	}
+	return hpos < limit ? hpos : limit;
+}
+
 static void hsyncdelay (void)
 {
 #if 0
@@ -509,15 +551,13 @@ STATIC_INLINE void docols (struct color_entry *colentry)
 #endif
 }
 
-extern struct color_entry colors_for_drawing;
-
 void notice_new_xcolors (void)
 {
 	int i;
 
 	update_mirrors ();
 	docols (&current_colors);
-	docols (&colors_for_drawing);
+	notice_new_drawing_colors ();
 	for (i = 0; i < (MAXVPOS + 1) * 2; i++) {
 		docols (color_tables[0] + i);
 		docols (color_tables[1] + i);
@@ -881,6 +921,23 @@ int is_bitplane_dma (int hpos)
 	return curr_diagram[(hpos - cycle_diagram_shift) & fetchstart_mask];
 }
 
+/* is_bitplane_dma () returns zero for all slots from hpos up to the
+   returned position with the current fetch state */
+int bitplane_dma_free_until (int hpos)
+{
+	int end = estimated_last_fetch_cycle;
+
+	if (fetch_state == fetch_not_started)
+		return maxhpos;
+	if (plf_state == plf_end && thisline_decision.plfright < end)
+		end = thisline_decision.plfright;
+	if (hpos >= end)
+		return maxhpos;
+	if (hpos < plfstrt)
+		return plfstrt < end ? plfstrt : maxhpos;
+	return hpos;
+}
+
 STATIC_INLINE int is_bitplane_dma_inline (int hpos)
 {
 	if (fetch_state == fetch_not_started || hpos < plfstrt)
@@ -939,7 +996,7 @@ static void setup_fmodes (int hpos)
 	fm_maxplane = 1 << fm_maxplane_shift;
 	fetch_modulo_cycle = fetchunit - fetchstart;
 	if (is_bitplane_dma (hpos - 1))
-		cycle_line[hpos - 1] = 1;
+		alloc_cycle (hpos - 1, CYCLE_REFRESH);
 	curr_diagram = cycle_diagram_table[fetchmode][bplcon0_res][bplcon0_planes_limit];
 	estimate_last_fetch_cycle (hpos);
 	if (bpldmasetuphpos >= 0 && debug_dma)
@@ -2018,171 +2075,233 @@ static int expand_sprres (uae_u16 con0, uae_u16 con3)
 	return res;
 }
 
-/* handle very rarely needed playfield collision (CLXDAT bit 0) */
-/* only known game needing this is Rotor */
-static void do_playfield_collisions (void)
+/* Playfield and sprite/playfield collisions are not evaluated at hsync.
+ * hsync_handler_pre only records the line state they depend on and the
+ * pending lines are processed when CLXDAT is read, or at the latest at
+ * vsync while line_data and the sprite buffers of the frame are still
+ * valid. Lines that can't set any new CLXDAT bit are not recorded. */
+struct collision_line {
+	int lineno;
+	int first_sprite, nr_sprites;
+	int plfleft, plfright;
+	int diwfirst, diwlast;
+	unsigned int clxcon, bpl_enable, bpl_match;
+	uae_u8 nr_planes, bplres, dualpf, level;
+};
+static struct collision_line collision_lines[MAXVPOS + 2];
+static int collision_pending;
+
+#define COLLISION_WORDS (MAX_WORDS_PER_LINE / 2)
+/* One bit per bitplane pixel, set where the odd (0) / even (1) planes
+ * match CLXCON. Same bit order as line_data: MSB is the leftmost pixel. */
+static uae_u32 collision_pf[2][COLLISION_WORDS];
+
+static void collision_build_masks (const struct collision_line *cl, int w0, int w1)
 {
-	int bplres = bplcon0_res;
-	hwres_t ddf_left = thisline_decision.plfleft * 2 << bplres;
-	hwres_t hw_diwlast = coord_window_to_diw_x (thisline_decision.diwlastword);
-	hwres_t hw_diwfirst = coord_window_to_diw_x (thisline_decision.diwfirstword);
-	int i, collided, minpos, maxpos;
+	uae_u8 *ldata = line_data[cl->lineno];
 #ifdef AGA
 	int planes = (currprefs.chipset_mask & CSMASK_AGA) ? 8 : 6;
 #else
 	int planes = 6;
 #endif
+	int k, l, w;
 
-	if (clxcon_bpl_enable == 0) {
-		clxdat |= 1;
-		return;
-	}
-	if (clxdat & 1)
-		return;
-
-	collided = 0;
-	minpos = thisline_decision.plfleft * 2;
-	if (minpos < hw_diwfirst)
-		minpos = hw_diwfirst;
-	maxpos = thisline_decision.plfright * 2;
-	if (maxpos > hw_diwlast)
-		maxpos = hw_diwlast;
-	for (i = minpos; i < maxpos && !collided; i+= 32) {
-		int offs = ((i << bplres) - ddf_left) >> 3;
-		int j;
-		uae_u32 total = 0xffffffff;
-		for (j = 0; j < planes; j++) {
-			int ena = (clxcon_bpl_enable >> j) & 1;
-			int match = (clxcon_bpl_match >> j) & 1;
-			uae_u32 t = 0xffffffff;
-			if (ena) {
-				if (j < thisline_decision.nr_planes) {
-					t = *(uae_u32 *)(line_data[next_lineno] + offs + 2 * j * MAX_WORDS_PER_LINE);
-					t ^= (match & 1) - 1;
-				} else {
-					t = (match & 1) - 1;
+	for (k = 0; k < 2; k++) {
+		uae_u32 *m = collision_pf[k];
+		for (w = w0; w < w1; w++)
+			m[w] = 0xffffffff;
+		for (l = k; l < planes; l += 2) {
+			uae_u32 inv, *t;
+			if (!(cl->bpl_enable & (1 << l)))
+				continue;
+			inv = ((cl->bpl_match >> l) & 1) - 1;
+			if (l >= cl->nr_planes) {
+				if (!inv) {
+					for (w = w0; w < w1; w++)
+						m[w] = 0;
+					break;
 				}
+				continue;
 			}
-			total &= t;
-		}
-		if (total) {
-			collided = 1;
-#if 0
+			t = (uae_u32*)(ldata + 2 * l * MAX_WORDS_PER_LINE);
+			w = w0;
+#ifdef HAVE_SSE2_INTRINSICS
 			{
-				int k;
-				for (k = 0; k < 1; k++) {
-					uae_u32 *ldata = (uae_u32 *)(line_data[next_lineno] + offs + 2 * k * MAX_WORDS_PER_LINE);
-					*ldata ^= 0x5555555555;
+				__m128i vinv = _mm_set1_epi32 (inv);
+				for (; w + 4 <= w1; w += 4) {
+					__m128i d = _mm_xor_si128 (_mm_loadu_si128 ((__m128i*)(t + w)), vinv);
+					_mm_storeu_si128 ((__m128i*)(m + w), _mm_and_si128 (_mm_loadu_si128 ((__m128i*)(m + w)), d));
 				}
 			}
 #endif
-
+			for (; w < w1; w++)
+				m[w] &= t[w] ^ inv;
 		}
 	}
-	if (collided)
-		clxdat |= 1;
+	if (!cl->dualpf) {
+		for (w = w0; w < w1; w++)
+			collision_pf[0][w] &= collision_pf[1][w];
+	}
 }
 
-/* Sprite-to-sprite collisions are taken care of in record_sprite.  This one does
-playfield/sprite collisions. */
-static void do_sprite_collisions (void)
+/* handle very rarely needed playfield collision (CLXDAT bit 0) */
+/* only known game needing this is Rotor */
+static void do_playfield_collisions (const struct collision_line *cl)
 {
-	int nr_sprites = curr_drawinfo[next_lineno].nr_sprites;
-	int first = curr_drawinfo[next_lineno].first_sprite_entry;
-	int i;
-	unsigned int collision_mask = clxmask[clxcon >> 12];
-	int bplres = bplcon0_res;
-	hwres_t ddf_left = thisline_decision.plfleft * 2 << bplres;
-	hwres_t hw_diwlast = coord_window_to_diw_x (thisline_decision.diwlastword);
-	hwres_t hw_diwfirst = coord_window_to_diw_x (thisline_decision.diwfirstword);
+	int ddf_left = cl->plfleft * 2 << cl->bplres;
+	int minpos, maxpos, lo, hi, w, w0, w1;
 
-	if (clxcon_bpl_enable == 0) {
-		clxdat |= 0x1FE;
+	if (clxdat & 1)
+		return;
+
+	minpos = cl->plfleft * 2;
+	if (minpos < cl->diwfirst)
+		minpos = cl->diwfirst;
+	maxpos = cl->plfright * 2;
+	if (maxpos > cl->diwlast)
+		maxpos = cl->diwlast;
+	lo = (minpos << cl->bplres) - ddf_left;
+	hi = (maxpos << cl->bplres) - ddf_left;
+	if (hi > COLLISION_WORDS * 32)
+		hi = COLLISION_WORDS * 32;
+	if (lo >= hi)
 		return;
+	w0 = lo >> 5;
+	w1 = (hi + 31) >> 5;
+	collision_build_masks (cl, w0, w1);
+	for (w = w0; w < w1; w++) {
+		uae_u32 total = collision_pf[0][w] & collision_pf[1][w];
+		if (w == w0)
+			total &= 0xffffffff >> (lo & 31);
+		if (w == w1 - 1 && (hi & 31))
+			total &= ~(0xffffffff >> (hi & 31));
+		if (total) {
+			clxdat |= 1;
+			return;
+		}
 	}
+}
 
-	for (i = 0; i < nr_sprites; i++) {
-		struct sprite_entry *e = curr_sprite_entries + first + i;
+/* Sprite-to-sprite collisions are taken care of in record_sprite.  This one does
+playfield/sprite collisions. */
+static void do_sprite_collisions (const struct collision_line *cl)
+{
+	int i, built = 0;
+	unsigned int collision_mask = clxmask[cl->clxcon >> 12];
+	int bplres = cl->bplres;
+	hwres_t ddf_left = cl->plfleft * 2 << bplres;
+	hwres_t hw_diwlast = cl->diwlast;
+	hwres_t hw_diwfirst = cl->diwfirst;
+	sprbuf_res_t limit = ((COLLISION_WORDS * 32 + ddf_left) << sprite_buffer_res) >> bplres;
+
+	for (i = 0; i < cl->nr_sprites && (clxdat & 0x1fe) != 0x1fe; i++) {
+		struct sprite_entry *e = curr_sprite_entries + cl->first_sprite + i;
 		sprbuf_res_t j;
 		sprbuf_res_t minpos = e->pos;
 		sprbuf_res_t maxpos = e->max;
 		hwres_t minp1 = minpos >> sprite_buffer_res;
 		hwres_t maxp1 = maxpos >> sprite_buffer_res;
+		uae_u16 *sp;
 
 		if (maxp1 > hw_diwlast)
 			maxpos = hw_diwlast << sprite_buffer_res;
-		if (maxp1 > thisline_decision.plfright * 2)
-			maxpos = thisline_decision.plfright * 2 << sprite_buffer_res;
+		if (maxp1 > cl->plfright * 2)
+			maxpos = cl->plfright * 2 << sprite_buffer_res;
 		if (minp1 < hw_diwfirst)
 			minpos = hw_diwfirst << sprite_buffer_res;
-		if (minp1 < thisline_decision.plfleft * 2)
-			minpos = thisline_decision.plfleft * 2 << sprite_buffer_res;
+		if (minp1 < cl->plfleft * 2)
+			minpos = cl->plfleft * 2 << sprite_buffer_res;
+		if (maxpos > limit)
+			maxpos = limit;
+		if (minpos >= maxpos)
+			continue;
 
-		for (j = minpos; j < maxpos; j++) {
-			int sprpix = spixels[e->first_pixel + j - e->pos] & collision_mask;
-			int k, offs, match = 1;
+		if (!built) {
+			collision_build_masks (cl, 0, COLLISION_WORDS);
+			built = 1;
+		}
 
-			if (sprpix == 0)
+		sp = spixels + e->first_pixel - e->pos;
+		j = minpos;
+		while (j < maxpos) {
+			int sprpix, offs, bit;
+#ifdef HAVE_SSE2_INTRINSICS
+			if (j + 8 <= maxpos) {
+				__m128i v = _mm_and_si128 (_mm_loadu_si128 ((__m128i*)(sp + j)), _mm_set1_epi16 (collision_mask));
+				if (_mm_movemask_epi8 (_mm_cmpeq_epi16 (v, _mm_setzero_si128 ())) == 0xffff) {
+					j += 8;
+					continue;
+				}
+			}
+#endif
+			sprpix = sp[j] & collision_mask;
+			if (sprpix == 0) {
+				j++;
 				continue;
-
+			}
 			offs = ((j << bplres) >> sprite_buffer_res) - ddf_left;
+			bit = 31 - (offs & 31);
 			sprpix = sprite_ab_merge[sprpix & 255] | (sprite_ab_merge[sprpix >> 8] << 2);
 			sprpix <<= 1;
-
-			/* Loop over number of playfields.  */
-			for (k = 1; k >= 0; k--) {
-				int l;
-#ifdef AGA
-				int planes = (currprefs.chipset_mask & CSMASK_AGA) ? 8 : 6;
-#else
-				int planes = 6;
-#endif
-				if (bplcon0 & 0x400)
-					match = 1;
-				for (l = k; match && l < planes; l += 2) {
-					int t = 0;
-					if (l < thisline_decision.nr_planes) {
-						uae_u32 *ldata = (uae_u32 *)(line_data[next_lineno] + 2 * l * MAX_WORDS_PER_LINE);
-						uae_u32 word = ldata[offs >> 5];
-						t = (word >> (31 - (offs & 31))) & 1;
-#if 0 /* debug: draw collision mask */
-						if (1) {
-							int m;
-							for (m = 0; m < 5; m++) {
-								ldata = (uae_u32 *)(line_data[next_lineno] + 2 * m * MAX_WORDS_PER_LINE);
-								ldata[(offs >> 5) + 1] |= 15 << (31 - (offs & 31));
-							}
-						}
-#endif
-					}
-					if (clxcon_bpl_enable & (1 << l)) {
-						if (t != ((clxcon_bpl_match >> l) & 1))
-							match = 0;
-					}
-				}
-				if (match) {
-#if 0 /* debug: mark lines where collisions are detected */
-					if (0) {
-						int l;
-						for (l = 0; l < 5; l++) {
-							uae_u32 *ldata = (uae_u32 *)(line_data[next_lineno] + 2 * l * MAX_WORDS_PER_LINE);
-							ldata[(offs >> 5) + 1] |= 15 << (31 - (offs & 31));
-						}
-					}
-#endif
-					clxdat |= sprpix << (k * 4);
-				}
-			}
+			if ((collision_pf[1][offs >> 5] >> bit) & 1)
+				clxdat |= sprpix << 4;
+			if ((collision_pf[0][offs >> 5] >> bit) & 1)
+				clxdat |= sprpix;
+			j++;
 		}
 	}
-#if 0
-	{
-		static int olx;
-		if (clxdat != olx)
-			write_log (L"%d: %04X\n", vpos, clxdat);
-		olx = clxdat;
+}
+
+static void collision_flush (void)
+{
+	int i;
+
+	for (i = 0; i < collision_pending; i++) {
+		struct collision_line *cl = &collision_lines[i];
+		if (cl->level > 1 && cl->nr_sprites)
+			do_sprite_collisions (cl);
+		if (cl->level > 2)
+			do_playfield_collisions (cl);
 	}
-#endif
+	collision_pending = 0;
+}
+
+static void collision_record_line (void)
+{
+	struct collision_line *cl;
+	int level = currprefs.collision_level;
+	int nr_sprites = curr_drawinfo[next_lineno].nr_sprites;
+	int need = 0;
+
+	if (clxcon_bpl_enable == 0) {
+		clxdat |= 0x1FE;
+		if (level > 2)
+			clxdat |= 1;
+		return;
+	}
+	if (nr_sprites && (clxdat & 0x1fe) != 0x1fe && clxmask[clxcon >> 12])
+		need = 1;
+	if (level > 2 && !(clxdat & 1))
+		need = 1;
+	if (!need)
+		return;
+	if (collision_pending >= (int)(sizeof collision_lines / sizeof *collision_lines))
+		collision_flush ();
+	cl = &collision_lines[collision_pending++];
+	cl->lineno = next_lineno;
+	cl->first_sprite = curr_drawinfo[next_lineno].first_sprite_entry;
+	cl->nr_sprites = nr_sprites;
+	cl->plfleft = thisline_decision.plfleft;
+	cl->plfright = thisline_decision.plfright;
+	cl->diwfirst = coord_window_to_diw_x (thisline_decision.diwfirstword);
+	cl->diwlast = coord_window_to_diw_x (thisline_decision.diwlastword);
+	cl->clxcon = clxcon;
+	cl->bpl_enable = clxcon_bpl_enable;
+	cl->bpl_match = clxcon_bpl_match;
+	cl->nr_planes = thisline_decision.nr_planes;
+	cl->bplres = bplcon0_res;
+	cl->dualpf = (bplcon0 & 0x400) != 0;
+	cl->level = level;
 }
 
 STATIC_INLINE void record_sprite_1 (int sprxp, uae_u16 *buf, uae_u32 datab, int num, int dbl,
@@ -3160,6 +3279,11 @@ static int test_copper_dangerous (unsigned int address)
 	return 0;
 }
 
+void copper_stats (void)
+{
+	console_out_f (L"WAIT wake-up events %I64u\n", copper_wait_sleeps);
+}
+
 static void immediate_copper (int num)
 {
 	int pos = 0;
@@ -3237,6 +3361,7 @@ static void COPJMP (int num, int vblank)
 #endif
 
 	unset_special (SPCFLAG_COPPER);
+	event2_remevent (ev2_copper);
 	cop_state.ignore_next = 0;
 	if (!oldstrobe)
 		cop_state.state_prev = cop_state.state;
@@ -3313,49 +3438,200 @@ static void DMACON (int hpos, uae_u16 v)
 }
 
 
+/* Pending eventtab2 events are kept in a binary min-heap ordered by
+   evtime (insertion order for equal times), ev_misc is always set to
+   the top of the heap. Events without fixed slot are allocated from
+   a free list that grows when needed.  */
+
+static struct ev2 **ev2_heap;
+static int ev2_heapsize, ev2_heapmax;
+static struct ev2 *ev2_freelist;
+static unsigned int ev2_seq;
+static int misc_recursive;
+
+STATIC_INLINE bool ev2_before (struct ev2 *a, struct ev2 *b)
+{
+	long d = (long)(a->evtime - b->evtime);
+	return d < 0 || (d == 0 && (int)(a->seq - b->seq) < 0);
+}
+
+static void ev2_heap_set (int i, struct ev2 *e)
+{
+	ev2_heap[i] = e;
+	e->heapidx = i;
+}
+
+static void ev2_heap_up (int i)
+{
+	struct ev2 *e = ev2_heap[i];
+	while (i > 0) {
+		int p = (i - 1) / 2;
+		if (!ev2_before (e, ev2_heap[p]))
+			break;
+		ev2_heap_set (i, ev2_heap[p]);
+		i = p;
+	}
+	ev2_heap_set (i, e);
+}
+
+static void ev2_heap_down (int i)
+{
+	struct ev2 *e = ev2_heap[i];
+	for (;;) {
+		int c = i * 2 + 1;
+		if (c >= ev2_heapsize)
+			break;
+		if (c + 1 < ev2_heapsize && ev2_before (ev2_heap[c + 1], ev2_heap[c]))
+			c++;
+		if (!ev2_before (ev2_heap[c], e))
+			break;
+		ev2_heap_set (i, ev2_heap[c]);
+		i = c;
+	}
+	ev2_heap_set (i, e);
+}
+
+static void ev2_heap_insert (struct ev2 *e)
+{
+	if (ev2_heapsize >= ev2_heapmax) {
+		ev2_heapmax = ev2_heapmax ? ev2_heapmax * 2 : 32;
+		ev2_heap = xrealloc (struct ev2*, ev2_heap, ev2_heapmax);
+	}
+	ev2_heap_set (ev2_heapsize++, e);
+	ev2_heap_up (e->heapidx);
+}
+
+static void ev2_heap_remove (struct ev2 *e)
+{
+	int i = e->heapidx;
+	struct ev2 *last = ev2_heap[--ev2_heapsize];
+
+	e->heapidx = -1;
+	if (last == e)
+		return;
+	ev2_heap_set (i, last);
+	if (i > 0 && ev2_before (last, ev2_heap[(i - 1) / 2]))
+		ev2_heap_up (i);
+	else
+		ev2_heap_down (i);
+}
+
+static struct ev2 *ev2_alloc (void)
+{
+	struct ev2 *e = ev2_freelist;
+
+	if (!e) {
+		int i;
+		e = xcalloc (struct ev2, 32);
+		for (i = 0; i < 32; i++) {
+			e[i].dynamic = true;
+			e[i].heapidx = -1;
+			e[i].next = i < 31 ? &e[i + 1] : NULL;
+		}
+	}
+	ev2_freelist = e->next;
+	return e;
+}
+
+static void ev2_release (struct ev2 *e)
+{
+	e->active = false;
+	if (e->heapidx >= 0)
+		ev2_heap_remove (e);
+	if (e->dynamic) {
+		e->next = ev2_freelist;
+		ev2_freelist = e;
+	}
+}
+
+void event2_newevent_xx (int no, evt t, uae_u32 data, evfunc2 func)
+{
+	struct ev2 *e;
+
+	if (no < 0) {
+		e = ev2_alloc ();
+	} else {
+		e = &eventtab2[no];
+		if (e->heapidx >= 0)
+			ev2_heap_remove (e);
+	}
+	e->active = true;
+	e->evtime = t + get_cycles ();
+	e->handler = func;
+	e->data = data;
+	e->seq = ev2_seq++;
+	ev2_heap_insert (e);
+	if (e->heapidx == 0)
+		MISC_handler ();
+}
+
+void event2_remevent (int no)
+{
+	struct ev2 *e = &eventtab2[no];
+
+	e->active = false;
+	if (e->heapidx >= 0)
+		ev2_heap_remove (e);
+}
+
 void MISC_handler (void)
 {
-	static bool dorecheck;
-	bool recheck;
-	int i;
-	evt mintime;
 	evt ct = get_cycles ();
-	static int recursive;
 
-	if (recursive) {
-		dorecheck = true;
+	if (misc_recursive)
 		return;
-	}
-	recursive++;
+	misc_recursive++;
 	eventtab[ev_misc].active = 0;
-	recheck = true;
-	while (recheck) {
-		recheck = false;
-		mintime = ~0L;
-		for (i = 0; i < ev2_max; i++) {
-			if (eventtab2[i].active) {
-				if (eventtab2[i].evtime == ct) {
-					eventtab2[i].active = false;
-					eventtab2[i].handler (eventtab2[i].data);
-					if (dorecheck || eventtab2[i].active) {
-						recheck = true;
-						dorecheck = false;
-					}
-				} else {
-					evt eventtime = eventtab2[i].evtime - ct;
-					if (eventtime < mintime)
-						mintime = eventtime;
-				}
-			}
-		}
-	}
-	if (mintime != ~0L) {
+	while (ev2_heapsize > 0 && (long)(ev2_heap[0]->evtime - ct) <= 0) {
+		struct ev2 *e = ev2_heap[0];
+		evfunc2 handler = e->handler;
+		uae_u32 data = e->data;
+		ev2_release (e);
+		handler (data);
+	}
+	if (ev2_heapsize > 0) {
 		eventtab[ev_misc].active = true;
 		eventtab[ev_misc].oldcycles = ct;
-		eventtab[ev_misc].evtime = ct + mintime;
+		eventtab[ev_misc].evtime = ev2_heap[0]->evtime;
 		events_schedule ();
 	}
-	recursive--;
+	misc_recursive--;
+}
+
+static int event_dump_cmp (const void *a, const void *b)
+{
+	struct ev2 *e1 = *(struct ev2**)a;
+	struct ev2 *e2 = *(struct ev2**)b;
+	return ev2_before (e1, e2) ? -1 : (ev2_before (e2, e1) ? 1 : 0);
+}
+
+void event_dump (void)
+{
+	static const TCHAR *evnames[ev_max] = { L"CIA", L"audio", L"misc", L"hsync" };
+	static const TCHAR *ev2names[ev2_max] = { L"blitter", L"disk", L"copper" };
+	evt ct = get_cycles ();
+	int i;
+
+	console_out_f (L"Cycle %08X, next event in %d\n", ct, (int)(nextevent - ct) / CYCLE_UNIT);
+	for (i = 0; i < ev_max; i++) {
+		struct ev *e = &eventtab[i];
+		if (e->active)
+			console_out_f (L"%-8s %8d\n", evnames[i], (int)(e->evtime - ct) / CYCLE_UNIT);
+		else
+			console_out_f (L"%-8s inactive\n", evnames[i]);
+	}
+	if (ev2_heapsize > 0) {
+		struct ev2 **list = xmalloc (struct ev2*, ev2_heapsize);
+		memcpy (list, ev2_heap, ev2_heapsize * sizeof (struct ev2*));
+		qsort (list, ev2_heapsize, sizeof (struct ev2*), event_dump_cmp);
+		for (i = 0; i < ev2_heapsize; i++) {
+			struct ev2 *e = list[i];
+			const TCHAR *name = e->dynamic ? L"-" : ev2names[e - eventtab2];
+			console_out_f (L"%-8s %8d %p %08X\n", name, (int)(e->evtime - ct) / CYCLE_UNIT, e->handler, e->data);
+		}
+		xfree (list);
+	}
+	console_out_f (L"%d pending event2's\n", ev2_heapsize);
 }
 
 static int irq_nmi;
@@ -4090,7 +4366,10 @@ static void CLXCON2 (uae_u16 v)
 
 static uae_u16 CLXDAT (void)
 {
-	uae_u16 v = clxdat | 0x8000;
+	uae_u16 v;
+
+	collision_flush ();
+	v = clxdat | 0x8000;
 	clxdat = 0;
 	return v;
 }
@@ -4293,6 +4572,47 @@ static void copper_write (uae_u32 v)
 	custom_wput_copper (current_hpos (), v >> 16, v & 0xffff, 0);
 }
 
+/* First copper slot (old_hpos) of this line where the horizontal part
+   of the current WAIT matches, -1 if it does not happen before the end
+   of the line. Steps c_hpos exactly like update_copper () does.  */
+static int copper_wait_wakeup (int c_hpos)
+{
+	unsigned int mask = cop_state.saved_i2 & 0xfe;
+
+	while (c_hpos < (maxhpos & ~1)) {
+		int next = ((c_hpos == maxhpos - 3) && (maxhpos & 1)) ? c_hpos + 1 : c_hpos + 2;
+		if ((next & mask) >= cop_state.hcmp)
+			return c_hpos;
+		c_hpos = next;
+	}
+	return -1;
+}
+
+static void copper_wakeup_handler (uae_u32 v)
+{
+	if (cop_state.state != COP_wait || vpos != v || !dmaen (DMA_COPPER))
+		return;
+	copper_enabled_thisline = 1;
+	set_special (SPCFLAG_COPPER);
+}
+
+/* Copper WAIT can't end before slot wake, stop stepping it and
+   schedule a single wake-up event for that slot. New line restarts
+   the copper through compute_spcflag_copper ().  */
+static void copper_wait_sleep (int c_hpos, int wake)
+{
+	copper_enabled_thisline = 0;
+	unset_special (SPCFLAG_COPPER);
+	copper_wait_sleeps++;
+	if (wake < 0) {
+		cop_state.hpos = c_hpos;
+		event2_remevent (ev2_copper);
+		return;
+	}
+	cop_state.hpos = wake;
+	event2_newevent (ev2_copper, wake - current_hpos (), vpos);
+}
+
 static void update_copper (int until_hpos)
 {
 	int vp = vpos & (((cop_state.saved_i2 >> 8) & 0x7F) | 0x80);
@@ -4523,8 +4843,18 @@ static void update_copper (int until_hpos)
 				continue;
 
 			hp = c_hpos & (cop_state.saved_i2 & 0xFE);
-			if (vp == cop_state.vcmp && hp < cop_state.hcmp)
+			if (vp == cop_state.vcmp && hp < cop_state.hcmp) {
+				/* nothing to do until the beam gets there */
+				if (cop_state.movedelay == 0) {
+					int wake = copper_wait_wakeup (c_hpos);
+					if (wake < 0 || wake >= until_hpos) {
+						copper_wait_sleep (c_hpos, wake);
+						last_copper_hpos = until_hpos;
+						return;
+					}
+				}
 				break;
+			}
 
 			/* Now we know that the comparisons were successful.  We might still
 			have to wait for the blitter though.  */
@@ -4592,6 +4922,7 @@ static void compute_spcflag_copper (int hpos)
 
 	copper_enabled_thisline = 0;
 	unset_special (SPCFLAG_COPPER);
+	event2_remevent (ev2_copper);
 	if (!dmaen (DMA_COPPER) || cop_state.state == COP_stop || cop_state.state == COP_bltwait || nocustom ())
 		return;
 
@@ -5048,6 +5379,8 @@ static void fpscounter (void)
 // vsync functions that are not hardware timing related
 static void vsync_handler_pre (void)
 {
+	collision_flush ();
+
 	if (bogusframe > 0)
 		bogusframe--;
 
@@ -5409,12 +5742,8 @@ static void hsync_handler_pre (bool isvsync)
 	if (!nocustom ()) {
 		sync_copper_with_cpu (maxhpos, 0);
 		finish_decisions ();
-		if (thisline_decision.plfleft != -1) {
-			if (currprefs.collision_level > 1)
-				do_sprite_collisions ();
-			if (currprefs.collision_level > 2)
-				do_playfield_collisions ();
-		}
+		if (thisline_decision.plfleft != -1 && currprefs.collision_level > 1)
+			collision_record_line ();
 		hsync_record_line_state (next_lineno, nextline_how, thisline_changed);
 		/* reset light pen latch */
 		if (vpos == sprite_vblank_endline) {
@@ -5487,7 +5816,7 @@ static void hsync_handler_post (bool isvsync)
 	last_copper_hpos = 0;
 #ifdef CPUEMU_12
 	if (currprefs.cpu_cycle_exact || currprefs.blitter_cycle_exact) {
-		memset (cycle_line, 0, sizeof cycle_line);
+		cycle_line_clear ();
 	}
 #endif
 
@@ -5728,8 +6057,11 @@ void init_eventtab (void)
 		eventtab[i].active = 0;
 		eventtab[i].oldcycles = get_cycles ();
 	}
+	while (ev2_heapsize > 0)
+		ev2_release (ev2_heap[0]);
 	for (i = 0; i < ev2_max; i++) {
 		eventtab2[i].active = 0;
+		eventtab2[i].heapidx = -1;
 	}
 
 	eventtab[ev_cia].handler = CIA_handler;
@@ -5741,6 +6073,7 @@ void init_eventtab (void)
 
 	eventtab2[ev2_blitter].handler = blitter_handler;
 	eventtab2[ev2_disk].handler = DISK_handler;
+	eventtab2[ev2_copper].handler = copper_wakeup_handler;
 
 	events_schedule ();
 }
@@ -5785,6 +6118,7 @@ void custom_reset (int hardreset)
 		}
 
 		clxdat = 0;
+		collision_pending = 0;
 
 		/* Clear the armed flags of all sprites.  */
 		memset (spr, 0, sizeof spr);
@@ -6473,14 +6807,23 @@ static void REGPARAM2 custom_lput(uaecptr addr, uae_u32 value)
 
 void custom_prepare_savestate (void)
 {
-	int i;
+	int i, cnt = ev2_heapsize;
+	struct ev2 **list;
 
-	for (i = 0; i < ev2_max; i++) {
-		if (eventtab2[i].active) {
-			eventtab2[i].active = 0;
-			eventtab2[i].handler (eventtab2[i].data);
-		}
+	if (!cnt)
+		return;
+	/* run all currently pending events now, new ones stay pending */
+	list = xmalloc (struct ev2*, cnt);
+	memcpy (list, ev2_heap, cnt * sizeof (struct ev2*));
+	qsort (list, cnt, sizeof (struct ev2*), event_dump_cmp);
+	for (i = 0; i < cnt; i++) {
+		struct ev2 *e = list[i];
+		evfunc2 handler = e->handler;
+		uae_u32 data = e->data;
+		ev2_release (e);
+		handler (data);
 	}
+	xfree (list);
 }
 
 #define RB restore_u8 ()
@@ -6507,6 +6850,7 @@ uae_u8 *restore_custom (uae_u8 *src)
 	JOYSET(0, RW);			/* 00A JOY0DAT */
 	JOYSET(1, RW);			/* 00C JOY1DAT */
 	clxdat = RW;			/* 00E CLXDAT */
+	collision_pending = 0;
 	RW;						/* 010 ADKCONR */
 	RW;						/* 012 POT0DAT* */
 	RW;						/* 014 POT1DAT* */
@@ -6662,6 +7006,7 @@ uae_u8 *save_custom (int *len, uae_u8 *dstptr, int full)
 	SW (0);					/* 008 DSKDATR */
 	SW (JOYGET (0));		/* 00A JOY0DAT */
 	SW (JOYGET (1));		/* 00C JOY1DAT */
+	collision_flush ();
 	SW (clxdat | 0x8000);	/* 00E CLXDAT */
 	SW (ADKCONR ());		/* 010 ADKCONR */
 	SW (POT0DAT ());		/* 012 POT0DAT */
@@ -7005,9 +7350,9 @@ uae_u8 *save_custom_event_delay (int *len, uae_u8 *dstptr)
 	uae_u8 *dstbak, *dst;
 	int cnt = 0;
 
-	for (int i = ev2_misc;  i < ev2_max; i++) {
-		struct ev2 *e = &eventtab2[i];
-		if (e->active && e->handler == send_interrupt_do) {
+	for (int i = 0; i < ev2_heapsize; i++) {
+		struct ev2 *e = ev2_heap[i];
+		if (e->dynamic && e->handler == send_interrupt_do) {
 			cnt++;
 		}
 	}
@@ -7021,9 +7366,9 @@ uae_u8 *save_custom_event_delay (int *len, uae_u8 *dstptr)
 
 	save_u32 (1);
 	save_u8 (cnt);
-	for (int i = ev2_misc;  i < ev2_max; i++) {
-		struct ev2 *e = &eventtab2[i];
-		if (e->active && e->handler == send_interrupt_do) {
+	for (int i = 0; i < ev2_heapsize; i++) {
+		struct ev2 *e = ev2_heap[i];
+		if (e->dynamic && e->handler == send_interrupt_do) {
 			save_u8 (1);
 			save_u64 (e->evtime - get_cycles ());
 			save_u32 (e->data);
@@ -7070,6 +7415,7 @@ void check_prefs_changed_custom (void)
 	if (!config_changed)
 		return;
 	currprefs.gfx_framerate = changed_prefs.gfx_framerate;
+	currprefs.gfx_render_threads = changed_prefs.gfx_render_threads;
 	if (currprefs.turbo_emulation != changed_prefs.turbo_emulation)
 		warpmode (changed_prefs.turbo_emulation);
 	if (inputdevice_config_change_test ()) 
@@ -7167,9 +7513,19 @@ STATIC_INLINE int dma_cycle (void)
 			alloc_cycle (hpos_old, CYCLE_CPU);
 			break;
 		}
+		/* bus was allocated to dma channel, wait for next cycle.. */
+		if (bltstate == BLT_done && !copper_enabled_thisline) {
+			/* nothing else can take or give away slots that are already
+			   allocated, skip over all of them at once */
+			int n = cycle_line_next_free (hpos) - hpos_old;
+			if (n > 1 && hpos_old + n < maxhpos - 1) {
+				regs.ce020memcycles -= n * CYCLE_UNIT;
+				do_cycles (n * CYCLE_UNIT);
+				continue;
+			}
+		}
 		regs.ce020memcycles -= CYCLE_UNIT;
 		do_cycles (1 * CYCLE_UNIT);
-		/* bus was allocated to dma channel, wait for next cycle.. */
 	}
 	return hpos_old;
 }
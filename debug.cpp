@@ -16,6 +16,7 @@
 
 #include "options.h"
 #include "uae.h"
+#include "events.h"
 #include "memory.h"
 #include "custom.h"
 #include "newcpu.h"
@@ -109,12 +110,14 @@ static TCHAR help[] = {
 	L"  fs <val> <mask>       Break when (SR & mask) = val.\n"                   
 	L"  f <addr1> <addr2>     Step forward until <addr1> <= PC <= <addr2>.\n"
 	L"  e                     Dump contents of all custom registers, ea = AGA colors.\n"
+	L"  ev                    Show pending events.\n"
 	L"  i [<addr>]            Dump contents of interrupt and trap vectors.\n"
 	L"  il [<mask>]           Exception breakpoint.\n"
 	L"  o <0-2|addr> [<lines>]View memory as Copper instructions.\n"
 	L"  od                    Enable/disable Copper vpos/hpos tracing.\n"
 	L"  ot                    Copper single step trace.\n"
 	L"  ob <addr>             Copper breakpoint.\n"
+	L"  oc                    Show Copper WAIT wake-up statistics.\n"
 	L"  H[H] <cnt>            Show PC history (HH=full CPU info) <cnt> instructions.\n"
 	L"  C <value>             Search for values like energy or lifes in games.\n"
 	L"  Cl                    List currently found trainer addresses.\n"
@@ -138,6 +141,11 @@ static TCHAR help[] = {
 	L"  dj [<level bitmask>]  Enable joystick/mouse input debugging.\n"
 	L"  smc [<0-1>]           Enable self-modifying code detector. 1 = enable break.\n"
 	L"  dm                    Dump current address space map.\n"
+	L"  dmt                   Show MMU host TLB state.\n"
+	L"  dc                    Show CPU decode and JIT cache statistics.\n"
+	L"  dl                    Show drawn/skipped line statistics.\n"
+	L"  dp [<file>]           Start/stop instruction pair profiling. Profile is written to\n"
+	L"                        <file> (default frequent_pairs.68k) for gencpu fused handlers.\n"
 	L"  v <vpos> [<hpos>]     Show DMA data (accurate only in cycle-exact mode).\n"
 	L"                        v [-1 to -4] = enable visual DMA debugger.\n"
 	L"  ?<value>              Hex/Bin/Dec converter.\n"
@@ -1138,6 +1146,9 @@ static int copper_debugger (TCHAR **c)
 		else
 			debug_copper = 1;
 		console_out_f (L"Copper debugger %s.\n", debug_copper ? L"enabled" : L"disabled");
+	} else if (**c == 'c' && ((*c)[1] == 0 || (*c)[1] == ' ')) {
+		/* "oc" only, "oc00000" is an address */
+		copper_stats ();
 	} else if (**c == 't') {
 		debug_copper = 1|2;
 		return 1;
@@ -2083,6 +2094,9 @@ static int deinitialize_memwatch (void)
 	for (i = 0; membank_stores[i].addr; i++) {
 		memcpy (membank_stores[i].addr, &membank_stores[i].store, sizeof (addrbank));
 	}
+#ifdef FULLMMU
+	mmu_set_host_tlb (true);
+#endif
 	oldmode = mmu_enabled ? 1 : 0;
 	xfree (debug_mem_banks);
 	debug_mem_banks = NULL;
@@ -2136,6 +2150,10 @@ static void initialize_memwatch (int mode)
 		a2->wgeti = mode ? mmu_wgeti : debug_wgeti;
 		a2->lgeti = mode ? mmu_lgeti : debug_lgeti;
 	}
+#ifdef FULLMMU
+	/* memwatch handlers must see every access */
+	mmu_set_host_tlb (false);
+#endif
 	if (mode)
 		mmu_enabled = 1;
 	else
@@ -3254,7 +3272,12 @@ static BOOL debug_line (TCHAR *input)
 			}
 			break;
 		}
-		case 'e': dump_custom_regs (tolower(*inptr) == 'a'); break;
+		case 'e':
+			if (*inptr == 'v')
+				event_dump ();
+			else
+				dump_custom_regs (tolower(*inptr) == 'a');
+			break;
 		case 'r':
 			{
 				if (more_params(&inptr))
@@ -3299,7 +3322,27 @@ static BOOL debug_line (TCHAR *input)
 						inputdevice_logging = readint (&inptr);
 					console_out_f (L"Input logging level %d\n", inputdevice_logging);
 				} else if (*inptr == 'm') {
-					memory_map_dump_2 (0);
+#ifdef FULLMMU
+					if (inptr[1] == 't')
+						mmu_tlb_stats ();
+					else
+#endif
+						memory_map_dump_2 (0);
+				} else if (*inptr == 'c' && (inptr[1] == 0 || inptr[1] == ' ')) {
+					/* "dc" only, "dc00000" is disassembly */
+					decodecache_stats ();
+				} else if (*inptr == 'l') {
+					drawing_line_stats ();
+				} else if (*inptr == 'p') {
+					TCHAR name[MAX_DPATH];
+					next_char (&inptr);
+					name[0] = 0;
+					if (more_params (&inptr))
+						next_string (&inptr, name, sizeof name / sizeof (TCHAR), 0);
+					if (pairprofile_set (name))
+						console_out (L"Instruction pair profiling started.\n");
+					else
+						console_out (L"Instruction pair profiling stopped.\n");
 				} else if (*inptr == 't') {
 					next_char (&inptr);
 					debugtest_set (&inptr);
@@ -50,6 +50,15 @@ happening, all ports should restrict window widths to be multiples of 16 pixels.
 #include "inputdevice.h"
 #include "debug.h"
 
+/* Line drawing state. Each render thread has its own copy.  */
+#ifndef RENDER_THREADS
+#define DRAW_TLS
+#elif defined(_MSC_VER)
+#define DRAW_TLS __declspec(thread)
+#else
+#define DRAW_TLS __thread
+#endif
+
 extern int sprite_buffer_res;
 int lores_factor, lores_shift;
 
@@ -76,13 +85,14 @@ bool direct_rgb;
 coordinates.  Zero if the resolution is the same, positive if window coordinates
 have a higher resolution (i.e. we're stretching the image), negative if window
 coordinates have a lower resolution (i.e. we're shrinking the image).  */
-static int res_shift;
+static DRAW_TLS int res_shift;
 
 static int linedbl, linedbld;
 
 int interlace_seen = 0;
 #define AUTO_LORES_FRAMES 10
-static int can_use_lores = 0, frame_res, frame_res_lace, last_max_ypos;
+static DRAW_TLS int can_use_lores = 0, frame_res, frame_res_lace;
+static int last_max_ypos;
 
 /* Lookup tables for dual playfields.  The dblpf_*1 versions are for the case
 that playfield 1 has the priority, dbplpf_*2 are used if playfield 2 has
@@ -116,27 +126,27 @@ struct spritepixelsbuf {
 	uae_u8 stdata;
 	uae_u16 data;
 };
-static struct spritepixelsbuf spritepixels[MAX_PIXELS_PER_LINE];
-static int sprite_first_x, sprite_last_x;
+static DRAW_TLS struct spritepixelsbuf spritepixels[MAX_PIXELS_PER_LINE];
+static DRAW_TLS int sprite_first_x, sprite_last_x;
 
 #ifdef AGA
 /* AGA mode color lookup tables */
 unsigned int xredcolors[256], xgreencolors[256], xbluecolors[256];
 static int dblpf_ind1_aga[256], dblpf_ind2_aga[256];
 #else
-static uae_u8 spriteagadpfpixels[1];
+static DRAW_TLS uae_u8 spriteagadpfpixels[1];
 static int dblpf_ind1_aga[1], dblpf_ind2_aga[1];
 #endif
 int xredcolor_s, xredcolor_b, xredcolor_m;
 int xgreencolor_s, xgreencolor_b, xgreencolor_m;
 int xbluecolor_s, xbluecolor_b, xbluecolor_m;
 
-struct color_entry colors_for_drawing;
+static DRAW_TLS struct color_entry colors_for_drawing;
 
 /* The size of these arrays is pretty arbitrary; it was chosen to be "more
 than enough".  The coordinates used for indexing into these arrays are
 almost, but not quite, Amiga coordinates (there's a constant offset).  */
-union {
+static DRAW_TLS union {
 	/* Let's try to align this thing. */
 	double uupzuq;
 	long int cruxmedo;
@@ -154,13 +164,15 @@ uae_u16 spixels[2 * MAX_SPR_PIXELS];
 /* Eight bits for every pixel.  */
 union sps_union spixstate;
 
-static uae_u32 ham_linebuf[MAX_PIXELS_PER_LINE * 2];
-static uae_u8 *real_bplpt[8];
+static DRAW_TLS uae_u32 ham_linebuf[MAX_PIXELS_PER_LINE * 2];
+static DRAW_TLS uae_u8 *real_bplpt[8];
 
 static uae_u8 all_ones[MAX_PIXELS_PER_LINE];
 static uae_u8 all_zeros[MAX_PIXELS_PER_LINE];
 
-uae_u8 *xlinebuffer;
+static DRAW_TLS uae_u8 *xlinebuffer;
+/* render threads can't share gfxvidinfo.emergmem */
+static DRAW_TLS uae_u8 *line_emergmem;
 
 static int *amiga2aspect_line_map, *native2amiga_line_map;
 static uae_u8 *row_map[MAX_VIDHEIGHT + 1];
@@ -207,12 +219,13 @@ static int first_block_line, last_block_line;
 /* These are generated by the drawing code from the line_decisions array for
 each line that needs to be drawn.  These are basically extracted out of
 bit fields in the hardware registers.  */
-static int bplehb, bplham, bpldualpf, bpldualpfpri, bpldualpf2of, bplplanecnt, ecsshres, issprites;
-static int bplres;
-static int plf1pri, plf2pri, bplxor;
-static uae_u32 plf_sprite_mask;
-static int sbasecol[2] = { 16, 16 };
-static int brdsprt, brdblank, brdblank_changed, hposblank;
+static DRAW_TLS int bplehb, bplham, bpldualpf, bpldualpfpri, bpldualpf2of, bplplanecnt, ecsshres, issprites;
+static DRAW_TLS int bplres;
+static DRAW_TLS int plf1pri, plf2pri, bplxor;
+static DRAW_TLS uae_u32 plf_sprite_mask;
+static DRAW_TLS int sbasecol[2] = { 16, 16 };
+static DRAW_TLS int brdsprt, brdblank, hposblank;
+static int brdblank_changed;
 
 bool picasso_requested_on;
 bool picasso_on;
@@ -223,6 +236,7 @@ int inhibit_frame;
 int framecnt = 0;
 static int frame_redraw_necessary;
 static int picasso_redraw_necessary;
+static int lightpen_y1, lightpen_y2;
 
 #ifdef XLINECHECK
 static void xlinecheck (unsigned int start, unsigned int end)
@@ -527,8 +541,8 @@ void get_custom_mouse_limits (int *pw, int *ph, int *pdx, int *pdy, int dbl)
 	*pdx = dx; *pdy = dy;
 }
 
-static struct decision *dp_for_drawing;
-static struct draw_info *dip_for_drawing;
+static DRAW_TLS struct decision *dp_for_drawing;
+static DRAW_TLS struct draw_info *dip_for_drawing;
 
 /* Record DIW of the current line for use by centering code.  */
 void record_diw_line (int plfstrt, int first, int last)
@@ -552,16 +566,16 @@ void record_diw_line (int plfstrt, int first, int last)
 where do we start drawing the playfield, where do we start drawing the right border.
 All of these are forced into the visible window (VISIBLE_LEFT_BORDER .. VISIBLE_RIGHT_BORDER).
 PLAYFIELD_START and PLAYFIELD_END are in window coordinates.  */
-static int playfield_start, playfield_end;
-static int real_playfield_start, real_playfield_end;
-static int linetoscr_diw_start, linetoscr_diw_end;
-static int native_ddf_left, native_ddf_right;
+static DRAW_TLS int playfield_start, playfield_end;
+static DRAW_TLS int real_playfield_start, real_playfield_end;
+static DRAW_TLS int linetoscr_diw_start, linetoscr_diw_end;
+static DRAW_TLS int native_ddf_left, native_ddf_right;
 
-static int pixels_offset;
-static int src_pixel, ham_src_pixel;
+static DRAW_TLS int pixels_offset;
+static DRAW_TLS int src_pixel, ham_src_pixel;
 /* How many pixels in window coordinates which are to the left of the left border.  */
-static int unpainted;
-static int seen_sprites;
+static DRAW_TLS int unpainted;
+static DRAW_TLS int seen_sprites;
 
 /* Initialize the variables necessary for drawing a line.
 * This involves setting up start/stop positions and display window
@@ -865,6 +879,23 @@ STATIC_INLINE uae_u8 render_sprites (int pos, int dualpf, uae_u8 apixel, int aga
 	return 0;
 }
 
+#ifdef HAVE_SSE2_INTRINSICS
+#include <emmintrin.h>
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+#endif
+#endif
+
+/* genlinetoscr emits SSE2/AVX2 variants of each linetoscr function,
+   linetoscr_simd selects them at run time. */
+#if defined (HAVE_SSE2_INTRINSICS) && !defined (WORDS_BIGENDIAN)
+#define LINETOSCR_SIMD
+#ifdef HAVE_AVX2_INTRINSICS
+#define LINETOSCR_SIMD_AVX2
+#endif
+#endif
+static int linetoscr_simd;
+
 #include "linetoscr.cpp"
 
 #ifdef ECS_DENISE
@@ -1303,8 +1334,8 @@ static void dummy_worker (int start, int stop)
 {
 }
 
-static int ham_decode_pixel;
-static unsigned int ham_lastcolor;
+static DRAW_TLS int ham_decode_pixel;
+static DRAW_TLS unsigned int ham_lastcolor;
 
 /* Decode HAM in the invisible portion of the display (left of VISIBLE_LEFT_BORDER),
  * but don't draw anything in.  This is done to prepare HAM_LASTCOLOR for later,
@@ -1369,10 +1400,190 @@ static void init_ham_decoding (void)
 	}
 }
 
+#ifdef HAVE_SSE2_INTRINSICS
+
+/* HAM decoding as a prefix scan. Each pixel is a (mask, value) pair and
+   color = (previous & ~mask) | value. Pairs combine associatively,
+   (m1,v1) followed by (m2,v2) is (m1 | m2, (v1 & ~m2) | v2), so a vector
+   of pixels is resolved with log2(lanes) shift and combine steps and
+   only the last color is carried to the next vector. */
+
+struct ham_scan {
+	int ctlshift, ctlmask;	/* control bits, 0 = palette */
+	int setshift;			/* palette index = pv >> setshift */
+	int datamask;
+	int xormask;
+	uae_u32 mask[4], shift[4];
+	const uae_u32 *regs32;
+	const uae_u16 *regs16;
+};
+
+static int ham_simd;
+
+static void ham_scan_setup (struct ham_scan *hs)
+{
+	static const uae_u32 ham8_mask[4] = { 0xffffffff, 0xff0000fc, 0xfffc0000, 0xff00fc00 };
+	static const uae_u32 ham8_shift[4] = { 0, 0, 16, 8 };
+	static const uae_u32 ham6aga_mask[4] = { 0xffffffff, 0xff0000ff, 0xffff0000, 0xff00ff00 };
+	static const uae_u32 ham6aga_shift[4] = { 0, 4, 20, 12 };
+	static const uae_u32 ham6_mask[4] = { 0xffffffff, 0xfffff00f, 0xffffff00, 0xfffff0f0 };
+	static const uae_u32 ham6_shift[4] = { 0, 0, 8, 4 };
+	const uae_u32 *mask = ham6_mask, *shift = ham6_shift;
+
+	hs->ctlshift = 4;
+	hs->ctlmask = bplham ? 3 : 0;
+	hs->setshift = 0;
+	hs->datamask = 0x0f;
+	hs->xormask = 0;
+	hs->regs32 = NULL;
+	hs->regs16 = colors_for_drawing.color_regs_ecs;
+#ifdef AGA
+	if (currprefs.chipset_mask & CSMASK_AGA) {
+		hs->xormask = bplxor;
+		hs->regs32 = colors_for_drawing.color_regs_aga;
+		hs->regs16 = NULL;
+		mask = ham6aga_mask;
+		shift = ham6aga_shift;
+		if (bplham && bplplanecnt >= 7) {
+			hs->ctlshift = 0;
+			hs->setshift = 2;
+			hs->datamask = 0xfc;
+			mask = ham8_mask;
+			shift = ham8_shift;
+		}
+	}
+#endif
+	memcpy (hs->mask, mask, sizeof hs->mask);
+	memcpy (hs->shift, shift, sizeof hs->shift);
+}
+
+/* build the (mask, value) pairs of a vector from pixels, control bits and palette colors */
+#define HAM_SCAN_PAIRS(pre, suf, pv, ctl, m, v, set) do { \
+	__m##suf##i d = pre##and_si##suf (pv, pre##set1_epi32 (hs->datamask)); \
+	__m##suf##i c0 = pre##cmpeq_epi32 (ctl, pre##setzero_si##suf ()); \
+	__m##suf##i c1 = pre##cmpeq_epi32 (ctl, pre##set1_epi32 (1)); \
+	__m##suf##i c2 = pre##cmpeq_epi32 (ctl, pre##set1_epi32 (2)); \
+	__m##suf##i c3 = pre##cmpeq_epi32 (ctl, pre##set1_epi32 (3)); \
+	m = pre##or_si##suf (c0, pre##or_si##suf (pre##and_si##suf (c1, pre##set1_epi32 (hs->mask[1])), \
+		pre##or_si##suf (pre##and_si##suf (c2, pre##set1_epi32 (hs->mask[2])), pre##and_si##suf (c3, pre##set1_epi32 (hs->mask[3]))))); \
+	v = pre##or_si##suf (pre##and_si##suf (c0, set), pre##or_si##suf (pre##and_si##suf (c1, pre##sll_epi32 (d, _mm_cvtsi32_si128 (hs->shift[1]))), \
+		pre##or_si##suf (pre##and_si##suf (c2, pre##sll_epi32 (d, _mm_cvtsi32_si128 (hs->shift[2]))), \
+		pre##and_si##suf (c3, pre##sll_epi32 (d, _mm_cvtsi32_si128 (hs->shift[3])))))); \
+} while (0)
+
+/* Returns the number of pixels left for the scalar code. */
+static int NOINLINE TARGET_SSE2 decode_ham_sse2 (int count, const struct ham_scan *hs)
+{
+	uae_u8 *src = pixdata.apixels + ham_decode_pixel;
+	uae_u32 *dst = ham_linebuf + ham_decode_pixel;
+	__m128i last = _mm_set1_epi32 (ham_lastcolor);
+	__m128i z = _mm_setzero_si128 ();
+	int n = count & ~3;
+	int i;
+
+	for (i = 0; i < n; i += 4) {
+		__m128i pv = _mm_unpacklo_epi16 (_mm_unpacklo_epi8 (_mm_cvtsi32_si128 (*(int*)(src + i)), z), z);
+		__m128i ctl, idx, set, m, v;
+		int i0, i1, i2, i3;
+
+		pv = _mm_xor_si128 (pv, _mm_set1_epi32 (hs->xormask));
+		ctl = _mm_and_si128 (_mm_srli_epi32 (pv, hs->ctlshift), _mm_set1_epi32 (hs->ctlmask));
+		/* only palette lanes are looked up, others use entry 0 */
+		idx = _mm_andnot_si128 (_mm_cmpgt_epi32 (ctl, _mm_setzero_si128 ()), _mm_srli_epi32 (pv, hs->setshift));
+		i0 = _mm_cvtsi128_si32 (idx);
+		i1 = _mm_cvtsi128_si32 (_mm_srli_si128 (idx, 4));
+		i2 = _mm_cvtsi128_si32 (_mm_srli_si128 (idx, 8));
+		i3 = _mm_cvtsi128_si32 (_mm_srli_si128 (idx, 12));
+		if (hs->regs32)
+			set = _mm_setr_epi32 (hs->regs32[i0], hs->regs32[i1], hs->regs32[i2], hs->regs32[i3]);
+		else
+			set = _mm_setr_epi32 (hs->regs16[i0], hs->regs16[i1], hs->regs16[i2], hs->regs16[i3]);
+		HAM_SCAN_PAIRS (_mm_, 128, pv, ctl, m, v, set);
+
+		v = _mm_or_si128 (_mm_andnot_si128 (m, _mm_slli_si128 (v, 4)), v);
+		m = _mm_or_si128 (m, _mm_slli_si128 (m, 4));
+		v = _mm_or_si128 (_mm_andnot_si128 (m, _mm_slli_si128 (v, 8)), v);
+		m = _mm_or_si128 (m, _mm_slli_si128 (m, 8));
+
+		v = _mm_or_si128 (_mm_andnot_si128 (m, last), v);
+		_mm_storeu_si128 ((__m128i*)(dst + i), v);
+		last = _mm_shuffle_epi32 (v, 0xff);
+	}
+	ham_lastcolor = _mm_cvtsi128_si32 (last);
+	ham_decode_pixel += n;
+	return count - n;
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+/* shift lanes up by 1, 2 or 4 across the 128-bit halves */
+#define HAM_SHIFT_AVX2(x, n) ((n) == 4 ? _mm256_permute2x128_si256 (x, x, 0x08) : \
+	_mm256_alignr_epi8 (x, _mm256_permute2x128_si256 (x, x, 0x08), 16 - (n) * 4))
+
+static int NOINLINE TARGET_AVX2 decode_ham_avx2 (int count, const struct ham_scan *hs)
+{
+	uae_u8 *src = pixdata.apixels + ham_decode_pixel;
+	uae_u32 *dst = ham_linebuf + ham_decode_pixel;
+	__m256i last = _mm256_set1_epi32 (ham_lastcolor);
+	int n = count & ~7;
+	int i;
+
+	for (i = 0; i < n; i += 8) {
+		__m256i pv = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((__m128i*)(src + i)));
+		__m256i ctl, idx, set, m, v;
+
+		pv = _mm256_xor_si256 (pv, _mm256_set1_epi32 (hs->xormask));
+		ctl = _mm256_and_si256 (_mm256_srli_epi32 (pv, hs->ctlshift), _mm256_set1_epi32 (hs->ctlmask));
+		idx = _mm256_andnot_si256 (_mm256_cmpgt_epi32 (ctl, _mm256_setzero_si256 ()), _mm256_srli_epi32 (pv, hs->setshift));
+		if (hs->regs32)
+			set = _mm256_i32gather_epi32 ((const int*)hs->regs32, idx, 4);
+		else /* 16-bit entries, drop the neighbouring entry */
+			set = _mm256_and_si256 (_mm256_i32gather_epi32 ((const int*)hs->regs16, idx, 2), _mm256_set1_epi32 (0xffff));
+		HAM_SCAN_PAIRS (_mm256_, 256, pv, ctl, m, v, set);
+
+		v = _mm256_or_si256 (_mm256_andnot_si256 (m, HAM_SHIFT_AVX2 (v, 1)), v);
+		m = _mm256_or_si256 (m, HAM_SHIFT_AVX2 (m, 1));
+		v = _mm256_or_si256 (_mm256_andnot_si256 (m, HAM_SHIFT_AVX2 (v, 2)), v);
+		m = _mm256_or_si256 (m, HAM_SHIFT_AVX2 (m, 2));
+		v = _mm256_or_si256 (_mm256_andnot_si256 (m, HAM_SHIFT_AVX2 (v, 4)), v);
+		m = _mm256_or_si256 (m, HAM_SHIFT_AVX2 (m, 4));
+
+		v = _mm256_or_si256 (_mm256_andnot_si256 (m, last), v);
+		_mm256_storeu_si256 ((__m256i*)(dst + i), v);
+		last = _mm256_permutevar8x32_epi32 (v, _mm256_set1_epi32 (7));
+	}
+	ham_lastcolor = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (last));
+	ham_decode_pixel += n;
+	return count - n;
+}
+
+#endif
+
+/* Vector part of HAM decoding, leaves the rest to the scalar loops. */
+static int decode_ham_simd (int count)
+{
+	struct ham_scan hs;
+
+	if (count < 4 || !ham_simd)
+		return count;
+	ham_scan_setup (&hs);
+#ifdef HAVE_AVX2_INTRINSICS
+	if (ham_simd >= HOST_SIMD_AVX2)
+		return decode_ham_sse2 (decode_ham_avx2 (count, &hs), &hs);
+#endif
+	return decode_ham_sse2 (count, &hs);
+}
+
+#endif
+
 static void decode_ham (int pix, int stoppos)
 {
 	int todraw_amiga = res_shift_from_window (stoppos - pix);
 
+#ifdef HAVE_SSE2_INTRINSICS
+	todraw_amiga = decode_ham_simd (todraw_amiga);
+#endif
+
 	if (!bplham) {
 		while (todraw_amiga-- > 0) {
 			int pv = pixdata.apixels[ham_decode_pixel];
@@ -1565,84 +1776,69 @@ static void weird_bitplane_fix (void)
 	}
 }
 
-#define MERGE(a,b,mask,shift) do {\
-	uae_u32 tmp = mask & (a ^ (b >> shift)); \
-	a ^= tmp; \
-	b ^= (tmp << shift); \
-} while (0)
+#include "p2c.h"
 
-#define GETLONG(P) (*(uae_u32 *)P)
+static const pfield_doline_func *pfield_doline_funcs = pfield_doline_scalar;
 
-/* We use the compiler's inlining ability to ensure that PLANES is in effect a compile time
-constant.  That will cause some unnecessary code to be optimized away.
-Don't touch this if you don't know what you are doing.  */
-STATIC_INLINE void pfield_doline_1 (uae_u32 *pixels, int wordcount, int planes)
+/* Compare a SIMD planar to chunky table against the scalar one for every plane
+   count, using pseudo random plane data and odd word counts so that the scalar
+   tail is covered too. */
+static int pfield_doline_check (const pfield_doline_func *funcs)
 {
-	while (wordcount-- > 0) {
-		uae_u32 b0, b1, b2, b3, b4, b5, b6, b7;
+	static uae_u8 planes[8][64 * 4];
+	static uae_u32 out1[64 * 8], out2[64 * 8];
+	uae_u8 *save[8];
+	uae_u32 seed = 0x12345678;
+	int i, n, count;
 
-		b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0, b7 = 0;
-		switch (planes) {
-#ifdef AGA
-		case 8: b0 = GETLONG (real_bplpt[7]); real_bplpt[7] += 4;
-		case 7: b1 = GETLONG (real_bplpt[6]); real_bplpt[6] += 4;
-#endif
-		case 6: b2 = GETLONG (real_bplpt[5]); real_bplpt[5] += 4;
-		case 5: b3 = GETLONG (real_bplpt[4]); real_bplpt[4] += 4;
-		case 4: b4 = GETLONG (real_bplpt[3]); real_bplpt[3] += 4;
-		case 3: b5 = GETLONG (real_bplpt[2]); real_bplpt[2] += 4;
-		case 2: b6 = GETLONG (real_bplpt[1]); real_bplpt[1] += 4;
-		case 1: b7 = GETLONG (real_bplpt[0]); real_bplpt[0] += 4;
+	memcpy (save, real_bplpt, sizeof save);
+	for (i = 0; i < 8; i++) {
+		for (n = 0; n < 64 * 4; n++) {
+			seed = seed * 1103515245 + 12345;
+			planes[i][n] = seed >> 16;
 		}
+	}
+	for (n = 1; n < 9; n++) {
+		if (!pfield_doline_scalar[n])
+			continue;
+		for (count = 1; count <= 64; count += 13) {
+			memset (out1, 0x55, sizeof out1);
+			memset (out2, 0xaa, sizeof out2);
+			for (i = 0; i < 8; i++)
+				real_bplpt[i] = planes[i];
+			pfield_doline_scalar[n] (out1, count);
+			for (i = 0; i < 8; i++)
+				real_bplpt[i] = planes[i];
+			funcs[n] (out2, count);
+			if (memcmp (out1, out2, count * 32)) {
+				memcpy (real_bplpt, save, sizeof save);
+				write_log (L"pfield_doline SIMD mismatch, planes=%d words=%d\n", n, count);
+				return 0;
+			}
+		}
+	}
+	memcpy (real_bplpt, save, sizeof save);
+	return 1;
+}
 
-		MERGE (b0, b1, 0x55555555, 1);
-		MERGE (b2, b3, 0x55555555, 1);
-		MERGE (b4, b5, 0x55555555, 1);
-		MERGE (b6, b7, 0x55555555, 1);
-
-		MERGE (b0, b2, 0x33333333, 2);
-		MERGE (b1, b3, 0x33333333, 2);
-		MERGE (b4, b6, 0x33333333, 2);
-		MERGE (b5, b7, 0x33333333, 2);
-
-		MERGE (b0, b4, 0x0f0f0f0f, 4);
-		MERGE (b1, b5, 0x0f0f0f0f, 4);
-		MERGE (b2, b6, 0x0f0f0f0f, 4);
-		MERGE (b3, b7, 0x0f0f0f0f, 4);
-
-		MERGE (b0, b1, 0x00ff00ff, 8);
-		MERGE (b2, b3, 0x00ff00ff, 8);
-		MERGE (b4, b5, 0x00ff00ff, 8);
-		MERGE (b6, b7, 0x00ff00ff, 8);
-
-		MERGE (b0, b2, 0x0000ffff, 16);
-		do_put_mem_long (pixels, b0);
-		do_put_mem_long (pixels + 4, b2);
-		MERGE (b1, b3, 0x0000ffff, 16);
-		do_put_mem_long (pixels + 2, b1);
-		do_put_mem_long (pixels + 6, b3);
-		MERGE (b4, b6, 0x0000ffff, 16);
-		do_put_mem_long (pixels + 1, b4);
-		do_put_mem_long (pixels + 5, b6);
-		MERGE (b5, b7, 0x0000ffff, 16);
-		do_put_mem_long (pixels + 3, b5);
-		do_put_mem_long (pixels + 7, b7);
-		pixels += 8;
-	}
-}
-
-/* See above for comments on inlining.  These functions should _not_
-be inlined themselves.  */
-static void NOINLINE pfield_doline_n1 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 1); }
-static void NOINLINE pfield_doline_n2 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 2); }
-static void NOINLINE pfield_doline_n3 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 3); }
-static void NOINLINE pfield_doline_n4 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 4); }
-static void NOINLINE pfield_doline_n5 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 5); }
-static void NOINLINE pfield_doline_n6 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 6); }
-#ifdef AGA
-static void NOINLINE pfield_doline_n7 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 7); }
-static void NOINLINE pfield_doline_n8 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 8); }
+static void pfield_doline_init (void)
+{
+	pfield_doline_funcs = pfield_doline_scalar;
+#ifdef HAVE_SSE2_INTRINSICS
+	int level = host_simd_level ();
+#ifdef HAVE_AVX2_INTRINSICS
+	if (level >= HOST_SIMD_AVX2 && pfield_doline_check (pfield_doline_avx2_funcs)) {
+		pfield_doline_funcs = pfield_doline_avx2_funcs;
+		write_log (L"pfield_doline: AVX2\n");
+		return;
+	}
 #endif
+	if (level >= HOST_SIMD_SSE2 && pfield_doline_check (pfield_doline_sse2_funcs)) {
+		pfield_doline_funcs = pfield_doline_sse2_funcs;
+		write_log (L"pfield_doline: SSE2\n");
+	}
+#endif
+}
 
 static void pfield_doline (int lineno)
 {
@@ -1663,20 +1859,10 @@ static void pfield_doline (int lineno)
 #endif
 #endif
 
-	switch (bplplanecnt) {
-	default: break;
-	case 0: memset (data, 0, wordcount * 32); break;
-	case 1: pfield_doline_n1 (data, wordcount); break;
-	case 2: pfield_doline_n2 (data, wordcount); break;
-	case 3: pfield_doline_n3 (data, wordcount); break;
-	case 4: pfield_doline_n4 (data, wordcount); break;
-	case 5: pfield_doline_n5 (data, wordcount); break;
-	case 6: pfield_doline_n6 (data, wordcount); break;
-#ifdef AGA
-	case 7: pfield_doline_n7 (data, wordcount); break;
-	case 8: pfield_doline_n8 (data, wordcount); break;
-#endif
-	}
+	if (bplplanecnt == 0)
+		memset (data, 0, wordcount * 32);
+	else if (bplplanecnt > 0 && bplplanecnt < 9 && pfield_doline_funcs[bplplanecnt])
+		pfield_doline_funcs[bplplanecnt] (data, wordcount);
 }
 
 void init_row_map (void)
@@ -1775,8 +1961,13 @@ static void do_flush_line_1 (int lineno)
 	}
 }
 
+/* set while drawing a band of lines, flushes are done afterwards in line order */
+static DRAW_TLS int render_worker;
+
 STATIC_INLINE void do_flush_line (int lineno)
 {
+	if (render_worker)
+		return;
 	do_flush_line_1 (lineno);
 }
 
@@ -1903,8 +2094,8 @@ static void pfield_expand_dp_bplconx (int regno, int v)
 	res_shift = lores_shift - bplres;
 }
 
-static int drawing_color_matches;
-static enum { color_match_acolors, color_match_full } color_match_type;
+static DRAW_TLS int drawing_color_matches;
+static DRAW_TLS enum { color_match_acolors, color_match_full } color_match_type;
 
 /* Set up colors_for_drawing to the state at the beginning of the currently drawn
 line.  Try to avoid copying color tables around whenever possible.  */
@@ -1981,22 +2172,194 @@ enum double_how {
 	dh_emerg
 };
 
-static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
+/* How one line is drawn, decided from linestate before drawing starts.  */
+struct draw_job
+{
+	int lineno, gfx_ypos, follow_ypos;
+	int border, do_double;
+	struct decision *dp;
+	struct draw_info *dip;
+};
+
+/* Frame to frame line signatures. custom.c marks a line changed whenever
+something was written to it, these catch the lines that were rewritten
+with the same data, colors and sprites: the signature covers everything
+pfield_draw_job reads. A zero signature is never matched. */
+static uae_u64 line_signature[(MAXVPOS + 2) * 2 + 1];
+static uae_u64 frame_signature;
+static int signature_ctable;
+static uae_u64 signature_ctable_value;
+static uae_u64 lines_drawn, lines_skipped;
+static uae_u64 frames_drawn, frames_not_flushed;
+
+/* xxHash64 style round per 32-bit value, finished with the murmur3
+64-bit finalizer in signature_check so every input bit reaches every
+output bit. */
+STATIC_INLINE uae_u64 signature_add (uae_u64 h, uae_u32 v)
+{
+	h ^= (uae_u64)v * UVAL64 (0xc2b2ae3d27d4eb4f);
+	h = (h << 31) | (h >> 33);
+	return h * UVAL64 (0x9e3779b185ebca87);
+}
+
+STATIC_INLINE uae_u64 signature_final (uae_u64 h)
+{
+	h ^= h >> 33;
+	h *= UVAL64 (0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UVAL64 (0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return h;
+}
+
+STATIC_INLINE uae_u64 signature_ptr (uae_u64 h, const void *p)
+{
+	uae_u64 v = (size_t)p;
+	return signature_add (signature_add (h, (uae_u32)v), (uae_u32)(v >> 32));
+}
+
+static uae_u64 signature_block (uae_u64 h, const void *p, int bytes)
+{
+	const uae_u32 *w = (const uae_u32*)p;
+	const uae_u8 *b;
+	int i;
+
+	for (i = 0; i < bytes / 4; i++)
+		h = signature_add (h, w[i]);
+	b = (const uae_u8*)(w + i);
+	for (i = 0; i < (bytes & 3); i++)
+		h = signature_add (h, b[i]);
+	return h;
+}
+
+/* Global drawing state that is not part of line_decisions. */
+static void signature_frame_start (void)
+{
+	uae_u64 h = UVAL64 (0xcbf29ce484222325);
+
+	h = signature_add (h, visible_left_border);
+	h = signature_add (h, visible_right_border);
+	h = signature_add (h, linetoscr_x_adjust_bytes);
+	h = signature_add (h, hsyncstartpos);
+	h = signature_add (h, gfxvidinfo.pixbytes);
+	h = signature_add (h, gfxvidinfo.width);
+	h = signature_ptr (h, gfxvidinfo.linemem);
+	h = signature_add (h, currprefs.chipset_mask);
+	h = signature_add (h, currprefs.gfx_resolution);
+	h = signature_add (h, currprefs.gfx_lores_mode);
+	h = signature_add (h, sprite_buffer_res);
+	h = signature_add (h, debug_bpl_mask);
+	h = signature_add (h, debug_bpl_mask_one);
+	frame_signature = h;
+	signature_ctable = -1;
+}
+
+/* Consecutive lines usually share one color table, hash it only once. */
+static uae_u64 signature_colors (int ctable)
+{
+	struct color_entry *ce = curr_color_tables + ctable;
+	uae_u64 h = UVAL64 (0x27d4eb2f165667c5);
+
+	if (ctable == signature_ctable)
+		return signature_ctable_value;
+#ifdef AGA
+	if (currprefs.chipset_mask & CSMASK_AGA)
+		h = signature_block (h, ce->color_regs_aga, sizeof ce->color_regs_aga);
+	else
+#endif
+		h = signature_block (h, ce->color_regs_ecs, sizeof ce->color_regs_ecs);
+	signature_ctable = ctable;
+	signature_ctable_value = h;
+	return h;
+}
+
+static uae_u64 signature_line (struct draw_job *job)
+{
+	struct decision *dp = job->dp;
+	struct draw_info *dip = job->dip;
+	uae_u64 h = frame_signature;
+	int i;
+
+	h = signature_add (h, job->gfx_ypos);
+	h = signature_add (h, job->follow_ypos);
+	h = signature_add (h, job->border | (job->do_double << 2));
+	h = signature_ptr (h, row_map[job->gfx_ypos]);
+	if (job->border == 2)
+		return h;
+
+	h = signature_add (h, dp->plfleft);
+	h = signature_add (h, dp->plfright);
+	h = signature_add (h, dp->plflinelen);
+	h = signature_add (h, dp->diwfirstword);
+	h = signature_add (h, dp->diwlastword);
+	h = signature_add (h, dp->bplcon0 | (dp->bplcon2 << 16));
+#ifdef AGA
+	h = signature_add (h, dp->bplcon3 | (dp->bplcon4 << 16));
+#endif
+	h = signature_add (h, dp->nr_planes | (dp->bplres << 8) | (dp->ehb_seen << 16) | (dp->ham_seen << 17) | (dp->ham_at_start << 18));
+	if (dp->ctable >= 0)
+		h ^= signature_colors (dp->ctable);
+
+	if (job->border == 0) {
+		for (i = 0; i < dp->nr_planes; i++)
+			h = signature_block (h, line_data[job->lineno] + i * MAX_WORDS_PER_LINE * 2, dp->plflinelen * 4);
+	}
+	for (i = dip->first_color_change; i < dip->last_color_change; i++) {
+		struct color_change *cc = &curr_color_changes[i];
+		h = signature_add (h, cc->linepos);
+		h = signature_add (h, cc->regno);
+		h = signature_add (h, cc->value);
+	}
+	for (i = 0; i < dip->nr_sprites; i++) {
+		struct sprite_entry *e = curr_sprite_entries + dip->first_sprite_entry + i;
+		int len = e->max - e->pos;
+		h = signature_add (h, e->pos | (e->max << 16));
+		h = signature_add (h, e->has_attached);
+		h = signature_block (h, spixels + e->first_pixel, len * sizeof (uae_u16));
+		h = signature_block (h, spixstate.bytes + e->first_pixel, len);
+	}
+	return h;
+}
+
+/* Returns nonzero if the line looks exactly like it did last time
+it was drawn. The new signature is remembered either way. */
+static int signature_check (uae_u64 *sig, uae_u64 h, int lineno)
+{
+	int same;
+
+	h = signature_final (h);
+	same = *sig == h && h != 0 && !frame_redraw_necessary
+		&& !(lineno >= lightpen_y1 && lineno <= lightpen_y2);
+	*sig = h;
+	return same;
+}
+
+void drawing_line_stats (void)
+{
+	uae_u64 total = lines_drawn + lines_skipped;
+	console_out_f (L"Lines drawn %I64u, skipped %I64u (%.2f%%)\n",
+		lines_drawn, lines_skipped, total ? lines_skipped * 100.0 / total : 0.0);
+	console_out_f (L"Frames %I64u, without any flushed line %I64u\n",
+		frames_drawn, frames_not_flushed);
+	lines_drawn = lines_skipped = frames_drawn = frames_not_flushed = 0;
+}
+
+/* Update linestate and fill in the drawing job for the line,
+returns zero if there is nothing to draw.  */
+static int pfield_prepare_line (struct draw_job *job, int lineno, int gfx_ypos, int follow_ypos)
 {
 	static int warned = 0;
+	struct decision *dp = line_decisions + lineno;
+	struct draw_info *dip = curr_drawinfo + lineno;
 	int border = 0;
 	int do_double = 0;
-	enum double_how dh;
-
-	dp_for_drawing = line_decisions + lineno;
-	dip_for_drawing = curr_drawinfo + lineno;
 
 	switch (linestate[lineno])
 	{
 	case LINE_REMEMBERED_AS_PREVIOUS:
 //		if (!warned) // happens when program messes up with VPOSW
 //			write_log (L"Shouldn't get here... this is a bug.\n"), warned++;
-		return;
+		return 0;
 
 	case LINE_BLACK:
 		linestate[lineno] = LINE_REMEMBERED_AS_BLACK;
@@ -2004,20 +2367,20 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 		break;
 
 	case LINE_REMEMBERED_AS_BLACK:
-		return;
+		return 0;
 
 	case LINE_AS_PREVIOUS:
-		dp_for_drawing--;
-		dip_for_drawing--;
+		dp--;
+		dip--;
 		linestate[lineno] = LINE_DONE_AS_PREVIOUS;
-		if (dp_for_drawing->plfleft == -1)
+		if (dp->plfleft == -1)
 			border = 1;
 		break;
 
 	case LINE_DONE_AS_PREVIOUS:
 		/* fall through */
 	case LINE_DONE:
-		return;
+		return 0;
 
 	case LINE_DECIDED_DOUBLE:
 		if (follow_ypos != -1) {
@@ -2027,17 +2390,45 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 
 		/* fall through */
 	default:
-		if (dp_for_drawing->plfleft == -1)
+		if (dp->plfleft == -1)
 			border = 1;
 		linestate[lineno] = LINE_DONE;
 		break;
 	}
 
+	job->lineno = lineno;
+	job->gfx_ypos = gfx_ypos;
+	job->follow_ypos = follow_ypos;
+	job->border = border;
+	job->do_double = do_double;
+	job->dp = dp;
+	job->dip = dip;
+
+	if (signature_check (&line_signature[lineno], signature_line (job), lineno)) {
+		lines_skipped++;
+		return 0;
+	}
+	lines_drawn++;
+	return 1;
+}
+
+static void pfield_draw_job (struct draw_job *job)
+{
+	int lineno = job->lineno;
+	int gfx_ypos = job->gfx_ypos;
+	int follow_ypos = job->follow_ypos;
+	int border = job->border;
+	int do_double = job->do_double;
+	enum double_how dh;
+
+	dp_for_drawing = job->dp;
+	dip_for_drawing = job->dip;
+
 	dh = dh_line;
 	xlinebuffer = gfxvidinfo.linemem;
 	if (xlinebuffer == 0 && do_double
 		&& (border == 0 || dip_for_drawing->nr_color_changes > 0))
-		xlinebuffer = gfxvidinfo.emergmem, dh = dh_emerg;
+		xlinebuffer = line_emergmem ? line_emergmem : gfxvidinfo.emergmem, dh = dh_emerg;
 	if (xlinebuffer == 0)
 		xlinebuffer = row_map[gfx_ypos], dh = dh_buf;
 	xlinebuffer -= linetoscr_x_adjust_bytes;
@@ -2167,6 +2558,14 @@ static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
 	}
 }
 
+static void pfield_draw_line (int lineno, int gfx_ypos, int follow_ypos)
+{
+	struct draw_job job;
+
+	if (pfield_prepare_line (&job, lineno, gfx_ypos, follow_ypos))
+		pfield_draw_job (&job);
+}
+
 static void center_image (void)
 {
 	int prev_x_adjust = visible_left_border;
@@ -2455,8 +2854,6 @@ static void draw_lightpen_cursor (int x, int y, int line, int onscreen)
 	}
 }
 
-static int lightpen_y1, lightpen_y2;
-
 static void lightpen_update (void)
 {
 	int i;
@@ -2498,10 +2895,194 @@ static void lightpen_update (void)
 	lightpen_y2 = lightpen_y1 + LIGHTPEN_HEIGHT + 2;
 }
 
-void finish_drawing_frame (void)
+/* Multithreaded drawing.
+
+   All lines of the frame are first decided in order (linestate updates),
+   then the job list is split into bands that are drawn in parallel by
+   render threads, the calling thread draws the last band. Bands only start
+   at playfield lines that don't use the previous line's decisions so every
+   band can start from a clean drawing state. Lines are flushed in order
+   after all bands are done.  */
+
+static struct draw_job draw_jobs[(MAXVPOS + 2) * 2 + 1];
+
+static void draw_jobs_band (int first, int last)
 {
 	int i;
 
+	for (i = first; i < last; i++) {
+		hposblank = 0;
+		pfield_draw_job (&draw_jobs[i]);
+	}
+}
+
+#ifdef RENDER_THREADS
+
+#define MAX_RENDER_THREADS 8
+
+struct render_thread
+{
+	uae_thread_id tid;
+	uae_sem_t start, done;
+	int first, last;
+	int brdblank;
+	int frame_res, frame_res_lace, can_use_lores;
+	bool running, quit;
+	uae_u8 emergmem[4096 * 4];
+};
+
+static struct render_thread render_threads[MAX_RENDER_THREADS - 1];
+
+static void *render_thread_func (void *v)
+{
+	struct render_thread *rt = (struct render_thread*)v;
+
+	render_worker = 1;
+	line_emergmem = rt->emergmem;
+	for (;;) {
+		uae_sem_wait (&rt->start);
+		if (rt->quit)
+			break;
+		drawing_color_matches = -1;
+		brdblank = rt->brdblank;
+		frame_res = -1;
+		frame_res_lace = 0;
+		can_use_lores = 1;
+		draw_jobs_band (rt->first, rt->last);
+		rt->frame_res = frame_res;
+		rt->frame_res_lace = frame_res_lace;
+		rt->can_use_lores = can_use_lores;
+		uae_sem_post (&rt->done);
+	}
+	return NULL;
+}
+
+static int render_threads_start (void)
+{
+	int i, num = currprefs.gfx_render_threads;
+
+	/* lines must be drawn directly to their own rows */
+	if (num <= 1 || gfxvidinfo.linemem)
+		return 1;
+	if (num > MAX_RENDER_THREADS)
+		num = MAX_RENDER_THREADS;
+	for (i = 0; i < num - 1; i++) {
+		struct render_thread *rt = &render_threads[i];
+		if (rt->running)
+			continue;
+		uae_sem_init (&rt->start, 0, 0);
+		uae_sem_init (&rt->done, 0, 0);
+		if (!uae_start_thread (L"render", render_thread_func, rt, &rt->tid))
+			break;
+		rt->running = true;
+	}
+	return i + 1;
+}
+
+static void render_threads_stop (void)
+{
+	int i;
+
+	for (i = 0; i < MAX_RENDER_THREADS - 1; i++) {
+		struct render_thread *rt = &render_threads[i];
+		if (!rt->running)
+			continue;
+		rt->quit = true;
+		uae_sem_post (&rt->start);
+		uae_wait_thread (rt->tid);
+		uae_sem_destroy (&rt->start);
+		uae_sem_destroy (&rt->done);
+		rt->running = rt->quit = false;
+	}
+}
+
+static bool draw_job_is_band_start (struct draw_job *job)
+{
+	return job->border == 0 && job->dp == line_decisions + job->lineno;
+}
+
+static void draw_frame_jobs (int njobs)
+{
+	int starts[MAX_RENDER_THREADS + 1];
+	int i, nb, num, res;
+
+	num = render_threads_start ();
+	if (num <= 1 || njobs < num * 8) {
+		draw_jobs_band (0, njobs);
+		return;
+	}
+
+	nb = 0;
+	starts[nb++] = 0;
+	for (i = 1; i < num; i++) {
+		int j = njobs * i / num;
+		if (j <= starts[nb - 1])
+			j = starts[nb - 1] + 1;
+		while (j < njobs && !draw_job_is_band_start (&draw_jobs[j]))
+			j++;
+		if (j >= njobs)
+			break;
+		starts[nb++] = j;
+	}
+	starts[nb] = njobs;
+
+	for (i = 0; i < nb - 1; i++) {
+		struct render_thread *rt = &render_threads[i];
+		rt->first = starts[i];
+		rt->last = starts[i + 1];
+		rt->brdblank = brdblank;
+		uae_sem_post (&rt->start);
+	}
+	render_worker = 1;
+	draw_jobs_band (starts[nb - 1], njobs);
+	render_worker = 0;
+	res = frame_res;
+	for (i = 0; i < nb - 1; i++) {
+		struct render_thread *rt = &render_threads[i];
+		uae_sem_wait (&rt->done);
+		if (rt->frame_res > frame_res)
+			frame_res = rt->frame_res;
+		if (rt->frame_res >= 0 && res < 0)
+			frame_res_lace = rt->frame_res_lace;
+		if (!rt->can_use_lores)
+			can_use_lores = 0;
+	}
+
+	for (i = 0; i < njobs; i++) {
+		do_flush_line (draw_jobs[i].gfx_ypos);
+		if (draw_jobs[i].do_double)
+			do_flush_line (draw_jobs[i].follow_ypos);
+	}
+}
+
+#else
+
+static void draw_frame_jobs (int njobs)
+{
+	draw_jobs_band (0, njobs);
+}
+
+#endif
+
+void drawing_free (void)
+{
+#ifdef RENDER_THREADS
+	render_threads_stop ();
+#endif
+}
+
+void notice_new_drawing_colors (void)
+{
+	drawing_color_matches = -1;
+	/* xcolors may have changed, signatures only cover Amiga colors */
+	memset (line_signature, 0, sizeof line_signature);
+}
+
+void finish_drawing_frame (void)
+{
+	int i, njobs;
+	uae_u64 h;
+
 	if (! lockscr (false)) {
 		notice_screen_contents_lost ();
 		return;
@@ -2516,6 +3097,8 @@ void finish_drawing_frame (void)
 	return;
 #endif
 
+	signature_frame_start ();
+	njobs = 0;
 	for (i = 0; i < max_ypos_thisframe; i++) {
 		int i1 = i + min_ypos_for_screen;
 		int line = i + thisframe_y_adjust_real;
@@ -2526,9 +3109,10 @@ void finish_drawing_frame (void)
 			break;
 		if (where2 < 0)
 			continue;
-		hposblank = 0;
-		pfield_draw_line (line, where2, amiga2aspect_line_map[i1 + 1]);
+		if (pfield_prepare_line (&draw_jobs[njobs], line, where2, amiga2aspect_line_map[i1 + 1]))
+			njobs++;
 	}
+	draw_frame_jobs (njobs);
 
 	/* clear possible old garbage at the bottom if emulated area become smaller */
 	for (i = last_max_ypos; i < gfxvidinfo.height; i++) {
@@ -2542,13 +3126,23 @@ void finish_drawing_frame (void)
 			continue;
 
 		hposblank = i >= last_max_ypos + 16;
+		linestate[line] = LINE_UNDECIDED;
+
+		h = signature_add (frame_signature, where2);
+		h = signature_add (h, getbgc ());
+		h = signature_add (h, hposblank | 0x100);
+		h = signature_ptr (h, row_map[where2]);
+		if (signature_check (&line_signature[line], h, line)) {
+			lines_skipped++;
+			continue;
+		}
+		lines_drawn++;
 
 		xlinebuffer = gfxvidinfo.linemem;
 		if (xlinebuffer == 0)
 			xlinebuffer = row_map[where2];
 		xlinebuffer -= linetoscr_x_adjust_bytes;
 		fill_line ();
-		linestate[line] = LINE_UNDECIDED;
 		do_flush_line (where2);
 	}
 
@@ -2572,6 +3166,9 @@ void finish_drawing_frame (void)
 	if (lightpen_x > 0 || lightpen_y > 0)
 		lightpen_update ();
 
+	frames_drawn++;
+	if (first_drawn_line > last_drawn_line)
+		frames_not_flushed++;
 	do_flush_screen (first_drawn_line, last_drawn_line);
 
 #ifdef ECS_DENISE
@@ -2814,6 +3411,13 @@ void reset_drawing (void)
 void drawing_init (void)
 {
 	gen_pfield_tables ();
+	pfield_doline_init ();
+#ifdef LINETOSCR_SIMD
+	linetoscr_simd = host_simd_level ();
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+	ham_simd = host_simd_level ();
+#endif
 
 	uae_sem_init (&gui_sem, 0, 1);
 #ifdef PICASSO96
@@ -430,6 +430,7 @@ void REGPARAM2 chipmem_lput2 (uaecptr addr, uae_u32 l)
 
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 
 	if (ISILLEGAL_LONG (addr))
@@ -450,6 +451,7 @@ void REGPARAM2 chipmem_wput2 (uaecptr addr, uae_u32 w)
 
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 
 	if (ISILLEGAL_WORD (addr))
@@ -467,6 +469,7 @@ void REGPARAM2 chipmem_bput2 (uaecptr addr, uae_u32 b)
 {
 	addr -= chipmem_start & chipmem_mask;
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 1);
 
 	if (ISILLEGAL_BYTE (addr))
 	{
@@ -442,6 +442,7 @@ static void REGPARAM2 fastmem_lput (uaecptr addr, uae_u32 l)
 	uae_u8 *m;
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
+	decodecache_write (fastmemory + addr, 4);
 	m = fastmemory + addr;
 	do_put_mem_long ((uae_u32 *)m, l);
 }
@@ -451,6 +452,7 @@ static void REGPARAM2 fastmem_wput (uaecptr addr, uae_u32 w)
 	uae_u8 *m;
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
+	decodecache_write (fastmemory + addr, 2);
 	m = fastmemory + addr;
 	do_put_mem_word ((uae_u16 *)m, w);
 }
@@ -459,6 +461,7 @@ static void REGPARAM2 fastmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr -= fastmem_start & fastmem_mask;
 	addr &= fastmem_mask;
+	decodecache_write (fastmemory + addr, 1);
 	fastmemory[addr] = b;
 }
 
@@ -731,6 +734,7 @@ static void REGPARAM2 z3fastmem_lput (uaecptr addr, uae_u32 l)
 	uae_u8 *m;
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
+	decodecache_write (z3fastmem + addr, 4);
 	m = z3fastmem + addr;
 	do_put_mem_long ((uae_u32 *)m, l);
 }
@@ -739,6 +743,7 @@ static void REGPARAM2 z3fastmem_wput (uaecptr addr, uae_u32 w)
 	uae_u8 *m;
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
+	decodecache_write (z3fastmem + addr, 2);
 	m = z3fastmem + addr;
 	do_put_mem_word ((uae_u16 *)m, w);
 }
@@ -746,6 +751,7 @@ static void REGPARAM2 z3fastmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr -= z3fastmem_start & z3fastmem_mask;
 	addr &= z3fastmem_mask;
+	decodecache_write (z3fastmem + addr, 1);
 	z3fastmem[addr] = b;
 }
 static int REGPARAM2 z3fastmem_check (uaecptr addr, uae_u32 size)
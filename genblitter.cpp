@@ -10,6 +10,7 @@
 #include "sysconfig.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "genblitter.h"
 
@@ -203,6 +204,387 @@ static void generate_func(void)
     }
 }
 
+/* SIMD versions, 8 (SSE2) or 16 (AVX2) words per step, all 256 minterms.
+ * Sources and destination are direct chip RAM pointers, blitter.cpp only
+ * uses these when all channels are inside chip RAM and D does not overlap
+ * a source that is read later, and it also sets the A/B/C data registers
+ * to the last words read. A and B are byte swapped to host order for
+ * the shifts, C and D stay in Amiga byte order. '@' in the templates below
+ * is replaced with the instruction set name and '$' with words per step. */
+
+struct simdisa {
+    const char *name;
+    const char *define;
+    int words;
+    const char **pre;
+};
+
+static const char *simd_pre_sse2[] = {
+    "typedef __m128i bvec_@;",
+    "#define bv_and_@(x, y) _mm_and_si128 (x, y)",
+    "#define bv_or_@(x, y) _mm_or_si128 (x, y)",
+    "#define bv_andnot_@(x, y) _mm_andnot_si128 (x, y)",
+    "#define bv_xor_@(x, y) _mm_xor_si128 (x, y)",
+    "#define bv_ones_@() _mm_set1_epi32 (-1)",
+    "#define bv_zero_@() _mm_setzero_si128 ()",
+    "#define bv_load_@(p) _mm_loadu_si128 ((const __m128i*)(p))",
+    "#define bv_store_@(p, v) _mm_storeu_si128 ((__m128i*)(p), v)",
+    "#define bv_set1_@(w) _mm_set1_epi16 ((short)(w))",
+    "#define bv_bswap_@(x) _mm_or_si128 (_mm_slli_epi16 (x, 8), _mm_srli_epi16 (x, 8))",
+    "#define bv_shr_@(x, c) _mm_srl_epi16 (x, c)",
+    "#define bv_shl_@(x, c) _mm_sll_epi16 (x, c)",
+    "#define bv_up_@(x, w) _mm_or_si128 (_mm_slli_si128 (x, 2), _mm_cvtsi32_si128 (w))",
+    "#define bv_down_@(x, w) _mm_or_si128 (_mm_srli_si128 (x, 2), _mm_slli_si128 (_mm_cvtsi32_si128 (w), 14))",
+    "#define bv_nonzero_@(x) (_mm_movemask_epi8 (_mm_cmpeq_epi8 (x, _mm_setzero_si128 ())) != 0xffff)",
+    "#define bv_top_@(x) _mm_extract_epi16 (x, 7)",
+    "#define bv_bottom_@(x) (_mm_cvtsi128_si32 (x) & 0xffff)",
+    NULL
+};
+
+static const char *simd_pre_avx2[] = {
+    "typedef __m256i bvec_@;",
+    "#define bv_and_@(x, y) _mm256_and_si256 (x, y)",
+    "#define bv_or_@(x, y) _mm256_or_si256 (x, y)",
+    "#define bv_andnot_@(x, y) _mm256_andnot_si256 (x, y)",
+    "#define bv_xor_@(x, y) _mm256_xor_si256 (x, y)",
+    "#define bv_ones_@() _mm256_set1_epi32 (-1)",
+    "#define bv_zero_@() _mm256_setzero_si256 ()",
+    "#define bv_load_@(p) _mm256_loadu_si256 ((const __m256i*)(p))",
+    "#define bv_store_@(p, v) _mm256_storeu_si256 ((__m256i*)(p), v)",
+    "#define bv_set1_@(w) _mm256_set1_epi16 ((short)(w))",
+    "#define bv_bswap_@(x) _mm256_or_si256 (_mm256_slli_epi16 (x, 8), _mm256_srli_epi16 (x, 8))",
+    "#define bv_shr_@(x, c) _mm256_srl_epi16 (x, c)",
+    "#define bv_shl_@(x, c) _mm256_sll_epi16 (x, c)",
+    "#define bv_up_@(x, w) _mm256_or_si256 (_mm256_alignr_epi8 (x, _mm256_permute2x128_si256 (x, x, 0x08), 14), _mm256_set_epi32 (0, 0, 0, 0, 0, 0, 0, (w) & 0xffff))",
+    "#define bv_down_@(x, w) _mm256_or_si256 (_mm256_alignr_epi8 (_mm256_permute2x128_si256 (x, x, 0x81), x, 2), _mm256_set_epi32 ((w) << 16, 0, 0, 0, 0, 0, 0, 0))",
+    "#define bv_nonzero_@(x) (!_mm256_testz_si256 (x, x))",
+    "#define bv_top_@(x) _mm_extract_epi16 (_mm256_extracti128_si256 (x, 1), 7)",
+    "#define bv_bottom_@(x) (_mm_cvtsi128_si32 (_mm256_castsi256_si128 (x)) & 0xffff)",
+    NULL
+};
+
+/* partial steps at the end of a line go through a temporary buffer */
+static const char *simd_helpers[] = {
+    "STATIC_INLINE BLITSIMD_TARGET_@ bvec_@ bv_loadn_@ (const uae_u8 *p, int bytes, int top)",
+    "{",
+    "\tuae_u16 tmp[$];",
+    "\tmemset (tmp, 0, sizeof tmp);",
+    "\tmemcpy ((uae_u8*)tmp + (top ? sizeof tmp - bytes : 0), p, bytes);",
+    "\treturn bv_load_@ (tmp);",
+    "}",
+    "STATIC_INLINE BLITSIMD_TARGET_@ uae_u32 bv_storen_@ (uae_u8 *p, bvec_@ v, int bytes, int top)",
+    "{",
+    "\tuae_u16 tmp[$], *src;",
+    "\tuae_u32 totald = 0;",
+    "\tint i;",
+    "\tbv_store_@ (tmp, v);",
+    "\tsrc = tmp + (top ? $ - bytes / 2 : 0);",
+    "\tif (p)",
+    "\t\tmemcpy (p, src, bytes);",
+    "\tfor (i = 0; i < bytes / 2; i++)",
+    "\t\ttotald |= src[i];",
+    "\treturn totald;",
+    "}",
+    "STATIC_INLINE BLITSIMD_TARGET_@ uae_u32 bv_lane_@ (bvec_@ v, int lane)",
+    "{",
+    "\tuae_u16 tmp[$];",
+    "\tbv_store_@ (tmp, v);",
+    "\treturn tmp[lane];",
+    "}",
+    NULL
+};
+
+static struct simdisa simdisas[] = {
+    { "sse2", NULL, 8, simd_pre_sse2 },
+    { "avx2", "BLITTER_SIMD_AVX2", 16, simd_pre_avx2 }
+};
+
+static void simd_print(const struct simdisa *isa, const char *line)
+{
+    for (; *line; line++) {
+	if (*line == '@')
+	    printf("%s", isa->name);
+	else if (*line == '$')
+	    printf("%d", isa->words);
+	else
+	    putchar(*line);
+    }
+    putchar('\n');
+}
+
+/* function of srcb and srcc, bit 3 = B&C, bit 2 = B&~C, bit 1 = ~B&C, bit 0 = ~B&~C */
+static void simd_bc(char *out, const char *isa, int f)
+{
+    switch (f) {
+     case 0: sprintf(out, "bv_zero_%s ()", isa); break;
+     case 1: sprintf(out, "bv_xor_%s (bv_or_%s (srcb, srcc), ones)", isa, isa); break;
+     case 2: sprintf(out, "bv_andnot_%s (srcb, srcc)", isa); break;
+     case 3: sprintf(out, "bv_xor_%s (srcb, ones)", isa); break;
+     case 4: sprintf(out, "bv_andnot_%s (srcc, srcb)", isa); break;
+     case 5: sprintf(out, "bv_xor_%s (srcc, ones)", isa); break;
+     case 6: sprintf(out, "bv_xor_%s (srcb, srcc)", isa); break;
+     case 7: sprintf(out, "bv_xor_%s (bv_and_%s (srcb, srcc), ones)", isa, isa); break;
+     case 8: sprintf(out, "bv_and_%s (srcb, srcc)", isa); break;
+     case 9: sprintf(out, "bv_xor_%s (bv_xor_%s (srcb, srcc), ones)", isa, isa); break;
+     case 10: sprintf(out, "srcc"); break;
+     case 11: sprintf(out, "bv_xor_%s (bv_andnot_%s (srcc, srcb), ones)", isa, isa); break;
+     case 12: sprintf(out, "srcb"); break;
+     case 13: sprintf(out, "bv_xor_%s (bv_andnot_%s (srcb, srcc), ones)", isa, isa); break;
+     case 14: sprintf(out, "bv_or_%s (srcb, srcc)", isa); break;
+     case 15: sprintf(out, "ones"); break;
+    }
+}
+
+/* split the minterm on A, the A and ~A halves are functions of B and C */
+static void simd_minterm(char *out, const char *isa, int mt)
+{
+    char f0[200], f1[200];
+    int g0 = mt & 15, g1 = mt >> 4;
+
+    simd_bc(f0, isa, g0);
+    simd_bc(f1, isa, g1);
+    if (g0 == g1)
+	strcpy(out, f0);
+    else if (g1 == 15 && g0 == 0)
+	sprintf(out, "srca");
+    else if (g1 == 0 && g0 == 15)
+	sprintf(out, "bv_xor_%s (srca, ones)", isa);
+    else if ((g0 ^ g1) == 15)
+	sprintf(out, "bv_xor_%s (srca, %s)", isa, f0);
+    else if (g0 == 0)
+	sprintf(out, "bv_and_%s (srca, %s)", isa, f1);
+    else if (g1 == 0)
+	sprintf(out, "bv_andnot_%s (srca, %s)", isa, f0);
+    else if (g1 == 15)
+	sprintf(out, "bv_or_%s (srca, %s)", isa, f0);
+    else if (g0 == 15)
+	sprintf(out, "bv_xor_%s (bv_andnot_%s (%s, srca), ones)", isa, isa, f1);
+    else
+	sprintf(out, "bv_or_%s (bv_and_%s (srca, %s), bv_andnot_%s (srca, %s))", isa, isa, f1, isa, f0);
+}
+
+static void simd_load(const struct simdisa *isa, const char *ptr, int desc, const char *indent)
+{
+    char line[200];
+    if (desc)
+	sprintf(line, "%sv = bytes == $ * 2 ? bv_load_@ (%s - ($ - 1) * 2) : bv_loadn_@ (%s - bytes + 2, bytes, 1);", indent, ptr, ptr);
+    else
+	sprintf(line, "%sv = bytes == $ * 2 ? bv_load_@ (%s) : bv_loadn_@ (%s, bytes, 0);", indent, ptr, ptr);
+    simd_print(isa, line);
+}
+
+static void simd_shift(const struct simdisa *isa, const char *dst, const char *prev, const char *sh, int desc)
+{
+    char line[200];
+    if (desc)
+	sprintf(line, "\t\t\t\t%s = bv_or_@ (bv_shr_@ (bv_down_@ (v, %s), %s), bv_shl_@ (v, %sr));", dst, prev, sh, sh);
+    else
+	sprintf(line, "\t\t\t\t%s = bv_or_@ (bv_shr_@ (v, %s), bv_shl_@ (bv_up_@ (v, %s), %sr));", dst, sh, prev, sh);
+    simd_print(isa, line);
+    if (desc)
+	sprintf(line, "\t\t\t\t%s = bytes == $ * 2 ? bv_bottom_@ (v) : bv_lane_@ (v, $ - bytes / 2);", prev);
+    else
+	sprintf(line, "\t\t\t\t%s = bytes == $ * 2 ? bv_top_@ (v) : bv_lane_@ (v, bytes / 2 - 1);", prev);
+    simd_print(isa, line);
+}
+
+static void generate_simd_func(const struct simdisa *isa, int mt, int desc)
+{
+    int active = blitops[mt].used;
+    /* B is shifted even if the minterm ignores it, BLTBHOLD is kept */
+    int a_is_on = active & 1, b_is_on = 1, c_is_on = active & 4;
+    const char *dir = desc ? "-" : "+";
+    char expr[1000], line[1200];
+
+    simd_minterm(expr, isa->name, mt);
+    sprintf(line, "static BLITSIMD_TARGET_@ void blitsimd_@_%s%x (uae_u8 *pta, uae_u8 *ptb, uae_u8 *ptc, uae_u8 *ptd, struct bltinfo *b)",
+	desc ? "desc_" : "", mt);
+    simd_print(isa, line);
+    simd_print(isa, "{");
+    simd_print(isa, "\tint i, j, h = b->hblitsize;");
+    simd_print(isa, "\tuae_u32 totald = 0;");
+    simd_print(isa, "\tbvec_@ dacc = bv_zero_@ (), d;");
+    if (strstr(expr, "ones"))
+	simd_print(isa, "\tbvec_@ ones = bv_ones_@ ();");
+    if (a_is_on) {
+	simd_print(isa, "\tbvec_@ srca, aconst = bv_set1_@ (b->bltadat), mfirst, mlast;");
+	simd_print(isa, "\t__m128i ashift, ashiftr;");
+	simd_print(isa, "\tuae_u32 preva = 0;");
+	simd_print(isa, "\tuae_u16 lm[$];");
+    }
+    if (b_is_on) {
+	simd_print(isa, "\tbvec_@ srcb = bv_set1_@ (BLITSIMD_SWAP (b->bltbhold));");
+	simd_print(isa, "\t__m128i bshift, bshiftr;");
+	simd_print(isa, "\tuae_u32 prevb = 0;");
+    }
+    if (c_is_on)
+	simd_print(isa, "\tbvec_@ srcc = bv_set1_@ (BLITSIMD_SWAP (b->bltcdat));");
+    simd_print(isa, "");
+    if (a_is_on) {
+	sprintf(line, "\tashift = _mm_cvtsi32_si128 (b->%s);", desc ? "blitdownashift" : "blitashift");
+	simd_print(isa, line);
+	sprintf(line, "\tashiftr = _mm_cvtsi32_si128 (16 - b->%s);", desc ? "blitdownashift" : "blitashift");
+	simd_print(isa, line);
+	simd_print(isa, "\tfor (i = 0; i < $; i++)");
+	simd_print(isa, "\t\tlm[i] = 0xffff;");
+	simd_print(isa, desc ? "\tlm[$ - 1] = b->bltafwm;" : "\tlm[0] = b->bltafwm;");
+	simd_print(isa, "\tmfirst = bv_load_@ (lm);");
+	simd_print(isa, desc ? "\tlm[$ - 1] = 0xffff;" : "\tlm[0] = 0xffff;");
+	simd_print(isa, desc ? "\tlm[$ - 1 - (h - 1) % $] = b->bltalwm;" : "\tlm[(h - 1) % $] = b->bltalwm;");
+	simd_print(isa, "\tmlast = bv_load_@ (lm);");
+    }
+    if (b_is_on) {
+	sprintf(line, "\tbshift = _mm_cvtsi32_si128 (b->%s);", desc ? "blitdownbshift" : "blitbshift");
+	simd_print(isa, line);
+	sprintf(line, "\tbshiftr = _mm_cvtsi32_si128 (16 - b->%s);", desc ? "blitdownbshift" : "blitbshift");
+	simd_print(isa, line);
+    }
+    simd_print(isa, "\tfor (j = 0; j < b->vblitsize; j++) {");
+    simd_print(isa, "\t\tfor (i = 0; i < h; i += $) {");
+    simd_print(isa, "\t\t\tint bytes = h - i < $ ? (h - i) * 2 : $ * 2;");
+    if (c_is_on) {
+	simd_print(isa, "\t\t\tif (ptc) {");
+	simd_print(isa, "\t\t\t\tbvec_@ v;");
+	simd_load(isa, "ptc", desc, "\t\t\t\t");
+	simd_print(isa, "\t\t\t\tsrcc = v;");
+	sprintf(line, "\t\t\t\tptc %s= bytes;", dir);
+	simd_print(isa, line);
+	simd_print(isa, "\t\t\t}");
+    }
+    if (b_is_on) {
+	simd_print(isa, "\t\t\tif (ptb) {");
+	simd_print(isa, "\t\t\t\tbvec_@ v;");
+	simd_load(isa, "ptb", desc, "\t\t\t\t");
+	simd_print(isa, "\t\t\t\tv = bv_bswap_@ (v);");
+	simd_shift(isa, "srcb", "prevb", "bshift", desc);
+	simd_print(isa, "\t\t\t\tsrcb = bv_bswap_@ (srcb);");
+	sprintf(line, "\t\t\t\tptb %s= bytes;", dir);
+	simd_print(isa, line);
+	simd_print(isa, "\t\t\t}");
+    }
+    if (a_is_on) {
+	simd_print(isa, "\t\t\t{");
+	simd_print(isa, "\t\t\t\tbvec_@ v;");
+	simd_print(isa, "\t\t\t\tif (pta) {");
+	simd_load(isa, "pta", desc, "\t\t\t\t\t");
+	simd_print(isa, "\t\t\t\t\tv = bv_bswap_@ (v);");
+	sprintf(line, "\t\t\t\t\tpta %s= bytes;", dir);
+	simd_print(isa, line);
+	simd_print(isa, "\t\t\t\t} else {");
+	simd_print(isa, "\t\t\t\t\tv = aconst;");
+	simd_print(isa, "\t\t\t\t}");
+	simd_print(isa, "\t\t\t\tif (i == 0)");
+	simd_print(isa, "\t\t\t\t\tv = bv_and_@ (v, mfirst);");
+	simd_print(isa, "\t\t\t\tif (i + $ >= h)");
+	simd_print(isa, "\t\t\t\t\tv = bv_and_@ (v, mlast);");
+	simd_shift(isa, "srca", "preva", "ashift", desc);
+	simd_print(isa, "\t\t\t\tsrca = bv_bswap_@ (srca);");
+	simd_print(isa, "\t\t\t}");
+    }
+    sprintf(line, "\t\t\td = %s;", expr);
+    simd_print(isa, line);
+    simd_print(isa, "\t\t\tif (bytes == $ * 2) {");
+    simd_print(isa, "\t\t\t\tif (ptd)");
+    simd_print(isa, desc ? "\t\t\t\t\tbv_store_@ (ptd - ($ - 1) * 2, d);" : "\t\t\t\t\tbv_store_@ (ptd, d);");
+    simd_print(isa, "\t\t\t\tdacc = bv_or_@ (dacc, d);");
+    simd_print(isa, "\t\t\t} else {");
+    simd_print(isa, desc ? "\t\t\t\ttotald |= bv_storen_@ (ptd ? ptd - bytes + 2 : NULL, d, bytes, 1);"
+	: "\t\t\t\ttotald |= bv_storen_@ (ptd, d, bytes, 0);");
+    simd_print(isa, "\t\t\t}");
+    simd_print(isa, "\t\t\tif (ptd)");
+    sprintf(line, "\t\t\t\tptd %s= bytes;", dir);
+    simd_print(isa, line);
+    simd_print(isa, "\t\t}");
+    if (a_is_on) {
+	sprintf(line, "\t\tif (pta) pta %s= b->bltamod;", dir);
+	simd_print(isa, line);
+    }
+    if (b_is_on) {
+	sprintf(line, "\t\tif (ptb) ptb %s= b->bltbmod;", dir);
+	simd_print(isa, line);
+    }
+    if (c_is_on) {
+	sprintf(line, "\t\tif (ptc) ptc %s= b->bltcmod;", dir);
+	simd_print(isa, line);
+    }
+    sprintf(line, "\t\tif (ptd) ptd %s= b->bltdmod;", dir);
+    simd_print(isa, line);
+    simd_print(isa, "\t}");
+    if (b_is_on)
+	simd_print(isa, desc ? "\tb->bltbhold = BLITSIMD_SWAP (bv_lane_@ (srcb, $ - 1 - (h - 1) % $));"
+	    : "\tb->bltbhold = BLITSIMD_SWAP (bv_lane_@ (srcb, (h - 1) % $));");
+    simd_print(isa, desc ? "\tb->bltddat = BLITSIMD_SWAP (bv_lane_@ (d, $ - 1 - (h - 1) % $));"
+	: "\tb->bltddat = BLITSIMD_SWAP (bv_lane_@ (d, (h - 1) % $));");
+    simd_print(isa, "\tif (totald || bv_nonzero_@ (dacc))");
+    simd_print(isa, "\t\tb->blitzero = 0;");
+    simd_print(isa, "}");
+}
+
+static void generate_simd_table(const struct simdisa *isa, int desc)
+{
+    int i;
+    char line[200];
+
+    sprintf(line, "blitter_func_simd * const blitfunc_simd_@%s[256] = {", desc ? "_desc" : "");
+    simd_print(isa, line);
+    for (i = 0; i < 256; i++) {
+	sprintf(line, "blitsimd_@_%s%x%s", desc ? "desc_" : "", i, i < 255 ? ", " : "");
+	for (const char *p = line; *p; p++) {
+	    if (*p == '@')
+		printf("%s", isa->name);
+	    else
+		putchar(*p);
+	}
+	if ((i & 7) == 7) printf("\n");
+    }
+    printf("};\n");
+}
+
+static void generate_simd(void)
+{
+    unsigned int i;
+    int mt;
+
+    printf("#include \"sysconfig.h\"\n");
+    printf("#include \"sysdeps.h\"\n");
+    printf("#include \"options.h\"\n");
+    printf("#include \"custom.h\"\n");
+    printf("#include \"memory.h\"\n");
+    printf("#include \"blitter.h\"\n\n");
+    printf("#ifdef BLITTER_SIMD\n\n");
+    printf("#include <emmintrin.h>\n");
+    printf("#ifdef BLITTER_SIMD_AVX2\n");
+    printf("#include <immintrin.h>\n");
+    printf("#endif\n\n");
+    printf("#define BLITSIMD_TARGET_sse2 TARGET_SSE2\n");
+    printf("#define BLITSIMD_TARGET_avx2 TARGET_AVX2\n\n");
+    printf("#define BLITSIMD_SWAP(x) ((uae_u16)((((x) & 0xff) << 8) | (((x) >> 8) & 0xff)))\n\n");
+
+    for (i = 0; i < sizeof(simdisas) / sizeof(simdisas[0]); i++) {
+	const struct simdisa *isa = &simdisas[i];
+	const char **p;
+	if (isa->define)
+	    printf("#ifdef %s\n\n", isa->define);
+	for (p = isa->pre; *p; p++)
+	    simd_print(isa, *p);
+	printf("\n");
+	for (p = simd_helpers; *p; p++)
+	    simd_print(isa, *p);
+	printf("\n");
+	for (mt = 0; mt < 256; mt++) {
+	    generate_simd_func(isa, mt, 0);
+	    generate_simd_func(isa, mt, 1);
+	}
+	printf("\n");
+	generate_simd_table(isa, 0);
+	generate_simd_table(isa, 1);
+	if (isa->define)
+	    printf("\n#endif\n");
+	printf("\n");
+    }
+    printf("#endif\n");
+}
+
 static void generate_table(void)
 {
     unsigned int index = 0;
@@ -263,6 +645,8 @@ int main(int argc, char **argv)
 	       break;
      case 'h': generate_header();
 	       break;
+     case 's': generate_simd();
+	       break;
      default: abort();
     }
     return 0;
@@ -36,6 +36,8 @@ static int using_ce020;
 static int using_exception_3;
 static int using_ce;
 static int using_tracer;
+static int using_lazy_flags;
+static int using_decodecache;
 static int cpu_level;
 static int count_read, count_write, count_cycles, count_ncycles;
 static int count_read_ea, count_write_ea, count_cycles_ea;
@@ -60,6 +62,7 @@ static int next_cpu_level;
 static int *opcode_map;
 static int *opcode_next_clev;
 static int *opcode_last_postfix;
+static int *opcode_dc_length;
 static unsigned long *counts;
 static int generate_stbl;
 static int fixupcnt;
@@ -114,12 +117,76 @@ static void read_counts (void)
 		abort ();
 }
 
+/* Instruction pair profile, written by the emulator's pair profiler
+* (debugger "dp" command). The hottest pairs get fused handlers that
+* execute both instructions with one indirect call.
+*/
+#define MAX_FUSED 256
+
+struct fusedpair {
+	uae_u16 first, second;
+	unsigned long count;
+};
+static struct fusedpair fusedpairs[MAX_FUSED];
+static int nr_fusedpairs;
+
+static void read_pair_counts (void)
+{
+	FILE *file;
+	unsigned long first, second, count, total;
+	int i;
+
+	nr_fusedpairs = 0;
+	file = fopen ("frequent_pairs.68k", "r");
+	if (!file)
+		return;
+	if (fscanf (file, "Total: %lu\n", &total) != 1) {
+		fclose (file);
+		return;
+	}
+	while (nr_fusedpairs < MAX_FUSED && fscanf (file, "%lx %lx: %lu%*[^\n]\n", &first, &second, &count) == 3) {
+		if (first > 0xffff || second > 0xffff)
+			continue;
+		if (table68k[first].mnemo == i_ILLG || table68k[second].mnemo == i_ILLG)
+			continue;
+		/* file is sorted by count, keep only the hottest successor */
+		for (i = 0; i < nr_fusedpairs; i++) {
+			if (fusedpairs[i].first == first)
+				break;
+		}
+		if (i < nr_fusedpairs)
+			continue;
+		fusedpairs[nr_fusedpairs].first = (uae_u16)first;
+		fusedpairs[nr_fusedpairs].second = (uae_u16)second;
+		fusedpairs[nr_fusedpairs].count = count;
+		nr_fusedpairs++;
+	}
+	fclose (file);
+}
+
 static char endlabelstr[80];
 static int endlabelno = 0;
 static int need_endlabel;
 
 static int n_braces, limit_braces;
 static int m68k_pc_offset;
+
+/* Decode cache handlers read extension words from the cache entry as
+* long as offsets still count from the opcode. Entry size must match
+* DECODECACHE_EXT in newcpu.h.
+*/
+#define DC_EXT_BYTES 8
+static int dc_offset_valid;
+static int dc_length;
+
+static int dc_read (int r, int size)
+{
+	if (!using_decodecache || !dc_offset_valid || r < 2 || r + size > 2 + DC_EXT_BYTES)
+		return 0;
+	if (r + size > dc_length)
+		dc_length = r + size;
+	return 1;
+}
 static int insn_n_cycles, insn_n_cycles020;
 static int ir2irc;
 
@@ -268,7 +335,7 @@ static void gen_nextilong (char *type, char *name, int flags)
 			}
 		} else {
 			insn_n_cycles += 8;
-			printf ("\t%s %s = %s (%d);\n", type, name, prefetch_long, r);
+			printf ("\t%s %s = %s (%d);\n", type, name, dc_read (r, 4) ? "get_dilong" : prefetch_long, r);
 		}
 	}
 }
@@ -299,7 +366,7 @@ static const char *gen_nextiword (int flags)
 				insn_n_cycles += 4;
 			}
 		} else {
-			sprintf (buffer, "%s (%d)", prefetch_word, r);
+			sprintf (buffer, "%s (%d)", dc_read (r, 2) ? "get_diword" : prefetch_word, r);
 			insn_n_cycles += 4;
 		}
 	}
@@ -333,7 +400,7 @@ static const char *gen_nextibyte (int flags)
 				count_read++;
 			}
 		} else {
-			sprintf (buffer, "%s (%d)", srcbi, r);
+			sprintf (buffer, "%s (%d)", dc_read (r, 2) ? "get_dibyte" : srcbi, r);
 			insn_n_cycles += 4;
 		}
 	}
@@ -441,6 +508,7 @@ static void setpc (const char *format, ...)
 		printf ("\tm68k_setpc_mmu (%s);\n", buffer);
 	else
 		printf ("\tm68k_setpc (%s);\n", buffer);
+	dc_offset_valid = 0;
 }
 
 static void incpc (const char *format, ...)
@@ -456,10 +524,19 @@ static void incpc (const char *format, ...)
 		printf ("\tm68k_incpci (%s);\n", buffer);
 	else
 		printf ("\tm68k_incpc (%s);\n", buffer);
+	dc_offset_valid = 0;
+}
+
+/* PC was moved, later offsets don't count from the opcode */
+static void clear_pc_offset (void)
+{
+	m68k_pc_offset = 0;
+	dc_offset_valid = 0;
 }
 
 static void sync_m68k_pc (void)
 {
+	dc_offset_valid = 0;
 	if (m68k_pc_offset == 0)
 		return;
 	incpc ("%d", m68k_pc_offset);
@@ -472,7 +549,7 @@ static void gen_set_fault_pc (void)
 		return;
 	sync_m68k_pc ();
 	printf ("\tregs.instruction_pc = m68k_getpci ();\n");
-	m68k_pc_offset = 0;
+	clear_pc_offset ();
 }
 
 static void syncmovepc (int getv, int flags)
@@ -893,13 +970,13 @@ static void genastore_2 (char *from, amodes mode, char *reg, wordsizes size, cha
 		} else if (using_ce) {
 			switch (size) {
 			case sz_byte:
-				printf ("\tx_put_byte (%sa, %s);\n", to, from);
+				printf ("\t%s (%sa, %s);\n", dstb, to, from);
 				count_write++;
 				break;
 			case sz_word:
 				if (cpu_level < 2 && (mode == PC16 || mode == PC8r))
 					abort ();
-				printf ("\tx_put_word (%sa, %s);\n", to, from);
+				printf ("\t%s (%sa, %s);\n", dstw, to, from);
 				count_write++;
 				break;
 			case sz_long:
@@ -1221,6 +1298,26 @@ static void genflags_normal (flagtypes type, wordsizes size, char *value, char *
 		break;
 	}
 
+	if (using_lazy_flags) {
+		/* record operands only, CZNV is computed when read */
+		switch (type) {
+		case flag_logical:
+			printf ("\tSET_LAZY_FLAGS (FLAGOP_LOGICAL, %d, 0, 0, (uae_u32)(%s));\n", size, value);
+			return;
+		case flag_add:
+			printf ("\tSET_LAZY_FLAGS (FLAGOP_ADD, %d, %s, %s, %s);\n", size, usstr, udstr, value);
+			printf ("\tSET_XFLG (%s < %s);\n", undstr, usstr);
+			return;
+		case flag_sub:
+			printf ("\tSET_LAZY_FLAGS (FLAGOP_SUB, %d, %s, %s, %s);\n", size, usstr, udstr, value);
+			printf ("\tSET_XFLG (%s > %s);\n", usstr, udstr);
+			return;
+		case flag_cmp:
+			printf ("\tSET_LAZY_FLAGS (FLAGOP_SUB, %d, %s, %s, %s);\n", size, usstr, udstr, value);
+			return;
+		}
+	}
+
 	switch (type) {
 	case flag_logical_noclobber:
 	case flag_logical:
@@ -1579,6 +1676,8 @@ static void gen_opcode (unsigned long int opcode)
 
 	start_brace ();
 	m68k_pc_offset = 2;
+	dc_offset_valid = 1;
+	dc_length = 0;
 	switch (curi->plev) {
 	case 0: /* not privileged */
 		break;
@@ -2092,7 +2191,7 @@ static void gen_opcode (unsigned long int opcode)
 		sync_m68k_pc ();
 		printf ("\tException (src + 32);\n");
 		did_prefetch = 1;
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		break;
 	case i_MVR2USP:
 		genamode (curi->smode, "srcreg", curi->size, "src", 1, 0, 0);
@@ -2111,7 +2210,7 @@ static void gen_opcode (unsigned long int opcode)
 		addcycles000 (128);
 		if (using_prefetch) {
 			printf ("\t%s (2);\n", prefetch_word);
-			m68k_pc_offset = 0;
+			clear_pc_offset ();
 		}
 		break;
 	case i_NOP:
@@ -2189,7 +2288,7 @@ static void gen_opcode (unsigned long int opcode)
 		    need_endlabel = 1;
 		}
 		/* PC is set and prefetch filled. */
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 		break;
 	case i_RTD:
@@ -2212,7 +2311,7 @@ static void gen_opcode (unsigned long int opcode)
 		printf ("\t}\n");
 		setpc ("pc");
 		/* PC is set and prefetch filled. */
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 	    need_endlabel = 1;
 		break;
@@ -2268,7 +2367,7 @@ static void gen_opcode (unsigned long int opcode)
 		printf ("\t\texception3i (0x%04X, faultpc);\n", opcode);
 		printf ("\t}\n");
 		count_read += 2;
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 		break;
 	case i_TRAPV:
@@ -2295,7 +2394,7 @@ static void gen_opcode (unsigned long int opcode)
 		printf ("\t\tm68k_setpc (oldpc);\n");
 		printf ("\t\texception3i (0x%04X, faultpc);\n", opcode);
 		printf ("\t}\n");
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 		break;
 	case i_JSR: // TODO: check stack write order
@@ -2313,19 +2412,19 @@ static void gen_opcode (unsigned long int opcode)
 			printf ("\t%s (m68k_areg (regs, 7) - 4, oldpc);\n", dstl);
 			printf ("\tm68k_areg (regs, 7) -= 4;\n");
 			setpc ("srca");
-			m68k_pc_offset = 0;
+			clear_pc_offset ();
 		} else {
 			if (curi->smode == Ad16 || curi->smode == absw || curi->smode == PC16)
 				addcycles000 (2);
 			setpc ("srca");
-			m68k_pc_offset = 0;
+			clear_pc_offset ();
 			fill_prefetch_1 (0);
 			if (curi->smode == Ad8r || curi->smode == PC8r)
 				addcycles000 (6);
 			printf ("\tm68k_areg (regs, 7) -= 4;\n");
 			if (using_ce) {
-				printf ("\tx_put_word (m68k_areg (regs, 7), oldpc >> 16);\n");
-				printf ("\tx_put_word (m68k_areg (regs, 7) + 2, oldpc);\n");
+				printf ("\t%s (m68k_areg (regs, 7), oldpc >> 16);\n", dstw);
+				printf ("\t%s (m68k_areg (regs, 7) + 2, oldpc);\n", dstw);
 			} else {
 				printf ("\t%s (m68k_areg (regs, 7), oldpc);\n", dstl);
 			}
@@ -2345,7 +2444,7 @@ static void gen_opcode (unsigned long int opcode)
 		if (curi->smode == Ad16 || curi->smode == Ad8r || curi->smode == absw || curi->smode == PC16 || curi->smode == PC8r)
 			addcycles000 (2);
 		setpc ("srca");
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 		break;
 	case i_BSR:
@@ -2373,7 +2472,7 @@ static void gen_opcode (unsigned long int opcode)
 			printf ("\tm68k_do_bsr (m68k_getpc () + %d, s);\n", m68k_pc_offset);
 		}
 		count_write += 2;
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 		break;
 	case i_Bcc:
@@ -2415,6 +2514,8 @@ static void gen_opcode (unsigned long int opcode)
 				printf ("\treturn 10 * CYCLE_UNIT / 2;\n");
 		} else {
 			incpc ("(uae_s32)src + 2");
+			if (curi->size == sz_byte && curi->cc == 6 && !using_ce && !using_ce020 && !using_mmu)
+				printf ("\tif ((uae_s32)src == -4) delayloop_subq (m68k_getpc (), 10 * CYCLE_UNIT / 2);\n");
 			returncycles ("\t", 10);
 		}
 		printf ("didnt_jump:;\n");
@@ -2467,6 +2568,8 @@ static void gen_opcode (unsigned long int opcode)
 
 		printf ("\t\tif (src) {\n");
 		addcycles_ce020 (4);
+		if (!using_ce && !using_ce020 && !using_prefetch && !using_mmu)
+			printf ("\t\t\tif (offs == -2) delayloop_dbcc (srcreg, 12 * CYCLE_UNIT / 2);\n");
 		if (using_exception_3) {
 			printf ("\t\t\tif (offs & 1) {\n");
 			printf ("\t\t\t\texception3i (opcode, m68k_getpc () + 2 + (uae_s32)offs + 2);\n");
@@ -2486,7 +2589,7 @@ static void gen_opcode (unsigned long int opcode)
 		addcycles_ce020 (4);
 		printf ("\t}\n");
 		setpc ("oldpc + %d", m68k_pc_offset);
-		m68k_pc_offset = 0;
+		clear_pc_offset ();
 		fill_prefetch_full ();
 		insn_n_cycles = 12;
 		need_endlabel = 1;
@@ -3529,8 +3632,10 @@ static void gen_opcode (unsigned long int opcode)
 	did_prefetch = 0;
 }
 
-static void generate_includes (FILE * f)
+static void generate_includes (FILE * f, int direct)
 {
+	if (direct)
+		fprintf (f, "#define CPU_DIRECT\n");
 	fprintf (f, "#include \"sysconfig.h\"\n");
 	fprintf (f, "#include \"sysdeps.h\"\n");
 	fprintf (f, "#include \"options.h\"\n");
@@ -3682,7 +3787,11 @@ static void generate_one_opcode (int rp, char *extra)
 
 	if (opcode_next_clev[rp] != cpu_level) {
 		char *name = ua (lookuptab[idx].name);
-		if (generate_stbl)
+		if (generate_stbl && using_decodecache)
+			fprintf (stblfile, "{ CPUFUNC(op_%04x_%d%s), %d, %d }, /* %s */\n",
+			opcode, opcode_last_postfix[rp],
+			extra, opcode, opcode_dc_length[rp], name);
+		else if (generate_stbl)
 			fprintf (stblfile, "{ %sCPUFUNC(op_%04x_%d%s), %d }, /* %s */\n",
 			(using_ce || using_ce020) ? "(cpuop_func*)" : "",
 			opcode, opcode_last_postfix[rp],
@@ -3784,14 +3893,19 @@ static void generate_one_opcode (int rp, char *extra)
 		printf("#endif\n");
 	opcode_next_clev[rp] = next_cpu_level;
 	opcode_last_postfix[rp] = postfix;
+	opcode_dc_length[rp] = dc_length;
 
 	if (generate_stbl) {
 		char *name = ua (lookuptab[idx].name);
 		if (i68000)
 			fprintf (stblfile, "#ifndef CPUEMU_68000_ONLY\n");
-		fprintf (stblfile, "{ %sCPUFUNC(op_%04x_%d%s), %d }, /* %s */\n",
-			(using_ce || using_ce020) ? "(cpuop_func*)" : "",
-			opcode, postfix, extra, opcode, name);
+		if (using_decodecache)
+			fprintf (stblfile, "{ CPUFUNC(op_%04x_%d%s), %d, %d }, /* %s */\n",
+				opcode, postfix, extra, opcode, dc_length, name);
+		else
+			fprintf (stblfile, "{ %sCPUFUNC(op_%04x_%d%s), %d }, /* %s */\n",
+				(using_ce || using_ce020) ? "(cpuop_func*)" : "",
+				opcode, postfix, extra, opcode, name);
 		if (i68000)
 			fprintf (stblfile, "#endif\n");
 		xfree (name);
@@ -3832,6 +3946,79 @@ static void generate_func (char *extra)
 		fprintf (stblfile, "{ 0, 0 }};\n");
 }
 
+static int fused_rp (int opcode)
+{
+	int rp;
+
+	if (table68k[opcode].handler != -1)
+		opcode = table68k[opcode].handler;
+	for (rp = 0; rp < nr_cpuop_funcs; rp++) {
+		if (opcode_map[rp] == opcode)
+			return rp;
+	}
+	return -1;
+}
+
+/* Fused pair handlers for the plain (no prefetch, no CE, no MMU) tables.
+* Second instruction is only executed if nothing special is pending and
+* it really is the next opcode, otherwise we return to the main loop.
+* Must be called after generate_func () because function names come
+* from opcode_last_postfix[].
+*/
+static void generate_fused (char *extra)
+{
+	int i;
+
+	if (generate_stbl)
+		fprintf (stblfile, "const struct cputbl_fused CPUFUNC(op_fusedtbl_%d%s)[] = {\n", postfix, extra);
+	printf ("#ifdef PART_8\n");
+	for (i = 0; i < nr_fusedpairs; i++) {
+		struct fusedpair *fp = &fusedpairs[i];
+		int rp1 = fused_rp (fp->first);
+		int rp2 = fused_rp (fp->second);
+		int i68000;
+
+		if (rp1 < 0 || rp2 < 0)
+			continue;
+		if (table68k[fp->first].clev > cpu_level || table68k[fp->second].clev > cpu_level)
+			continue;
+		i68000 = table68k[fp->first].clev > 0 || table68k[fp->second].clev > 0;
+
+		fprintf (headerfile, "extern cpuop_func op_%04x_%04x_%d%s_nf;\n", fp->first, fp->second, postfix, extra);
+		fprintf (headerfile, "extern cpuop_func op_%04x_%04x_%d%s_ff;\n", fp->first, fp->second, postfix, extra);
+		printf ("/* %s", outopcode (fp->first));
+		printf (" + %s (%lu) */\n", outopcode (fp->second), fp->count);
+		if (i68000)
+			printf ("#ifndef CPUEMU_68000_ONLY\n");
+		printf ("unsigned long REGPARAM2 CPUFUNC(op_%04x_%04x_%d%s)(uae_u32 opcode)\n{\n", fp->first, fp->second, postfix, extra);
+		printf ("\tunsigned long cycles = CPUFUNC(op_%04x_%d%s)(opcode);\n", opcode_map[rp1], opcode_last_postfix[rp1], extra);
+		printf ("\tif (regs.spcflags)\n");
+		printf ("\t\treturn cycles;\n");
+		printf ("\tdo_cycles (cycles);\n");
+		printf ("\tif (regs.spcflags || get_iword (0) != 0x%04x)\n", fp->second);
+		printf ("\t\treturn 0;\n");
+		printf ("\tregs.instruction_pc = m68k_getpc ();\n");
+		/* cached extension words belong to the first instruction */
+		printf ("\treturn CPUFUNC(op_%04x_%d%s)(0x%04x);\n", opcode_map[rp2], opcode_last_postfix[rp2], using_decodecache ? "" : extra, fp->second);
+		printf ("}\n");
+		if (i68000)
+			printf ("#endif\n");
+		printf ("\n");
+
+		if (generate_stbl) {
+			if (i68000)
+				fprintf (stblfile, "#ifndef CPUEMU_68000_ONLY\n");
+			fprintf (stblfile, "{ CPUFUNC(op_%04x_%04x_%d%s), 0x%04x, 0x%04x },\n",
+				fp->first, fp->second, postfix, extra, fp->first, fp->second);
+			if (i68000)
+				fprintf (stblfile, "#endif\n");
+		}
+	}
+	printf ("#endif\n\n");
+	if (generate_stbl)
+		fprintf (stblfile, "{ 0, 0, 0 }};\n");
+}
+
 static void generate_cpu (int id, int mode)
 {
 	char fname[100];
@@ -3839,13 +4026,23 @@ static void generate_cpu (int id, int mode)
 	static int postfix2 = -1;
 	int rp;
 
-	using_tracer = mode;
+	using_tracer = mode == 1;
+	using_lazy_flags = mode == 2;
+	using_decodecache = mode == 3;
 	extra = "";
 	extraup = "";
 	if (using_tracer) {
 		extra = "_t";
 		extraup = "_T";
 	}
+	if (using_lazy_flags) {
+		extra = "_l";
+		extraup = "_L";
+	}
+	if (using_decodecache) {
+		extra = "_d";
+		extraup = "_D";
+	}
 
 	postfix = id;
 	if (id == 0 || id == 11 || id == 12 || id == 20 || id == 21 || id == 31) {
@@ -3854,7 +4051,9 @@ static void generate_cpu (int id, int mode)
 		postfix2 = postfix;
 		sprintf (fname, "cpuemu_%d%s.cpp", postfix, extra);
 		freopen (fname, "wb", stdout);
-		generate_includes (stdout);
+		if (!using_lazy_flags)
+			printf ("#define CPU_NOLAZYFLAGS\n");
+		generate_includes (stdout, !using_tracer);
 	}
 
 	using_mmu = 0;
@@ -3895,7 +4094,8 @@ static void generate_cpu (int id, int mode)
 	} else {
 		cpu_level = 5 - id; // "generic"
 	}
-	using_indirect = using_ce && !using_ce020;
+	// only tracer tables go through x_* function pointers
+	using_indirect = using_tracer && (using_ce || using_ce020);
 
 	if (generate_stbl) {
 		if ((id > 0 && id < 10) || (id >= 20))
@@ -3903,6 +4103,8 @@ static void generate_cpu (int id, int mode)
 		fprintf (stblfile, "const struct cputbl CPUFUNC(op_smalltbl_%d%s)[] = {\n", postfix, extra);
 	}
 	generate_func (extra);
+	if (id < 10 && !using_tracer)
+		generate_fused (extra);
 	if (generate_stbl) {
 		if ((id > 0 && id < 10) || (id >= 20))
 			fprintf (stblfile, "#endif /* CPUEMU_68000_ONLY */\n");
@@ -3921,9 +4123,11 @@ int main (int argc, char **argv)
 
 	opcode_map =  xmalloc (int, nr_cpuop_funcs);
 	opcode_last_postfix = xmalloc (int, nr_cpuop_funcs);
+	opcode_dc_length = xmalloc (int, nr_cpuop_funcs);
 	opcode_next_clev = xmalloc (int, nr_cpuop_funcs);
 	counts = xmalloc (unsigned long, 65536);
 	read_counts ();
+	read_pair_counts ();
 
 	/* It would be a lot nicer to put all in one file (we'd also get rid of
 	* cputbl.h that way), but cpuopti can't cope.  That could be fixed, but
@@ -3932,7 +4136,7 @@ int main (int argc, char **argv)
 	headerfile = fopen ("cputbl.h", "wb");
 
 	stblfile = fopen ("cpustbl.cpp", "wb");
-	generate_includes (stblfile);
+	generate_includes (stblfile, 0);
 
 	using_prefetch = 0;
 	using_indirect = 0;
@@ -3945,6 +4149,26 @@ int main (int argc, char **argv)
 		generate_stbl = 1;
 		generate_cpu (i, 0);
 	}
+	/* cycle-exact tables for the CPU tracer, memory and cycle functions
+	* are called through x_* pointers */
+	generate_stbl = 1;
+	generate_cpu (12, 1);
+	generate_stbl = 1;
+	generate_cpu (20, 1);
+	/* same tables again with lazy CZNV evaluation */
+	read_counts ();
+	for (i = 0; i < 32; i++) {
+		if ((i >= 6 && i < 11) || (i > 12 && i < 20) || (i > 23 && i < 31))
+			continue;
+		generate_stbl = 1;
+		generate_cpu (i, 2);
+	}
+	/* generic tables once more for the decode cache run loop */
+	read_counts ();
+	for (i = 0; i < 6; i++) {
+		generate_stbl = 1;
+		generate_cpu (i, 3);
+	}
 
 	free (table68k);
 	return 0;
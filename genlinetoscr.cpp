@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 /* Output for big-endian target if true, little-endian is false. */
 int do_bigendian;
@@ -79,6 +80,166 @@ typedef enum
 } CMODE_T;
 #define CMODE_MAX CMODE_HAM
 
+/* SIMD variants. Each 32-bit vector lane holds one source pixel,
+* colour lookups are gathers. Only generated for little-endian x86. */
+typedef struct
+{
+	const char *name;
+	const char *define;
+	const char *vtype;
+	int width;
+} SIMD_T;
+
+static const SIMD_T simd_sse2 = { "sse2", "LINETOSCR_SIMD", "__m128i", 4 };
+static const SIMD_T simd_avx2 = { "avx2", "LINETOSCR_SIMD_AVX2", "__m256i", 8 };
+
+static const char *simd_helpers_sse2[] = {
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_set1_sse2 (int v) { return _mm_set1_epi32 (v); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_and_sse2 (__m128i a, __m128i b) { return _mm_and_si128 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_andnot_sse2 (__m128i a, __m128i b) { return _mm_andnot_si128 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_or_sse2 (__m128i a, __m128i b) { return _mm_or_si128 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_xor_sse2 (__m128i a, __m128i b) { return _mm_xor_si128 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_add_sse2 (__m128i a, __m128i b) { return _mm_add_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_sub_sse2 (__m128i a, __m128i b) { return _mm_sub_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_srl_sse2 (__m128i a, int n) { return _mm_srl_epi32 (a, _mm_cvtsi32_si128 (n)); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_sll_sse2 (__m128i a, int n) { return _mm_sll_epi32 (a, _mm_cvtsi32_si128 (n)); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_cmpeq_sse2 (__m128i a, __m128i b) { return _mm_cmpeq_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_cmpgt_sse2 (__m128i a, __m128i b) { return _mm_cmpgt_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_select_sse2 (__m128i mask, __m128i a, __m128i b)",
+	"{",
+	"	return _mm_or_si128 (_mm_and_si128 (mask, a), _mm_andnot_si128 (mask, b));",
+	"}",
+	"/* No gather instruction, look up lane by lane */",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_gather_sse2 (const void *table, __m128i idx)",
+	"{",
+	"	const uae_u32 *t = (const uae_u32*)table;",
+	"	return _mm_setr_epi32 (t[_mm_cvtsi128_si32 (idx)], t[_mm_cvtsi128_si32 (_mm_srli_si128 (idx, 4))],",
+	"		t[_mm_cvtsi128_si32 (_mm_srli_si128 (idx, 8))], t[_mm_cvtsi128_si32 (_mm_srli_si128 (idx, 12))]);",
+	"}",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_gather16_sse2 (const uae_u16 *t, __m128i idx)",
+	"{",
+	"	return _mm_setr_epi32 (t[_mm_cvtsi128_si32 (idx)], t[_mm_cvtsi128_si32 (_mm_srli_si128 (idx, 4))],",
+	"		t[_mm_cvtsi128_si32 (_mm_srli_si128 (idx, 8))], t[_mm_cvtsi128_si32 (_mm_srli_si128 (idx, 12))]);",
+	"}",
+	"/* 4 source pixels, 1, 2 or 4 bytes per lane (low byte first) */",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_src8_sse2 (const uae_u8 *p)",
+	"{",
+	"	__m128i z = _mm_setzero_si128 ();",
+	"	return _mm_unpacklo_epi16 (_mm_unpacklo_epi8 (_mm_cvtsi32_si128 (*(const int*)p), z), z);",
+	"}",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_src16_sse2 (const uae_u8 *p)",
+	"{",
+	"	return _mm_unpacklo_epi16 (_mm_loadl_epi64 ((const __m128i*)p), _mm_setzero_si128 ());",
+	"}",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_src32_sse2 (const uae_u8 *p) { return _mm_loadu_si128 ((const __m128i*)p); }",
+	"STATIC_INLINE TARGET_SSE2 __m128i lts_ham_sse2 (const uae_u32 *p, int step)",
+	"{",
+	"	if (step == 1)",
+	"		return _mm_loadu_si128 ((const __m128i*)p);",
+	"	return _mm_setr_epi32 (p[0], p[step], p[step * 2], p[step * 3]);",
+	"}",
+	"STATIC_INLINE TARGET_SSE2 void lts_store32_sse2 (void *p, __m128i v) { _mm_storeu_si128 ((__m128i*)p, v); }",
+	"STATIC_INLINE TARGET_SSE2 void lts_store16_sse2 (uae_u16 *p, __m128i v)",
+	"{",
+	"	v = _mm_srai_epi32 (_mm_slli_epi32 (v, 16), 16);",
+	"	_mm_storel_epi64 ((__m128i*)p, _mm_packs_epi32 (v, v));",
+	"}",
+	"/* true if none of the n spritepixels entries has sprite data */",
+	"STATIC_INLINE TARGET_SSE2 int lts_nosprites_sse2 (const struct spritepixelsbuf *p, int n)",
+	"{",
+	"	__m128i v = _mm_setzero_si128 ();",
+	"	for (int i = 0; i < n; i += 4)",
+	"		v = _mm_or_si128 (v, _mm_loadu_si128 ((const __m128i*)(p + i)));",
+	"	return (_mm_movemask_epi8 (_mm_cmpeq_epi16 (v, _mm_setzero_si128 ())) & 0xcccc) == 0xcccc;",
+	"}",
+	NULL
+};
+
+static const char *simd_helpers_avx2[] = {
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_set1_avx2 (int v) { return _mm256_set1_epi32 (v); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_and_avx2 (__m256i a, __m256i b) { return _mm256_and_si256 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_andnot_avx2 (__m256i a, __m256i b) { return _mm256_andnot_si256 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_or_avx2 (__m256i a, __m256i b) { return _mm256_or_si256 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_xor_avx2 (__m256i a, __m256i b) { return _mm256_xor_si256 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_add_avx2 (__m256i a, __m256i b) { return _mm256_add_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_sub_avx2 (__m256i a, __m256i b) { return _mm256_sub_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_srl_avx2 (__m256i a, int n) { return _mm256_srl_epi32 (a, _mm_cvtsi32_si128 (n)); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_sll_avx2 (__m256i a, int n) { return _mm256_sll_epi32 (a, _mm_cvtsi32_si128 (n)); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_cmpeq_avx2 (__m256i a, __m256i b) { return _mm256_cmpeq_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_cmpgt_avx2 (__m256i a, __m256i b) { return _mm256_cmpgt_epi32 (a, b); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_select_avx2 (__m256i mask, __m256i a, __m256i b) { return _mm256_blendv_epi8 (b, a, mask); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_gather_avx2 (const void *table, __m256i idx) { return _mm256_i32gather_epi32 ((const int*)table, idx, 4); }",
+	"/* reads 2 bytes past the entry, callers only use this inside struct color_entry */",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_gather16_avx2 (const uae_u16 *t, __m256i idx)",
+	"{",
+	"	return _mm256_and_si256 (_mm256_i32gather_epi32 ((const int*)t, idx, 2), _mm256_set1_epi32 (0xffff));",
+	"}",
+	"/* 8 source pixels, 1, 2 or 4 bytes per lane (low byte first) */",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_src8_avx2 (const uae_u8 *p) { return _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i*)p)); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_src16_avx2 (const uae_u8 *p) { return _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i*)p)); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_src32_avx2 (const uae_u8 *p) { return _mm256_loadu_si256 ((const __m256i*)p); }",
+	"STATIC_INLINE TARGET_AVX2 __m256i lts_ham_avx2 (const uae_u32 *p, int step)",
+	"{",
+	"	if (step == 1)",
+	"		return _mm256_loadu_si256 ((const __m256i*)p);",
+	"	return _mm256_i32gather_epi32 ((const int*)p, _mm256_mullo_epi32 (_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32 (step)), 4);",
+	"}",
+	"STATIC_INLINE TARGET_AVX2 void lts_store32_avx2 (void *p, __m256i v) { _mm256_storeu_si256 ((__m256i*)p, v); }",
+	"STATIC_INLINE TARGET_AVX2 void lts_store16_avx2 (uae_u16 *p, __m256i v)",
+	"{",
+	"	v = _mm256_and_si256 (v, _mm256_set1_epi32 (0xffff));",
+	"	_mm_storeu_si128 ((__m128i*)p, _mm_packus_epi32 (_mm256_castsi256_si128 (v), _mm256_extracti128_si256 (v, 1)));",
+	"}",
+	"/* true if none of the n spritepixels entries has sprite data */",
+	"STATIC_INLINE TARGET_AVX2 int lts_nosprites_avx2 (const struct spritepixelsbuf *p, int n)",
+	"{",
+	"	__m256i v = _mm256_setzero_si256 ();",
+	"	for (int i = 0; i < n; i += 8)",
+	"		v = _mm256_or_si256 (v, _mm256_loadu_si256 ((const __m256i*)(p + i)));",
+	"	return _mm256_testz_si256 (v, _mm256_set1_epi32 (0xffff0000));",
+	"}",
+	NULL
+};
+
+/* ISA independent helpers, '@' is replaced with the ISA name. */
+static const char *simd_helpers_common[] = {
+	"/* merge_2pixel32 () */",
+	"STATIC_INLINE TARGET_@ VEC lts_merge32_@ (VEC a, VEC b)",
+	"{",
+	"	VEC v = lts_add_@ (lts_and_@ (a, b), lts_srl_@ (lts_and_@ (lts_xor_@ (a, b), lts_set1_@ (0xfefefe)), 1));",
+	"	return lts_and_@ (v, lts_set1_@ (0xffffff));",
+	"}",
+	"STATIC_INLINE TARGET_@ VEC lts_merge16c_@ (VEC a, VEC b, int s, int m)",
+	"{",
+	"	VEC mask = lts_set1_@ (m);",
+	"	VEC v = lts_add_@ (lts_and_@ (lts_srl_@ (a, s), mask), lts_and_@ (lts_srl_@ (b, s), mask));",
+	"	return lts_sll_@ (lts_srl_@ (v, 1), s);",
+	"}",
+	"/* merge_2pixel16 () */",
+	"STATIC_INLINE TARGET_@ VEC lts_merge16_@ (VEC a, VEC b)",
+	"{",
+	"	VEC v = lts_merge16c_@ (a, b, xredcolor_s, xredcolor_m);",
+	"	v = lts_or_@ (v, lts_merge16c_@ (a, b, xbluecolor_s, xbluecolor_m));",
+	"	return lts_or_@ (v, lts_merge16c_@ (a, b, xgreencolor_s, xgreencolor_m));",
+	"}",
+	"#ifdef AGA",
+	"/* CONVERT_RGB () */",
+	"STATIC_INLINE TARGET_@ VEC lts_rgb_@ (VEC c)",
+	"{",
+	"	VEC mask = lts_set1_@ (0xff);",
+	"	VEC v = lts_gather_@ (xbluecolors, lts_and_@ (c, mask));",
+	"	v = lts_or_@ (v, lts_gather_@ (xgreencolors, lts_and_@ (lts_srl_@ (c, 8), mask)));",
+	"	return lts_or_@ (v, lts_gather_@ (xredcolors, lts_and_@ (lts_srl_@ (c, 16), mask)));",
+	"}",
+	"#endif",
+	NULL
+};
+
+static const char *simd_target (const SIMD_T *isa)
+{
+	return isa == &simd_avx2 ? "AVX2" : "SSE2";
+}
+
 
 static FILE *outfile;
 static unsigned int outfile_indent = 0;
@@ -114,11 +275,55 @@ void outlnf (const char *s, ...)
 	fputc ('\n', outfile);
 }
 
-static void out_linetoscr_decl (DEPTH_T bpp, HMODE_T hmode, int aga, int spr)
+static void out_simd_helpers (const SIMD_T *isa, const char **lines)
+{
+	for (; *lines; lines++) {
+		const char *s;
+		for (s = *lines; *s; s++) {
+			if (*s == '@')
+				fputs (isa->name, outfile);
+			else if (s[0] == 'V' && s[1] == 'E' && s[2] == 'C') {
+				fputs (isa->vtype, outfile);
+				s += 2;
+			} else if (s[0] == 'T' && !strncmp (s, "TARGET_@", 8)) {
+				fprintf (outfile, "TARGET_%s", simd_target (isa));
+				s += 7;
+			} else
+				fputc (*s, outfile);
+		}
+		fputc ('\n', outfile);
+	}
+}
+
+static void out_simd_preamble (void)
+{
+	const SIMD_T *isas[] = { &simd_sse2, &simd_avx2 };
+	int i;
+
+	outln ("#ifdef LINETOSCR_SIMD");
+	outln ("");
+	outln ("/* Vector helpers, each 32-bit lane holds one pixel */");
+	outln ("");
+	for (i = 0; i < 2; i++) {
+		if (isas[i] == &simd_avx2)
+			outln ("#ifdef LINETOSCR_SIMD_AVX2");
+		out_simd_helpers (isas[i], isas[i] == &simd_avx2 ? simd_helpers_avx2 : simd_helpers_sse2);
+		out_simd_helpers (isas[i], simd_helpers_common);
+		if (isas[i] == &simd_avx2)
+			outln ("#endif");
+		outln ("");
+	}
+	outln ("#endif");
+	outln ("");
+}
+
+static void out_linetoscr_decl (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, const SIMD_T *isa)
 {
-	outlnf ("static int NOINLINE linetoscr_%s%s%s%s (int spix, int dpix, int stoppos)",
+	outlnf ("static int NOINLINE %slinetoscr_%s%s%s%s%s%s (int spix, int dpix, int stoppos)",
+		isa ? (isa == &simd_avx2 ? "TARGET_AVX2 " : "TARGET_SSE2 ") : "",
 		get_depth_str (bpp),
-		get_hmode_str (hmode), aga ? "_aga" : "", spr ? "_spr" : "");
+		get_hmode_str (hmode), aga ? "_aga" : "", spr ? "_spr" : "",
+		isa ? "_" : "", isa ? isa->name : "");
 }
 
 static void out_linetoscr_do_srcpix (DEPTH_T bpp, HMODE_T hmode, int aga, CMODE_T cmode, int spr)
@@ -282,40 +487,9 @@ static void out_sprite (DEPTH_T bpp, HMODE_T hmode, CMODE_T cmode, int aga, int
 	}
 }
 
-static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CMODE_T cmode)
+static void out_linetoscr_loop (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CMODE_T cmode, const char *stop)
 {
-	int old_indent = set_indent (8);
-
-	if (aga && cmode == CMODE_DUALPF) {
-		outln (        "int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;");
-		outln (        "int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;");
-	} else if (cmode == CMODE_DUALPF)
-		outln (        "int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;");
-
-
-	/* TODO: add support for combining pixel writes in 8-bpp modes. */
-
-	if (bpp == DEPTH_16BPP && hmode != HMODE_DOUBLE && hmode != HMODE_DOUBLE2X && spr == 0) {
-		outln (		"int rem;");
-		outln (		"if (((long)&buf[dpix]) & 2) {");
-		outln (		"    uae_u32 spix_val;");
-		outln (		"    uae_u32 dpix_val;");
-
-		out_linetoscr_do_srcpix (bpp, hmode, aga, cmode, spr);
-		out_linetoscr_do_dstpix (bpp, hmode, aga, cmode, spr);
-		out_linetoscr_do_incspix (bpp, hmode, aga, cmode, spr);
-
-		outln (		"    buf[dpix++] = dpix_val;");
-		outln (		"}");
-		outln (		"if (dpix >= stoppos)");
-		outln (		"    return spix;");
-		outln (		"rem = (((long)&buf[stoppos]) & 2);");
-		outln (		"if (rem)");
-		outln (		"    stoppos--;");
-	}
-
-
-	outln (		"while (dpix < stoppos) {");
+	outlnf (	"while (dpix < %s) {", stop);
 	if (spr)
 		outln (		"    uae_u32 sprpix_val;");
 	outln (		"    uae_u32 spix_val;");
@@ -400,6 +574,186 @@ static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CM
 	}
 
 	outln (		"}");
+}
+
+static void out_linetoscr_simd_pixel (DEPTH_T bpp, int aga, CMODE_T cmode, const SIMD_T *isa, int step, int sel, const char *dst)
+{
+	const char *n = isa->name;
+	const char *v = isa->vtype;
+
+	outln (		"    {");
+	if (cmode == CMODE_HAM) {
+		outlnf (	"        %s h = lts_ham_%s (&ham_linebuf[spix + %d], %d);", v, n, sel, step);
+		if (aga)
+			outlnf ("        %s = lts_rgb_%s (h);", dst, n);
+		else
+			outlnf ("        %s = lts_gather_%s (xcolors, h);", dst, n);
+		outln (		"    }");
+		return;
+	}
+	if (step == 1) {
+		outlnf (	"        %s s = lts_src8_%s (&pixdata.apixels[spix]);", v, n);
+	} else if (step == 2) {
+		outlnf (	"        %s s = lts_src16_%s (&pixdata.apixels[spix]);", v, n);
+		if (sel)
+			outlnf ("        s = lts_srl_%s (s, 8);", n);
+		else
+			outlnf ("        s = lts_and_%s (s, lts_set1_%s (0xff));", n, n);
+	} else {
+		outlnf (	"        %s s = lts_src32_%s (&pixdata.apixels[spix]);", v, n);
+		if (sel)
+			outlnf ("        s = lts_srl_%s (s, %d);", n, sel * 8);
+		if (sel < 3)
+			outlnf ("        s = lts_and_%s (s, lts_set1_%s (0xff));", n, n);
+	}
+	if (aga && cmode != CMODE_DUALPF)
+		outlnf (	"        s = lts_xor_%s (s, lts_set1_%s (xor_val));", n, n);
+
+	if (aga && cmode == CMODE_DUALPF) {
+		outlnf (	"        %s val = lts_gather_%s (lookup, s);", v, n);
+		outlnf (	"        %s no = lts_cmpeq_%s (lts_gather_%s (lookup_no, s), lts_set1_%s (0));", v, n, n, n);
+		outlnf (	"        val = lts_add_%s (val, lts_andnot_%s (no, lts_set1_%s (dblpfofs[bpldualpf2of])));", n, n, n);
+		outlnf (	"        val = lts_and_%s (lts_xor_%s (val, lts_set1_%s (xor_val)), lts_set1_%s (0xff));", n, n, n, n);
+		outlnf (	"        %s = lts_gather_%s (colors_for_drawing.acolors, val);", dst, n);
+	} else if (cmode == CMODE_DUALPF) {
+		outlnf (	"        %s = lts_gather_%s (colors_for_drawing.acolors, lts_gather_%s (lookup, s));", dst, n, n);
+	} else if (aga && cmode == CMODE_EXTRAHB) {
+		outlnf (	"        %s ehb = lts_andnot_%s (lts_cmpgt_%s (s, lts_set1_%s (63)), lts_cmpgt_%s (s, lts_set1_%s (31)));", v, n, n, n, n, n);
+		outlnf (	"        %s e = lts_gather_%s (colors_for_drawing.color_regs_aga, lts_and_%s (lts_sub_%s (s, lts_set1_%s (32)), ehb));", v, n, n, n, n);
+		outlnf (	"        e = lts_rgb_%s (lts_and_%s (lts_srl_%s (e, 1), lts_set1_%s (0x7F7F7F)));", n, n, n, n);
+		outlnf (	"        %s = lts_select_%s (ehb, e, lts_gather_%s (colors_for_drawing.acolors, s));", dst, n, n);
+	} else if (cmode == CMODE_EXTRAHB) {
+		outlnf (	"        %s ehb = lts_cmpgt_%s (s, lts_set1_%s (31));", v, n, n);
+		outlnf (	"        %s e = lts_gather16_%s (colors_for_drawing.color_regs_ecs, lts_and_%s (lts_sub_%s (s, lts_set1_%s (32)), ehb));", v, n, n, n, n);
+		outlnf (	"        e = lts_gather_%s (xcolors, lts_and_%s (lts_srl_%s (e, 1), lts_set1_%s (0x777)));", n, n, n, n);
+		outlnf (	"        %s = lts_select_%s (ehb, e, lts_gather_%s (colors_for_drawing.acolors, lts_andnot_%s (ehb, s)));", dst, n, n, n);
+	} else {
+		outlnf (	"        %s = lts_gather_%s (colors_for_drawing.acolors, s);", dst, n);
+	}
+	outln (		"    }");
+}
+
+static void out_linetoscr_simd_dup (const SIMD_T *isa, int mul, int k, char *out)
+{
+	if (isa == &simd_avx2) {
+		int j, p;
+		p = sprintf (out, "_mm256_permutevar8x32_epi32 (c, _mm256_setr_epi32 (");
+		for (j = 0; j < 8; j++)
+			p += sprintf (out + p, "%d%s", (k * 8 + j) / mul, j < 7 ? ", " : "))");
+	} else {
+		sprintf (out, "_mm_shuffle_epi32 (c, 0x%02x)", mul == 2 ? (k ? 0xfa : 0x50) : 0x55 * k);
+	}
+}
+
+/* Vector loop, leaves the remaining pixels to the scalar loop.
+* Sprite variants fall back to the scalar code for each block
+* that has sprite pixels. */
+static void out_linetoscr_simd (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CMODE_T cmode, const SIMD_T *isa)
+{
+	const char *n = isa->name;
+	int w = isa->width;
+	int step = (hmode == HMODE_HALVE1 || hmode == HMODE_HALVE1F) ? 2 : (hmode == HMODE_HALVE2 || hmode == HMODE_HALVE2F) ? 4 : 1;
+	int mul = hmode == HMODE_DOUBLE ? 2 : hmode == HMODE_DOUBLE2X ? 4 : 1;
+	int cnt = w * mul;
+	const char *merge = bpp == DEPTH_16BPP ? "lts_merge16" : "lts_merge32";
+	char dup[200];
+	int k;
+
+	outlnf (	"while (stoppos - dpix >= %d) {", cnt);
+	outlnf (	"    %s c;", isa->vtype);
+	if (hmode == HMODE_HALVE1F)
+		outlnf ("    %s c0, c1;", isa->vtype);
+	else if (hmode == HMODE_HALVE2F)
+		outlnf ("    %s c0, c1, c2, c3;", isa->vtype);
+	if (spr) {
+		int old_indent;
+		outlnf ("    if (!lts_nosprites_%s (&spritepixels[dpix], %d)) {", n, cnt);
+		outlnf ("        int endpos = dpix + %d;", cnt);
+		old_indent = set_indent (outfile_indent + 8);
+		out_linetoscr_loop (bpp, hmode, aga, spr, cmode, "endpos");
+		set_indent (old_indent);
+		outln (	"        continue;");
+		outln (	"    }");
+	}
+	if (hmode == HMODE_HALVE1F) {
+		out_linetoscr_simd_pixel (bpp, aga, cmode, isa, step, 0, "c0");
+		out_linetoscr_simd_pixel (bpp, aga, cmode, isa, step, 1, "c1");
+		outlnf ("    c = %s_%s (c0, c1);", merge, n);
+	} else if (hmode == HMODE_HALVE2F) {
+		for (k = 0; k < 4; k++) {
+			char dst[4];
+			sprintf (dst, "c%d", k);
+			out_linetoscr_simd_pixel (bpp, aga, cmode, isa, step, k, dst);
+		}
+		outlnf ("    c = %s_%s (%s_%s (c0, c1), %s_%s (c2, c3));", merge, n, merge, n, merge, n);
+	} else {
+		out_linetoscr_simd_pixel (bpp, aga, cmode, isa, step, 0, "c");
+	}
+
+	if (bpp == DEPTH_16BPP) {
+		/* 16-bit colour values are duplicated in both halves,
+		* doubled pixels are stored as 32-bit words like the scalar code does. */
+		if (mul == 1) {
+			outlnf ("    lts_store16_%s (&buf[dpix], c);", n);
+		} else if (mul == 2) {
+			outlnf ("    lts_store32_%s (&buf[dpix], c);", n);
+		} else {
+			for (k = 0; k < 2; k++) {
+				out_linetoscr_simd_dup (isa, 2, k, dup);
+				outlnf ("    lts_store32_%s (&buf[dpix + %d], %s);", n, k * w * 2, dup);
+			}
+		}
+	} else {
+		if (mul == 1) {
+			outlnf ("    lts_store32_%s (&buf[dpix], c);", n);
+		} else {
+			for (k = 0; k < mul; k++) {
+				out_linetoscr_simd_dup (isa, mul, k, dup);
+				outlnf ("    lts_store32_%s (&buf[dpix + %d], %s);", n, k * w, dup);
+			}
+		}
+	}
+	outlnf (	"    spix += %d;", w * step);
+	outlnf (	"    dpix += %d;", cnt);
+	outln (		"}");
+}
+
+static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CMODE_T cmode, const SIMD_T *isa)
+{
+	int old_indent = set_indent (8);
+
+	if (aga && cmode == CMODE_DUALPF) {
+		outln (        "int *lookup    = bpldualpfpri ? dblpf_ind2_aga : dblpf_ind1_aga;");
+		outln (        "int *lookup_no = bpldualpfpri ? dblpf_2nd2     : dblpf_2nd1;");
+	} else if (cmode == CMODE_DUALPF)
+		outln (        "int *lookup = bpldualpfpri ? dblpf_ind2 : dblpf_ind1;");
+
+
+	/* TODO: add support for combining pixel writes in 8-bpp modes. */
+
+	if (bpp == DEPTH_16BPP && hmode != HMODE_DOUBLE && hmode != HMODE_DOUBLE2X && spr == 0) {
+		outln (		"int rem;");
+		outln (		"if (((long)&buf[dpix]) & 2) {");
+		outln (		"    uae_u32 spix_val;");
+		outln (		"    uae_u32 dpix_val;");
+
+		out_linetoscr_do_srcpix (bpp, hmode, aga, cmode, spr);
+		out_linetoscr_do_dstpix (bpp, hmode, aga, cmode, spr);
+		out_linetoscr_do_incspix (bpp, hmode, aga, cmode, spr);
+
+		outln (		"    buf[dpix++] = dpix_val;");
+		outln (		"}");
+		outln (		"if (dpix >= stoppos)");
+		outln (		"    return spix;");
+		outln (		"rem = (((long)&buf[stoppos]) & 2);");
+		outln (		"if (rem)");
+		outln (		"    stoppos--;");
+	}
+
+
+	if (isa)
+		out_linetoscr_simd (bpp, hmode, aga, spr, cmode, isa);
+	out_linetoscr_loop (bpp, hmode, aga, spr, cmode, "stoppos");
 
 
 	if (bpp == DEPTH_16BPP && hmode != HMODE_DOUBLE && hmode != HMODE_DOUBLE2X && spr == 0) {
@@ -420,13 +774,28 @@ static void out_linetoscr_mode (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, CM
 	return;
 }
 
-static void out_linetoscr (DEPTH_T bpp, HMODE_T hmode, int aga, int spr)
+static void out_linetoscr_call (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, const SIMD_T *isa)
+{
+	outlnf (	"#ifdef %s", isa->define);
+	outlnf (	"    if (linetoscr_simd >= HOST_SIMD_%s)", simd_target (isa));
+	outlnf (	"        return linetoscr_%s%s%s%s_%s (spix, dpix, stoppos);",
+		get_depth_str (bpp), get_hmode_str (hmode), aga ? "_aga" : "", spr ? "_spr" : "", isa->name);
+	outln  (	"#endif");
+}
+
+static void out_linetoscr (DEPTH_T bpp, HMODE_T hmode, int aga, int spr, const SIMD_T *isa)
 {
 	if (aga)
 		outln  ("#ifdef AGA");
+	if (isa)
+		outlnf ("#ifdef %s", isa->define);
 
-	out_linetoscr_decl (bpp, hmode, aga, spr);
+	out_linetoscr_decl (bpp, hmode, aga, spr, isa);
 	outln  (	"{");
+	if (!isa && !do_bigendian) {
+		out_linetoscr_call (bpp, hmode, aga, spr, &simd_avx2);
+		out_linetoscr_call (bpp, hmode, aga, spr, &simd_sse2);
+	}
 
 	outlnf (	"    %s *buf = (%s *) xlinebuffer;", get_depth_type_str (bpp), get_depth_type_str (bpp));
 	if (spr)
@@ -436,18 +805,20 @@ static void out_linetoscr (DEPTH_T bpp, HMODE_T hmode, int aga, int spr)
 	outln  (	"");
 
 	outln  (	"    if (dp_for_drawing->ham_seen) {");
-	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_HAM);
+	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_HAM, isa);
 	outln  (	"    } else if (bpldualpf) {");
-	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_DUALPF);
+	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_DUALPF, isa);
 	outln  (	"    } else if (bplehb) {");
-	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_EXTRAHB);
+	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_EXTRAHB, isa);
 	outln  (	"    } else {");
-	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_NORMAL);
+	out_linetoscr_mode (bpp, hmode, aga, spr, CMODE_NORMAL, isa);
 
 	outln  (	"    }\n");
 	outln  (	"    return spix;");
 	outln  (	"}");
 
+	if (isa)
+		outln (	"#endif");
 	if (aga)
 		outln (	"#endif");
 	outln  (	"");
@@ -478,13 +849,21 @@ int main (int argc, char *argv[])
 	outln (" */");
 	outln ("");
 
+	if (!do_bigendian)
+		out_simd_preamble ();
+
 	for (bpp = DEPTH_16BPP; bpp <= DEPTH_MAX; bpp++) {
 		for (aga = 0; aga <= 1 ; aga++) {
 			if (aga && bpp == DEPTH_8BPP)
 				continue;
 			for (spr = 0; spr <= 1; spr++) {
-				for (hmode = HMODE_NORMAL; hmode <= HMODE_MAX; hmode++)
-					out_linetoscr (bpp, hmode, aga, spr);
+				for (hmode = HMODE_NORMAL; hmode <= HMODE_MAX; hmode++) {
+					if (!do_bigendian) {
+						out_linetoscr (bpp, hmode, aga, spr, &simd_sse2);
+						out_linetoscr (bpp, hmode, aga, spr, &simd_avx2);
+					}
+					out_linetoscr (bpp, hmode, aga, spr, NULL);
+				}
 			}
 		}
 	}
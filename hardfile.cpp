@@ -930,10 +930,13 @@ static uae_u64 cmd_readx (struct hardfiledata *hfd, uae_u8 *dataptr, uae_u64 off
 }
 static uae_u64 cmd_read (struct hardfiledata *hfd, uaecptr dataptr, uae_u64 offset, uae_u64 len)
 {
+	uae_u64 v;
 	addrbank *bank_data = &get_mem_bank (dataptr);
 	if (!bank_data || !bank_data->check (dataptr, len))
 		return 0;
-	return cmd_readx (hfd, bank_data->xlateaddr (dataptr), offset, len);
+	v = cmd_readx (hfd, bank_data->xlateaddr (dataptr), offset, len);
+	flush_dcache (dataptr, (int)len);
+	return v;
 }
 static uae_u64 cmd_writex (struct hardfiledata *hfd, uae_u8 *dataptr, uae_u64 offset, uae_u64 len)
 {
@@ -1322,6 +1325,8 @@ static int handle_scsi (uaecptr request, struct hardfiledata *hfd)
 	scsi_log (L"\n");
 
 	status = scsi_emulate (hfd, NULL, cmdbuf, scsi_cmd_len, scsi_data_ptr, &scsi_len, reply, &reply_len, sense, &sense_len);
+	if (scsi_data_ptr)
+		flush_dcache (scsi_data, scsi_len);
 
 	put_word (acmd + 18, status != 0 ? 0 : scsi_cmd_len); /* fake scsi_CmdActual */
 	put_byte (acmd + 21, status); /* scsi_Status */
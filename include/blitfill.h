@@ -0,0 +1,115 @@
+/*
+* Blitter area fill, table driven one word at a time and with SSE2 eight
+* lines at once. Included by blitter.cpp and test_simd.cpp.
+*/
+
+static uae_u8 blit_filltable[256][4][2];
+
+/* area fill one word, fc is the fill carry in and out */
+STATIC_INLINE uae_u16 blitter_fill_word (uae_u16 d, int ifemode, int *fc)
+{
+	int fc1 = blit_filltable[d & 255][ifemode + *fc][1];
+	uae_u16 v = blit_filltable[d & 255][ifemode + *fc][0] + (blit_filltable[d >> 8][ifemode + fc1][0] << 8);
+	*fc = blit_filltable[d >> 8][ifemode + fc1][1];
+	return v;
+}
+
+static void blitter_filltable_init (void)
+{
+	unsigned int d, fillmask;
+	int i;
+
+	for (d = 0; d < 256; d++) {
+		for (i = 0; i < 4; i++) {
+			int fc = i & 1;
+			uae_u8 data = d;
+			for (fillmask = 1; fillmask != 0x100; fillmask <<= 1) {
+				uae_u16 tmp = data;
+				if (fc) {
+					if (i & 2)
+						data |= fillmask;
+					else
+						data ^= fillmask;
+				}
+				if (tmp & fillmask) fc = !fc;
+			}
+			blit_filltable[d][i][0] = data;
+			blit_filltable[d][i][1] = fc;
+		}
+	}
+}
+
+#ifdef BLITTER_SIMD
+#include <emmintrin.h>
+
+/* Eight lines at once, one 16-bit lane per line. With fill carry c (all
+ * ones or zero) exclusive fill is the running xor of the word from bit 0
+ * up xored with c, inclusive fill ORs that into the data. Returns the
+ * number of lines done. */
+static int TARGET_SSE2 blitter_fill_sse2 (uae_u8 *p, int lines, int words, int wordstep, int linestep, int ife, int fci,
+	uae_u16 *lastd, int *lastfc, int *nz)
+{
+	__m128i any = _mm_setzero_si128 ();
+	__m128i c = _mm_setzero_si128 ();
+	__m128i out = _mm_setzero_si128 ();
+	uae_u16 v[8];
+	int i, j, k;
+
+	for (j = 0; j + 8 <= lines; j += 8) {
+		uae_u8 *q = p + j * linestep;
+		c = _mm_set1_epi16 (fci ? -1 : 0);
+		for (i = 0; i < words; i++, q += wordstep) {
+			__m128i d, x;
+			d = _mm_setr_epi16 (
+				do_get_mem_word ((uae_u16*)(q + 0 * linestep)), do_get_mem_word ((uae_u16*)(q + 1 * linestep)),
+				do_get_mem_word ((uae_u16*)(q + 2 * linestep)), do_get_mem_word ((uae_u16*)(q + 3 * linestep)),
+				do_get_mem_word ((uae_u16*)(q + 4 * linestep)), do_get_mem_word ((uae_u16*)(q + 5 * linestep)),
+				do_get_mem_word ((uae_u16*)(q + 6 * linestep)), do_get_mem_word ((uae_u16*)(q + 7 * linestep)));
+			x = _mm_xor_si128 (d, _mm_slli_epi16 (d, 1));
+			x = _mm_xor_si128 (x, _mm_slli_epi16 (x, 2));
+			x = _mm_xor_si128 (x, _mm_slli_epi16 (x, 4));
+			x = _mm_xor_si128 (x, _mm_slli_epi16 (x, 8));
+			x = _mm_xor_si128 (x, c);
+			out = ife ? _mm_or_si128 (d, x) : x;
+			c = _mm_srai_epi16 (x, 15);
+			any = _mm_or_si128 (any, out);
+			_mm_storeu_si128 ((__m128i*)v, out);
+			for (k = 0; k < 8; k++)
+				do_put_mem_word ((uae_u16*)(q + k * linestep), v[k]);
+		}
+	}
+	if (j > 0) {
+		*lastd = _mm_extract_epi16 (out, 7);
+		*lastfc = _mm_extract_epi16 (c, 7) & 1;
+		*nz |= _mm_movemask_epi8 (_mm_cmpeq_epi16 (any, _mm_setzero_si128 ())) != 0xffff;
+	}
+	return j;
+}
+
+/* Fill lines of words in place, SSE2 for groups of eight lines and
+ * blitter_fill_word () for the rest. lastd and lastfc return the last
+ * word and fill carry, returns nonzero if any filled word is nonzero. */
+static int blitter_fill_area (uae_u8 *p, int lines, int words, int wordstep, int linestep, int ife, int fci,
+	uae_u16 *lastd, int *lastfc)
+{
+	int ifemode = ife ? 2 : 0;
+	int fc = fci, nz = 0;
+	uae_u16 d = *lastd;
+	int i, j;
+
+	j = blitter_fill_sse2 (p, lines, words, wordstep, linestep, ife, fci, &d, &fc, &nz);
+	for (; j < lines; j++) {
+		uae_u8 *q = p + j * linestep;
+		fc = fci;
+		for (i = 0; i < words; i++, q += wordstep) {
+			d = blitter_fill_word (do_get_mem_word ((uae_u16*)q), ifemode, &fc);
+			do_put_mem_word ((uae_u16*)q, d);
+			nz |= d;
+		}
+	}
+	*lastd = d;
+	*lastfc = fc;
+	return nz;
+}
+
+#endif
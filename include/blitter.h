@@ -48,6 +48,24 @@ typedef void blitter_func(uaecptr, uaecptr, uaecptr, uaecptr, struct bltinfo *);
 
 extern blitter_func * const blitfunc_dofast[256];
 extern blitter_func * const blitfunc_dofast_desc[256];
+
+#ifdef HAVE_SSE2_INTRINSICS
+#define BLITTER_SIMD
+#ifdef HAVE_AVX2_INTRINSICS
+#define BLITTER_SIMD_AVX2
+#endif
+#endif
+
+#ifdef BLITTER_SIMD
+/* same as blitter_func but with host pointers into chip RAM, NULL = channel off */
+typedef void blitter_func_simd(uae_u8 *, uae_u8 *, uae_u8 *, uae_u8 *, struct bltinfo *);
+extern blitter_func_simd * const blitfunc_simd_sse2[256];
+extern blitter_func_simd * const blitfunc_simd_sse2_desc[256];
+#ifdef BLITTER_SIMD_AVX2
+extern blitter_func_simd * const blitfunc_simd_avx2[256];
+extern blitter_func_simd * const blitfunc_simd_avx2_desc[256];
+#endif
+#endif
 extern uae_u32 blit_masktable[BLITTER_MAX_WORDS];
 
 #define BLIT_MODE_IMMEDIATE -1
@@ -12,22 +12,36 @@ STATIC_INLINE uae_u32 get_long_prefetch (int o)
 	return v;
 }
 
+/* Generated cycle-exact tables are compiled with CPU_DIRECT and call
+* memory and cycle functions directly. CPU tracer tables and the CPU
+* core itself go through the x_* function pointers.
+*/
+#ifdef CPU_DIRECT
+#define ce_do_cycles(c) do_cycles_ce (c)
+#define ce_do_cycles_pre(c) do_cycles_ce (c)
+#define ce_do_cycles_post(c, v) do_cycles_ce (c)
+#else
+#define ce_do_cycles(c) x_do_cycles (c)
+#define ce_do_cycles_pre(c) x_do_cycles_pre (c)
+#define ce_do_cycles_post(c, v) x_do_cycles_post (c, v)
+#endif
+
 #ifdef CPUEMU_20
 
 STATIC_INLINE void do_cycles_ce020 (int clocks)
 {
-	x_do_cycles (clocks * cpucycleunit);
+	ce_do_cycles (clocks * cpucycleunit);
 }
 STATIC_INLINE void do_cycles_ce020_mem (int clocks, uae_u32 val)
 {
 	regs.ce020memcycles -= clocks * cpucycleunit;
-	x_do_cycles_post (clocks * cpucycleunit, val);
+	ce_do_cycles_post (clocks * cpucycleunit, val);
 }
 
 STATIC_INLINE void checkcycles_ce020 (void)
 {
 	if (regs.ce020memcycles > 0)
-		x_do_cycles_pre (regs.ce020memcycles);
+		ce_do_cycles_pre (regs.ce020memcycles);
 	regs.ce020memcycles = 0;
 }
 
@@ -274,12 +288,20 @@ STATIC_INLINE uae_u32 next_ilong_020ce (void)
 STATIC_INLINE void m68k_do_bsr_ce020 (uaecptr oldpc, uae_s32 offset)
 {
 	m68k_areg (regs, 7) -= 4;
+#ifdef CPU_DIRECT
+	put_long_ce020 (m68k_areg (regs, 7), oldpc);
+#else
 	x_put_long (m68k_areg (regs, 7), oldpc);
+#endif
 	m68k_incpc (offset);
 }
 STATIC_INLINE void m68k_do_rts_ce020 (void)
 {
+#ifdef CPU_DIRECT
+	m68k_setpc (get_long_ce020 (m68k_areg (regs, 7)));
+#else
 	m68k_setpc (x_get_long (m68k_areg (regs, 7)));
+#endif
 	m68k_areg (regs, 7) += 4;
 }
 
@@ -359,7 +381,7 @@ STATIC_INLINE void m68k_do_rts_ce030 (void)
 
 STATIC_INLINE void do_cycles_ce000 (int clocks)
 {
-	x_do_cycles (clocks * cpucycleunit);
+	ce_do_cycles (clocks * cpucycleunit);
 }
 
 STATIC_INLINE void ipl_fetch (void)
@@ -376,7 +398,7 @@ STATIC_INLINE uae_u32 mem_access_delay_word_read (uaecptr addr)
 	case CE_MEMBANK_FAST:
 	case CE_MEMBANK_FAST16BIT:
 		uae_u32 v = get_word (addr);
-		x_do_cycles_post (4 * cpucycleunit, v);
+		ce_do_cycles_post (4 * cpucycleunit, v);
 		return v;
 	}
 	return get_word (addr);
@@ -390,7 +412,7 @@ STATIC_INLINE uae_u32 mem_access_delay_wordi_read (uaecptr addr)
 	case CE_MEMBANK_FAST:
 	case CE_MEMBANK_FAST16BIT:
 		uae_u32 v = get_wordi (addr);
-		x_do_cycles_post (4 * cpucycleunit, v);
+		ce_do_cycles_post (4 * cpucycleunit, v);
 		return v;
 	}
 	return get_wordi (addr);
@@ -405,7 +427,7 @@ STATIC_INLINE uae_u32 mem_access_delay_byte_read (uaecptr addr)
 	case CE_MEMBANK_FAST:
 	case CE_MEMBANK_FAST16BIT:
 		uae_u32 v = get_byte (addr);
-		x_do_cycles_post (4 * cpucycleunit, v);
+		ce_do_cycles_post (4 * cpucycleunit, v);
 		return v;
 	}
 	return get_byte (addr);
@@ -420,7 +442,7 @@ STATIC_INLINE void mem_access_delay_byte_write (uaecptr addr, uae_u32 v)
 	case CE_MEMBANK_FAST:
 	case CE_MEMBANK_FAST16BIT:
 		put_byte (addr, v);
-		x_do_cycles_post (4 * cpucycleunit, v);
+		ce_do_cycles_post (4 * cpucycleunit, v);
 		return;
 	}
 	put_byte (addr, v);
@@ -435,7 +457,7 @@ STATIC_INLINE void mem_access_delay_word_write (uaecptr addr, uae_u32 v)
 	case CE_MEMBANK_FAST:
 	case CE_MEMBANK_FAST16BIT:
 		put_word (addr, v);
-		x_do_cycles_post (4 * cpucycleunit, v);
+		ce_do_cycles_post (4 * cpucycleunit, v);
 		return;
 	}
 	put_word (addr, v);
@@ -462,7 +484,11 @@ STATIC_INLINE uae_u32 get_byte_ce000 (uaecptr addr)
 STATIC_INLINE uae_u32 get_word_ce000_prefetch (int o)
 {
 	uae_u32 v = regs.irc;
+#ifdef CPU_DIRECT
+	regs.irc = get_wordi_ce000 (o);
+#else
 	regs.irc = x_get_iword (o);
+#endif
 	return v;
 }
 
@@ -483,8 +509,13 @@ STATIC_INLINE void put_byte_ce000 (uaecptr addr, uae_u32 v)
 STATIC_INLINE void m68k_do_rts_ce (void)
 {
 	uaecptr pc;
+#ifdef CPU_DIRECT
+	pc = get_word_ce000 (m68k_areg (regs, 7)) << 16;
+	pc |= get_word_ce000 (m68k_areg (regs, 7) + 2);
+#else
 	pc = x_get_word (m68k_areg (regs, 7)) << 16;
 	pc |= x_get_word (m68k_areg (regs, 7) + 2);
+#endif
 	m68k_areg (regs, 7) += 4;
 	if (pc & 1)
 		exception3 (0x4e75, pc);
@@ -495,16 +526,26 @@ STATIC_INLINE void m68k_do_rts_ce (void)
 STATIC_INLINE void m68k_do_bsr_ce (uaecptr oldpc, uae_s32 offset)
 {
 	m68k_areg (regs, 7) -= 4;
+#ifdef CPU_DIRECT
+	put_word_ce000 (m68k_areg (regs, 7), oldpc >> 16);
+	put_word_ce000 (m68k_areg (regs, 7) + 2, oldpc);
+#else
 	x_put_word (m68k_areg (regs, 7), oldpc >> 16);
 	x_put_word (m68k_areg (regs, 7) + 2, oldpc);
+#endif
 	m68k_incpc (offset);
 }
 
 STATIC_INLINE void m68k_do_jsr_ce (uaecptr oldpc, uaecptr dest)
 {
 	m68k_areg (regs, 7) -= 4;
+#ifdef CPU_DIRECT
+	put_word_ce000 (m68k_areg (regs, 7), oldpc >> 16);
+	put_word_ce000 (m68k_areg (regs, 7) + 2, oldpc);
+#else
 	x_put_word (m68k_areg (regs, 7), oldpc >> 16);
 	x_put_word (m68k_areg (regs, 7) + 2, oldpc);
+#endif
 	m68k_setpc (dest);
 }
 
@@ -192,6 +192,10 @@ struct mmu_atc_line {
 	unsigned hw : 1;
 	unsigned bus_fault : 1;
 	uaecptr phys;
+	/* L1 hits since the last refill or "dmt", only counted in L1 lines */
+	uae_u32 hits;
+	/* host address of this 4k page if RAM (ROM for reads), NULL = use bank handlers */
+	uae_u8 *host;
 };
 
 /*
@@ -294,6 +298,11 @@ extern void REGPARAM3 mmu_flush_atc_all(bool global) REGPARAM;
 extern void REGPARAM3 mmu_op_real(uae_u32 opcode, uae_u16 extra) REGPARAM;
 
 extern void REGPARAM3 mmu_reset(void) REGPARAM;
+extern void mmu_tt_modified(void);
+extern void mmu_flush_host_tlb(void);
+extern void mmu_set_host_tlb(bool enable);
+extern void mmu_tlb_stats(void);
+
 extern void REGPARAM3 mmu_set_tc(uae_u16 tc) REGPARAM;
 extern void REGPARAM3 mmu_set_super(bool super) REGPARAM;
 
@@ -332,12 +341,70 @@ static ALWAYS_INLINE uae_u32 phys_get_byte(uaecptr addr)
     return byteget (addr);
 }
 
+static ALWAYS_INLINE uae_u8 *mmu_get_host_address(uaecptr addr, struct mmu_atc_line *cl)
+{
+    return cl->host + (addr & 0xfff);
+}
+
+/* L1 atc hit: direct host access if possible, otherwise bank handlers */
+static ALWAYS_INLINE uae_u32 mmu_phys_get_long(uaecptr addr, struct mmu_atc_line *cl)
+{
+	cl->hits++;
+	if (likely(cl->host != NULL)) {
+		return do_get_mem_long((uae_u32*)mmu_get_host_address(addr, cl));
+	}
+	return phys_get_long(mmu_get_real_address(addr, cl));
+}
+static ALWAYS_INLINE uae_u32 mmu_phys_get_word(uaecptr addr, struct mmu_atc_line *cl)
+{
+	cl->hits++;
+	if (likely(cl->host != NULL)) {
+		return do_get_mem_word((uae_u16*)mmu_get_host_address(addr, cl));
+	}
+	return phys_get_word(mmu_get_real_address(addr, cl));
+}
+static ALWAYS_INLINE uae_u32 mmu_phys_get_byte(uaecptr addr, struct mmu_atc_line *cl)
+{
+	cl->hits++;
+	if (likely(cl->host != NULL)) {
+		return do_get_mem_byte(mmu_get_host_address(addr, cl));
+	}
+	return phys_get_byte(mmu_get_real_address(addr, cl));
+}
+static ALWAYS_INLINE void mmu_phys_put_long(uaecptr addr, uae_u32 val, struct mmu_atc_line *cl)
+{
+	cl->hits++;
+	if (likely(cl->host != NULL)) {
+		do_put_mem_long((uae_u32*)mmu_get_host_address(addr, cl), val);
+		return;
+	}
+	phys_put_long(mmu_get_real_address(addr, cl), val);
+}
+static ALWAYS_INLINE void mmu_phys_put_word(uaecptr addr, uae_u32 val, struct mmu_atc_line *cl)
+{
+	cl->hits++;
+	if (likely(cl->host != NULL)) {
+		do_put_mem_word((uae_u16*)mmu_get_host_address(addr, cl), val);
+		return;
+	}
+	phys_put_word(mmu_get_real_address(addr, cl), val);
+}
+static ALWAYS_INLINE void mmu_phys_put_byte(uaecptr addr, uae_u32 val, struct mmu_atc_line *cl)
+{
+	cl->hits++;
+	if (likely(cl->host != NULL)) {
+		do_put_mem_byte(mmu_get_host_address(addr, cl), val);
+		return;
+	}
+	phys_put_byte(mmu_get_real_address(addr, cl), val);
+}
+
 static ALWAYS_INLINE uae_u32 mmu_get_long(uaecptr addr, bool data, int size)
 {
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_lookup(addr, data, false, &cl)))
-		return phys_get_long(mmu_get_real_address(addr, cl));
+		return mmu_phys_get_long(addr, cl);
 	return mmu_get_long_slow(addr, regs.s != 0, data, size, cl);
 }
 
@@ -346,7 +413,7 @@ static ALWAYS_INLINE uae_u16 mmu_get_word(uaecptr addr, bool data, int size)
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_lookup(addr, data, false, &cl)))
-		return phys_get_word(mmu_get_real_address(addr, cl));
+		return mmu_phys_get_word(addr, cl);
 	return mmu_get_word_slow(addr, regs.s != 0, data, size, cl);
 }
 
@@ -355,7 +422,7 @@ static ALWAYS_INLINE uae_u8 mmu_get_byte(uaecptr addr, bool data, int size)
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_lookup(addr, data, false, &cl)))
-		return phys_get_byte(mmu_get_real_address(addr, cl));
+		return mmu_phys_get_byte(addr, cl);
 	return mmu_get_byte_slow(addr, regs.s != 0, data, size, cl);
 }
 
@@ -365,7 +432,7 @@ static ALWAYS_INLINE void mmu_put_long(uaecptr addr, uae_u32 val, bool data, int
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_lookup(addr, data, true, &cl)))
-		phys_put_long(mmu_get_real_address(addr, cl), val);
+		mmu_phys_put_long(addr, val, cl);
 	else
 		mmu_put_long_slow(addr, val, regs.s != 0, data, size, cl);
 }
@@ -375,7 +442,7 @@ static ALWAYS_INLINE void mmu_put_word(uaecptr addr, uae_u16 val, bool data, int
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_lookup(addr, data, true, &cl)))
-		phys_put_word(mmu_get_real_address(addr, cl), val);
+		mmu_phys_put_word(addr, val, cl);
 	else
 		mmu_put_word_slow(addr, val, regs.s != 0, data, size, cl);
 }
@@ -385,7 +452,7 @@ static ALWAYS_INLINE void mmu_put_byte(uaecptr addr, uae_u8 val, bool data, int
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_lookup(addr, data, true, &cl)))
-		phys_put_byte(mmu_get_real_address(addr, cl), val);
+		mmu_phys_put_byte(addr, val, cl);
 	else
 		mmu_put_byte_slow(addr, val, regs.s != 0, data, size, cl);
 }
@@ -395,7 +462,7 @@ static ALWAYS_INLINE uae_u32 mmu_get_user_long(uaecptr addr, bool super, bool da
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_user_lookup(addr, super, data, false, &cl)))
-		return phys_get_long(mmu_get_real_address(addr, cl));
+		return mmu_phys_get_long(addr, cl);
 	return mmu_get_long_slow(addr, super, data, size, cl);
 }
 
@@ -404,7 +471,7 @@ static ALWAYS_INLINE uae_u16 mmu_get_user_word(uaecptr addr, bool super, bool da
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_user_lookup(addr, super, data, false, &cl)))
-		return phys_get_word(mmu_get_real_address(addr, cl));
+		return mmu_phys_get_word(addr, cl);
 	return mmu_get_word_slow(addr, super, data, size, cl);
 }
 
@@ -413,7 +480,7 @@ static ALWAYS_INLINE uae_u8 mmu_get_user_byte(uaecptr addr, bool super, bool dat
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_user_lookup(addr, super, data, false, &cl)))
-		return phys_get_byte(mmu_get_real_address(addr, cl));
+		return mmu_phys_get_byte(addr, cl);
 	return mmu_get_byte_slow(addr, super, data, size, cl);
 }
 
@@ -422,7 +489,7 @@ static ALWAYS_INLINE void mmu_put_user_long(uaecptr addr, uae_u32 val, bool supe
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_user_lookup(addr, super, data, true, &cl)))
-		phys_put_long(mmu_get_real_address(addr, cl), val);
+		mmu_phys_put_long(addr, val, cl);
 	else
 		mmu_put_long_slow(addr, val, super, data, size, cl);
 }
@@ -432,7 +499,7 @@ static ALWAYS_INLINE void mmu_put_user_word(uaecptr addr, uae_u16 val, bool supe
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_user_lookup(addr, super, data, true, &cl)))
-		phys_put_word(mmu_get_real_address(addr, cl), val);
+		mmu_phys_put_word(addr, val, cl);
 	else
 		mmu_put_word_slow(addr, val, super, data, size, cl);
 }
@@ -442,7 +509,7 @@ static ALWAYS_INLINE void mmu_put_user_byte(uaecptr addr, uae_u8 val, bool super
 	struct mmu_atc_line *cl;
 
 	if (likely(mmu_user_lookup(addr, super, data, true, &cl)))
-		phys_put_byte(mmu_get_real_address(addr, cl), val);
+		mmu_phys_put_byte(addr, val, cl);
 	else
 		mmu_put_byte_slow(addr, val, super, data, size, cl);
 }
@@ -25,9 +25,11 @@ extern void dumpcustom (void);
 
 extern void do_disk (void);
 extern void do_copper (void);
+extern void copper_stats (void);
 
 extern void notice_new_xcolors (void);
 extern void notice_screen_contents_lost (void);
+extern void drawing_line_stats (void);
 extern void init_row_map (void);
 extern void init_hz_full (void);
 extern void init_custom (void);
@@ -212,5 +214,8 @@ struct customhack {
 void customhack_put (struct customhack *ch, uae_u16 v, int hpos);
 uae_u16 customhack_get (struct customhack *ch, int hpos);
 extern void alloc_cycle_ext (int, int);
+extern void cycle_line_clear (void);
+extern int cycle_line_next_used (int hpos, int limit);
+extern int bitplane_dma_free_until (int hpos);
 extern bool ispal (void);
 extern int current_maxvpos (void);
\ No newline at end of file
@@ -273,7 +273,9 @@ extern void vsync_handle_redraw (int long_frame, int lof_changed);
 extern void init_hardware_for_drawing_frame (void);
 extern void reset_drawing (void);
 extern void drawing_init (void);
+extern void drawing_free (void);
 extern void notice_interlace_seen (void);
+extern void notice_new_drawing_colors (void);
 extern void frame_drawn (void);
 extern void redraw_frame (void);
 extern int get_custom_limits (int *pw, int *ph, int *pdx, int *pdy);
@@ -47,6 +47,11 @@ struct ev2
     evt evtime;
     uae_u32 data;
     evfunc2 handler;
+    /* scheduler private: position in pending heap, insertion order */
+    int heapidx;
+    unsigned int seq;
+    bool dynamic;
+    struct ev2 *next;
 };
 
 enum {
@@ -54,9 +59,10 @@ enum {
     ev_max
 };
 
+/* fixed eventtab2 slots, event2_newevent2 () events are allocated dynamically */
 enum {
-    ev2_blitter, ev2_disk, ev2_misc,
-    ev2_max = 12
+    ev2_blitter, ev2_disk, ev2_copper,
+    ev2_max
 };
 
 extern struct ev eventtab[ev_max];
@@ -85,37 +91,9 @@ STATIC_INLINE bool cycles_in_range (unsigned long endcycles)
 
 extern void MISC_handler (void);
 
-STATIC_INLINE void event2_newevent_xx (int no, evt t, uae_u32 data, evfunc2 func)
-{
-	evt et;
-	static int next = ev2_misc;
-
-	et = t + get_cycles ();
-	if (no < 0) {
-		no = next;
-		for (;;) {
-			if (!eventtab2[no].active)
-				break;
-			if (eventtab2[no].evtime == et && eventtab2[no].handler == func) {
-				eventtab2[no].handler (eventtab2[no].data);
-				break;
-			}
-			no++;
-			if (no == ev2_max)
-				no = ev2_misc;
-			if (no == next) {
-				write_log (L"out of event2's!\n");
-				return;
-			}
-		}
-		next = no;
-	}
-	eventtab2[no].active = true;
-	eventtab2[no].evtime = et;
-	eventtab2[no].handler = func;
-	eventtab2[no].data = data;
-	MISC_handler ();
-}
+extern void event2_newevent_xx (int no, evt t, uae_u32 data, evfunc2 func);
+extern void event2_remevent (int no);
+extern void event_dump (void);
 
 STATIC_INLINE void event2_newevent_x (int no, evt t, uae_u32 data, evfunc2 func)
 {
@@ -137,10 +115,4 @@ STATIC_INLINE void event2_newevent2 (evt t, uae_u32 data, evfunc2 func)
 }
 
 
-STATIC_INLINE void event2_remevent (int no)
-{
-	eventtab2[no].active = 0;
-}
-
-
 #endif
@@ -38,6 +38,7 @@ typedef int (REGPARAM3 *check_func)(uaecptr, uae_u32) REGPARAM;
 
 extern uae_u8 *address_space, *good_address_map;
 extern uae_u8 *chipmemory;
+extern uae_u32 chipmem_full_mask, chipmem_full_size;
 
 extern uae_u32 allocated_chipmem;
 extern uae_u32 allocated_fastmem;
@@ -53,6 +53,14 @@ typedef void REGPARAM3 cpuop_func_ce (uae_u32) REGPARAM;
 struct cputbl {
 	cpuop_func *handler;
 	uae_u16 opcode;
+	uae_u8 length; /* bytes fetched from the decode cache, _d tables only */
+};
+
+/* gencpu generated instruction pair handler */
+struct cputbl_fused {
+	cpuop_func *handler;
+	uae_u16 opcode;
+	uae_u16 next;
 };
 
 #ifdef JIT
@@ -126,6 +134,7 @@ struct regstruct
 	uae_u8 *pc_p;
 	uae_u8 *pc_oldp;
 	uae_u32 instruction_pc;
+	uae_u16 *dc_ext;
 
 	uae_u16 irc, ir;
 	uae_u32 spcflags;
@@ -299,6 +308,20 @@ STATIC_INLINE uae_u32 get_ilong (int o)
 	return do_get_mem_long((uae_u32 *)((regs).pc_p + (o)));
 }
 
+/* extension words of the current instruction, _d handlers only */
+STATIC_INLINE uae_u32 get_dibyte (int o)
+{
+	return (uae_u8)regs.dc_ext[(o - 2) >> 1];
+}
+STATIC_INLINE uae_u32 get_diword (int o)
+{
+	return regs.dc_ext[(o - 2) >> 1];
+}
+STATIC_INLINE uae_u32 get_dilong (int o)
+{
+	return ((uae_u32)regs.dc_ext[(o - 2) >> 1] << 16) | regs.dc_ext[o >> 1];
+}
+
 #define get_iwordi(o) get_wordi(o)
 #define get_ilongi(o) get_longi(o)
 
@@ -391,6 +414,11 @@ extern int getDivu68kCycles (uae_u32 dividend, uae_u16 divisor);
 extern int getDivs68kCycles (uae_s32 dividend, uae_s16 divisor);
 extern void m68k_do_rte (void);
 
+/* SUBQ.B/W/L #1,Dn */
+#define IS_DELAYLOOP_SUBQ(op) (((op) & 0xff38) == 0x5300 && ((op) & 0x00c0) != 0x00c0)
+extern void delayloop_dbcc (int reg, int cycles);
+extern void delayloop_subq (uaecptr pc, int cycles);
+
 extern void mmu_op (uae_u32, uae_u32);
 extern void mmu_op30 (uaecptr, uae_u32, uae_u16, uaecptr);
 
@@ -436,8 +464,51 @@ extern const struct cputbl op_smalltbl_5_ff[];
 extern const struct cputbl op_smalltbl_11_ff[];
 /* 68000 slow but compatible and cycle-exact.  */
 extern const struct cputbl op_smalltbl_12_ff[];
-
-extern cpuop_func *cpufunctbl[65536] ASM_SYM_FOR_FUNC ("cpufunctbl");
+/* cycle-exact tables used while CPU tracer is active */
+extern const struct cputbl op_smalltbl_12_t_ff[];
+extern const struct cputbl op_smalltbl_20_t_ff[];
+/* fused instruction pairs, plain tables only */
+extern const struct cputbl_fused op_fusedtbl_0_ff[];
+extern const struct cputbl_fused op_fusedtbl_1_ff[];
+extern const struct cputbl_fused op_fusedtbl_2_ff[];
+extern const struct cputbl_fused op_fusedtbl_3_ff[];
+extern const struct cputbl_fused op_fusedtbl_4_ff[];
+extern const struct cputbl_fused op_fusedtbl_5_ff[];
+/* same as above with lazy CZNV evaluation */
+extern const struct cputbl op_smalltbl_0_l_ff[];
+extern const struct cputbl op_smalltbl_1_l_ff[];
+extern const struct cputbl op_smalltbl_2_l_ff[];
+extern const struct cputbl op_smalltbl_3_l_ff[];
+extern const struct cputbl op_smalltbl_4_l_ff[];
+extern const struct cputbl op_smalltbl_5_l_ff[];
+extern const struct cputbl op_smalltbl_11_l_ff[];
+extern const struct cputbl op_smalltbl_12_l_ff[];
+extern const struct cputbl op_smalltbl_20_l_ff[];
+extern const struct cputbl op_smalltbl_21_l_ff[];
+extern const struct cputbl op_smalltbl_22_l_ff[];
+extern const struct cputbl op_smalltbl_23_l_ff[];
+extern const struct cputbl op_smalltbl_31_l_ff[];
+extern const struct cputbl_fused op_fusedtbl_0_l_ff[];
+extern const struct cputbl_fused op_fusedtbl_1_l_ff[];
+extern const struct cputbl_fused op_fusedtbl_2_l_ff[];
+extern const struct cputbl_fused op_fusedtbl_3_l_ff[];
+extern const struct cputbl_fused op_fusedtbl_4_l_ff[];
+extern const struct cputbl_fused op_fusedtbl_5_l_ff[];
+/* generic tables reading extension words from the decode cache */
+extern const struct cputbl op_smalltbl_0_d_ff[];
+extern const struct cputbl op_smalltbl_1_d_ff[];
+extern const struct cputbl op_smalltbl_2_d_ff[];
+extern const struct cputbl op_smalltbl_3_d_ff[];
+extern const struct cputbl op_smalltbl_4_d_ff[];
+extern const struct cputbl op_smalltbl_5_d_ff[];
+extern const struct cputbl_fused op_fusedtbl_0_d_ff[];
+extern const struct cputbl_fused op_fusedtbl_1_d_ff[];
+extern const struct cputbl_fused op_fusedtbl_2_d_ff[];
+extern const struct cputbl_fused op_fusedtbl_3_d_ff[];
+extern const struct cputbl_fused op_fusedtbl_4_d_ff[];
+extern const struct cputbl_fused op_fusedtbl_5_d_ff[];
+
+extern cpuop_func **cpufunctbl;
 
 #ifdef JIT
 extern void flush_icache (uaecptr, int);
@@ -458,6 +529,50 @@ struct cpum2c {
 };
 extern struct cpum2c m2cregs[];
 
+extern bool pairprofile_enabled (void);
+extern bool pairprofile_set (const TCHAR *name);
+
 extern bool is_cpu_tracer (void);
 extern bool set_cpu_tracer (bool force);
-extern bool can_cpu_tracer (void);
\ No newline at end of file
+extern bool can_cpu_tracer (void);
+
+/* pre-decoded instruction cache, used by non-JIT non-cycle-exact run loops.
+Entries are keyed by host address so that all aliases of the same RAM
+share one entry. */
+#define DECODECACHE_SIZE 8192
+#define DECODECACHE_EXT 4
+struct decodecache
+{
+	uae_u8 *pc_p;
+	cpuop_func *handler;
+	uae_u16 opcode;
+	uae_u16 length;
+	uae_u16 ext[DECODECACHE_EXT];
+};
+extern struct decodecache decodecache[DECODECACHE_SIZE];
+extern bool decodecache_active;
+extern uae_u8 *decodecache_lo, *decodecache_hi;
+extern uae_u32 decodecache_misses, decodecache_invalidates;
+extern void decodecache_flush (void);
+extern void decodecache_write_range (uae_u8 *lo, uae_u8 *hi);
+extern void decodecache_stats (void);
+
+STATIC_INLINE struct decodecache *decodecache_slot (uae_u8 *p)
+{
+	return &decodecache[((size_t)p >> 1) & (DECODECACHE_SIZE - 1)];
+}
+/* called by RAM bank put handlers with the host address */
+STATIC_INLINE void decodecache_write (uae_u8 *p, int size)
+{
+	uae_u8 *q;
+
+	if (p + size <= decodecache_lo || p >= decodecache_hi)
+		return;
+	for (q = (uae_u8*)((size_t)(p - DECODECACHE_EXT * 2) & ~1); q < p + size; q += 2) {
+		struct decodecache *dc = decodecache_slot (q);
+		if (dc->pc_p == q && q + dc->length > p) {
+			dc->pc_p = NULL;
+			decodecache_invalidates++;
+		}
+	}
+}
\ No newline at end of file
@@ -205,6 +205,7 @@ struct uae_prefs {
 	int gfx_display;
 	TCHAR gfx_display_name[256];
 	int gfx_framerate, gfx_autoframerate;
+	int gfx_render_threads;
 	struct wh gfx_size_win;
 	struct wh gfx_size_fs;
 	struct wh gfx_size;
@@ -341,6 +342,9 @@ struct uae_prefs {
 	int fpu_model;
 	int fpu_revision;
 	bool cpu_compatible;
+	bool cpu_decode_cache;
+	bool cpu_lazy_flags;
+	bool cpu_busywait_skip;
 	bool address_space_24;
 	bool picasso96_nocustom;
 	int picasso96_modeflags;
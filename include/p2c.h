@@ -0,0 +1,326 @@
+/*
+* Planar to chunky conversion of bitplane data, scalar and SSE2/AVX2.
+* Included by drawing.cpp and test_simd.cpp, the includer provides
+* uae_u8 *real_bplpt[8], the conversion reads the planes through it.
+*/
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <emmintrin.h>
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+#endif
+#endif
+
+#define MERGE(a,b,mask,shift) do {\
+	uae_u32 tmp = mask & (a ^ (b >> shift)); \
+	a ^= tmp; \
+	b ^= (tmp << shift); \
+} while (0)
+
+#define GETLONG(P) (*(uae_u32 *)P)
+
+/* We use the compiler's inlining ability to ensure that PLANES is in effect a compile time
+constant.  That will cause some unnecessary code to be optimized away.
+Don't touch this if you don't know what you are doing.  */
+STATIC_INLINE void pfield_doline_1 (uae_u32 *pixels, int wordcount, int planes)
+{
+	while (wordcount-- > 0) {
+		uae_u32 b0, b1, b2, b3, b4, b5, b6, b7;
+
+		b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0, b7 = 0;
+		switch (planes) {
+#ifdef AGA
+		case 8: b0 = GETLONG (real_bplpt[7]); real_bplpt[7] += 4;
+		case 7: b1 = GETLONG (real_bplpt[6]); real_bplpt[6] += 4;
+#endif
+		case 6: b2 = GETLONG (real_bplpt[5]); real_bplpt[5] += 4;
+		case 5: b3 = GETLONG (real_bplpt[4]); real_bplpt[4] += 4;
+		case 4: b4 = GETLONG (real_bplpt[3]); real_bplpt[3] += 4;
+		case 3: b5 = GETLONG (real_bplpt[2]); real_bplpt[2] += 4;
+		case 2: b6 = GETLONG (real_bplpt[1]); real_bplpt[1] += 4;
+		case 1: b7 = GETLONG (real_bplpt[0]); real_bplpt[0] += 4;
+		}
+
+		MERGE (b0, b1, 0x55555555, 1);
+		MERGE (b2, b3, 0x55555555, 1);
+		MERGE (b4, b5, 0x55555555, 1);
+		MERGE (b6, b7, 0x55555555, 1);
+
+		MERGE (b0, b2, 0x33333333, 2);
+		MERGE (b1, b3, 0x33333333, 2);
+		MERGE (b4, b6, 0x33333333, 2);
+		MERGE (b5, b7, 0x33333333, 2);
+
+		MERGE (b0, b4, 0x0f0f0f0f, 4);
+		MERGE (b1, b5, 0x0f0f0f0f, 4);
+		MERGE (b2, b6, 0x0f0f0f0f, 4);
+		MERGE (b3, b7, 0x0f0f0f0f, 4);
+
+		MERGE (b0, b1, 0x00ff00ff, 8);
+		MERGE (b2, b3, 0x00ff00ff, 8);
+		MERGE (b4, b5, 0x00ff00ff, 8);
+		MERGE (b6, b7, 0x00ff00ff, 8);
+
+		MERGE (b0, b2, 0x0000ffff, 16);
+		do_put_mem_long (pixels, b0);
+		do_put_mem_long (pixels + 4, b2);
+		MERGE (b1, b3, 0x0000ffff, 16);
+		do_put_mem_long (pixels + 2, b1);
+		do_put_mem_long (pixels + 6, b3);
+		MERGE (b4, b6, 0x0000ffff, 16);
+		do_put_mem_long (pixels + 1, b4);
+		do_put_mem_long (pixels + 5, b6);
+		MERGE (b5, b7, 0x0000ffff, 16);
+		do_put_mem_long (pixels + 3, b5);
+		do_put_mem_long (pixels + 7, b7);
+		pixels += 8;
+	}
+}
+
+/* See above for comments on inlining.  These functions should _not_
+be inlined themselves.  */
+static void NOINLINE pfield_doline_n1 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 1); }
+static void NOINLINE pfield_doline_n2 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 2); }
+static void NOINLINE pfield_doline_n3 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 3); }
+static void NOINLINE pfield_doline_n4 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 4); }
+static void NOINLINE pfield_doline_n5 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 5); }
+static void NOINLINE pfield_doline_n6 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 6); }
+#ifdef AGA
+static void NOINLINE pfield_doline_n7 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 7); }
+static void NOINLINE pfield_doline_n8 (uae_u32 *data, int count) { pfield_doline_1 (data, count, 8); }
+#endif
+
+typedef void (*pfield_doline_func)(uae_u32 *, int);
+
+#ifdef HAVE_SSE2_INTRINSICS
+
+/* Same merge network as pfield_doline_1, each 32-bit lane is one
+   pfield_doline_1 iteration. Lanes are transposed back to the
+   b0,b4,b1,b5,b2,b6,b3,b7 output order before storing. */
+
+#define MERGE_SSE2(a,b,mask,shift) do {\
+	__m128i tmp = _mm_and_si128 (mask, _mm_xor_si128 (a, _mm_srli_epi32 (b, shift))); \
+	a = _mm_xor_si128 (a, tmp); \
+	b = _mm_xor_si128 (b, _mm_slli_epi32 (tmp, shift)); \
+} while (0)
+
+#define GETSIMD_SSE2(n, b) b = _mm_loadu_si128 ((__m128i*)real_bplpt[n]); real_bplpt[n] += 16
+
+STATIC_INLINE TARGET_SSE2 __m128i bswap32_sse2 (__m128i v)
+{
+	v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+	return _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (v, 0xb1), 0xb1);
+}
+
+STATIC_INLINE TARGET_SSE2 void store_transposed_sse2 (uae_u32 *pixels, __m128i r0, __m128i r1, __m128i r2, __m128i r3)
+{
+	__m128i t0 = _mm_unpacklo_epi32 (r0, r1);
+	__m128i t1 = _mm_unpacklo_epi32 (r2, r3);
+	__m128i t2 = _mm_unpackhi_epi32 (r0, r1);
+	__m128i t3 = _mm_unpackhi_epi32 (r2, r3);
+	_mm_storeu_si128 ((__m128i*)(pixels + 0), bswap32_sse2 (_mm_unpacklo_epi64 (t0, t1)));
+	_mm_storeu_si128 ((__m128i*)(pixels + 8), bswap32_sse2 (_mm_unpackhi_epi64 (t0, t1)));
+	_mm_storeu_si128 ((__m128i*)(pixels + 16), bswap32_sse2 (_mm_unpacklo_epi64 (t2, t3)));
+	_mm_storeu_si128 ((__m128i*)(pixels + 24), bswap32_sse2 (_mm_unpackhi_epi64 (t2, t3)));
+}
+
+STATIC_INLINE TARGET_SSE2 void pfield_doline_sse2 (uae_u32 *pixels, int wordcount, int planes)
+{
+	const __m128i m1 = _mm_set1_epi32 (0x55555555), m2 = _mm_set1_epi32 (0x33333333);
+	const __m128i m4 = _mm_set1_epi32 (0x0f0f0f0f), m8 = _mm_set1_epi32 (0x00ff00ff);
+	const __m128i m16 = _mm_set1_epi32 (0x0000ffff);
+
+	while (wordcount >= 4) {
+		__m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+		b0 = b1 = b2 = b3 = b4 = b5 = b6 = b7 = _mm_setzero_si128 ();
+		switch (planes) {
+#ifdef AGA
+		case 8: GETSIMD_SSE2 (7, b0);
+		case 7: GETSIMD_SSE2 (6, b1);
+#endif
+		case 6: GETSIMD_SSE2 (5, b2);
+		case 5: GETSIMD_SSE2 (4, b3);
+		case 4: GETSIMD_SSE2 (3, b4);
+		case 3: GETSIMD_SSE2 (2, b5);
+		case 2: GETSIMD_SSE2 (1, b6);
+		case 1: GETSIMD_SSE2 (0, b7);
+		}
+
+		MERGE_SSE2 (b0, b1, m1, 1);
+		MERGE_SSE2 (b2, b3, m1, 1);
+		MERGE_SSE2 (b4, b5, m1, 1);
+		MERGE_SSE2 (b6, b7, m1, 1);
+
+		MERGE_SSE2 (b0, b2, m2, 2);
+		MERGE_SSE2 (b1, b3, m2, 2);
+		MERGE_SSE2 (b4, b6, m2, 2);
+		MERGE_SSE2 (b5, b7, m2, 2);
+
+		MERGE_SSE2 (b0, b4, m4, 4);
+		MERGE_SSE2 (b1, b5, m4, 4);
+		MERGE_SSE2 (b2, b6, m4, 4);
+		MERGE_SSE2 (b3, b7, m4, 4);
+
+		MERGE_SSE2 (b0, b1, m8, 8);
+		MERGE_SSE2 (b2, b3, m8, 8);
+		MERGE_SSE2 (b4, b5, m8, 8);
+		MERGE_SSE2 (b6, b7, m8, 8);
+
+		MERGE_SSE2 (b0, b2, m16, 16);
+		MERGE_SSE2 (b1, b3, m16, 16);
+		MERGE_SSE2 (b4, b6, m16, 16);
+		MERGE_SSE2 (b5, b7, m16, 16);
+
+		store_transposed_sse2 (pixels, b0, b4, b1, b5);
+		store_transposed_sse2 (pixels + 4, b2, b6, b3, b7);
+		pixels += 32;
+		wordcount -= 4;
+	}
+	pfield_doline_1 (pixels, wordcount, planes);
+}
+
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n1 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 1); }
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n2 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 2); }
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n3 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 3); }
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n4 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 4); }
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n5 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 5); }
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n6 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 6); }
+#ifdef AGA
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n7 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 7); }
+static void NOINLINE TARGET_SSE2 pfield_doline_sse2_n8 (uae_u32 *data, int count) { pfield_doline_sse2 (data, count, 8); }
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#define MERGE_AVX2(a,b,mask,shift) do {\
+	__m256i tmp = _mm256_and_si256 (mask, _mm256_xor_si256 (a, _mm256_srli_epi32 (b, shift))); \
+	a = _mm256_xor_si256 (a, tmp); \
+	b = _mm256_xor_si256 (b, _mm256_slli_epi32 (tmp, shift)); \
+} while (0)
+
+#define GETSIMD_AVX2(n, b) b = _mm256_loadu_si256 ((__m256i*)real_bplpt[n]); real_bplpt[n] += 32
+
+/* 128-bit halves are transposed separately, low half is iteration 0-3 and high half 4-7 */
+STATIC_INLINE TARGET_AVX2 void store_transposed_avx2 (uae_u32 *pixels, __m256i r0, __m256i r1, __m256i r2, __m256i r3,
+	__m256i r4, __m256i r5, __m256i r6, __m256i r7)
+{
+	const __m256i swap = _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	__m256i f[4], s[4], t0, t1, t2, t3;
+	int i;
+
+	t0 = _mm256_unpacklo_epi32 (r0, r1);
+	t1 = _mm256_unpacklo_epi32 (r2, r3);
+	t2 = _mm256_unpackhi_epi32 (r0, r1);
+	t3 = _mm256_unpackhi_epi32 (r2, r3);
+	f[0] = _mm256_unpacklo_epi64 (t0, t1);
+	f[1] = _mm256_unpackhi_epi64 (t0, t1);
+	f[2] = _mm256_unpacklo_epi64 (t2, t3);
+	f[3] = _mm256_unpackhi_epi64 (t2, t3);
+	t0 = _mm256_unpacklo_epi32 (r4, r5);
+	t1 = _mm256_unpacklo_epi32 (r6, r7);
+	t2 = _mm256_unpackhi_epi32 (r4, r5);
+	t3 = _mm256_unpackhi_epi32 (r6, r7);
+	s[0] = _mm256_unpacklo_epi64 (t0, t1);
+	s[1] = _mm256_unpackhi_epi64 (t0, t1);
+	s[2] = _mm256_unpacklo_epi64 (t2, t3);
+	s[3] = _mm256_unpackhi_epi64 (t2, t3);
+	for (i = 0; i < 4; i++) {
+		_mm256_storeu_si256 ((__m256i*)(pixels + i * 8), _mm256_shuffle_epi8 (_mm256_permute2x128_si256 (f[i], s[i], 0x20), swap));
+		_mm256_storeu_si256 ((__m256i*)(pixels + i * 8 + 32), _mm256_shuffle_epi8 (_mm256_permute2x128_si256 (f[i], s[i], 0x31), swap));
+	}
+}
+
+STATIC_INLINE TARGET_AVX2 void pfield_doline_avx2 (uae_u32 *pixels, int wordcount, int planes)
+{
+	const __m256i m1 = _mm256_set1_epi32 (0x55555555), m2 = _mm256_set1_epi32 (0x33333333);
+	const __m256i m4 = _mm256_set1_epi32 (0x0f0f0f0f), m8 = _mm256_set1_epi32 (0x00ff00ff);
+	const __m256i m16 = _mm256_set1_epi32 (0x0000ffff);
+
+	while (wordcount >= 8) {
+		__m256i b0, b1, b2, b3, b4, b5, b6, b7;
+
+		b0 = b1 = b2 = b3 = b4 = b5 = b6 = b7 = _mm256_setzero_si256 ();
+		switch (planes) {
+#ifdef AGA
+		case 8: GETSIMD_AVX2 (7, b0);
+		case 7: GETSIMD_AVX2 (6, b1);
+#endif
+		case 6: GETSIMD_AVX2 (5, b2);
+		case 5: GETSIMD_AVX2 (4, b3);
+		case 4: GETSIMD_AVX2 (3, b4);
+		case 3: GETSIMD_AVX2 (2, b5);
+		case 2: GETSIMD_AVX2 (1, b6);
+		case 1: GETSIMD_AVX2 (0, b7);
+		}
+
+		MERGE_AVX2 (b0, b1, m1, 1);
+		MERGE_AVX2 (b2, b3, m1, 1);
+		MERGE_AVX2 (b4, b5, m1, 1);
+		MERGE_AVX2 (b6, b7, m1, 1);
+
+		MERGE_AVX2 (b0, b2, m2, 2);
+		MERGE_AVX2 (b1, b3, m2, 2);
+		MERGE_AVX2 (b4, b6, m2, 2);
+		MERGE_AVX2 (b5, b7, m2, 2);
+
+		MERGE_AVX2 (b0, b4, m4, 4);
+		MERGE_AVX2 (b1, b5, m4, 4);
+		MERGE_AVX2 (b2, b6, m4, 4);
+		MERGE_AVX2 (b3, b7, m4, 4);
+
+		MERGE_AVX2 (b0, b1, m8, 8);
+		MERGE_AVX2 (b2, b3, m8, 8);
+		MERGE_AVX2 (b4, b5, m8, 8);
+		MERGE_AVX2 (b6, b7, m8, 8);
+
+		MERGE_AVX2 (b0, b2, m16, 16);
+		MERGE_AVX2 (b1, b3, m16, 16);
+		MERGE_AVX2 (b4, b6, m16, 16);
+		MERGE_AVX2 (b5, b7, m16, 16);
+
+		store_transposed_avx2 (pixels, b0, b4, b1, b5, b2, b6, b3, b7);
+		pixels += 64;
+		wordcount -= 8;
+	}
+	pfield_doline_sse2 (pixels, wordcount, planes);
+}
+
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n1 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 1); }
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n2 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 2); }
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n3 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 3); }
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n4 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 4); }
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n5 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 5); }
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n6 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 6); }
+#ifdef AGA
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n7 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 7); }
+static void NOINLINE TARGET_AVX2 pfield_doline_avx2_n8 (uae_u32 *data, int count) { pfield_doline_avx2 (data, count, 8); }
+#endif
+
+#endif
+
+#endif
+
+static const pfield_doline_func pfield_doline_scalar[9] = {
+	NULL, pfield_doline_n1, pfield_doline_n2, pfield_doline_n3, pfield_doline_n4, pfield_doline_n5, pfield_doline_n6,
+#ifdef AGA
+	pfield_doline_n7, pfield_doline_n8
+#endif
+};
+#ifdef HAVE_SSE2_INTRINSICS
+static const pfield_doline_func pfield_doline_sse2_funcs[9] = {
+	NULL, pfield_doline_sse2_n1, pfield_doline_sse2_n2, pfield_doline_sse2_n3, pfield_doline_sse2_n4, pfield_doline_sse2_n5, pfield_doline_sse2_n6,
+#ifdef AGA
+	pfield_doline_sse2_n7, pfield_doline_sse2_n8
+#endif
+};
+#ifdef HAVE_AVX2_INTRINSICS
+static const pfield_doline_func pfield_doline_avx2_funcs[9] = {
+	NULL, pfield_doline_avx2_n1, pfield_doline_avx2_n2, pfield_doline_avx2_n3, pfield_doline_avx2_n4, pfield_doline_avx2_n5, pfield_doline_avx2_n6,
+#ifdef AGA
+	pfield_doline_avx2_n7, pfield_doline_avx2_n8
+#endif
+};
+#endif
+#endif
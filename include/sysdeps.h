@@ -507,6 +507,42 @@ extern void log_close (FILE *f);
 #endif
 #endif
 
+/* x86 SIMD intrinsics, host_simd_level () tells which ones the CPU can run.
+   Functions using them are marked TARGET_SSE2/TARGET_AVX2 so that gcc
+   accepts them without compiling everything for that instruction set. */
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define HAVE_SSE2_INTRINSICS
+#if (defined(_MSC_VER) && _MSC_VER >= 1700) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define HAVE_AVX2_INTRINSICS
+#endif
+#endif
+#ifdef __GNUC__
+#define TARGET_SSE2 __attribute__ ((target ("sse2")))
+#define TARGET_AVX2 __attribute__ ((target ("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+#define HOST_SIMD_SSE2 1
+#define HOST_SIMD_AVX2 2
+extern int host_simd_level (void);
+
+/* index of the lowest set bit, v must not be zero */
+#ifdef _MSC_VER
+#include <intrin.h>
+STATIC_INLINE int uae_ctz32 (uae_u32 v)
+{
+	unsigned long idx;
+	_BitScanForward (&idx, v);
+	return idx;
+}
+#else
+STATIC_INLINE int uae_ctz32 (uae_u32 v)
+{
+	return __builtin_ctz (v);
+}
+#endif
+
 /* Every Amiga hardware clock cycle takes this many "virtual" cycles.  This
    used to be hardcoded as 1, but using higher values allows us to time some
    stuff more precisely.
@@ -80,7 +80,11 @@ extern signed long pissoff;
 #define USE_PUSH_POP 1
 #endif
 
+#ifdef CPU_64_BIT
+#define N_REGS 16 /* really only 14, %rsp and the %r11 scratch are never allocated */
+#else
 #define N_REGS 8  /* really only 7, but they are numbered 0,1,2,3,5,6,7 */
+#endif
 #define N_FREGS 6 /* That leaves us two positions on the stack to play with */
 
 /* Functions exposed to newcpu, or to what was moved from newcpu.c to
@@ -94,6 +98,8 @@ extern void build_comp(void);
 extern void set_cache_state(int enabled);
 extern int get_cache_state(void);
 extern uae_u32 get_jitted_size(void);
+extern uae_u32 get_jit_evict_count(void);
+extern uae_u32 get_jit_recompile_count(void);
 #ifdef JIT
 extern void flush_icache(uaecptr ptr, int n);
 #endif
@@ -248,9 +254,9 @@ extern int touchcnt;
 #define RW1 uae_u32
 #define RW2 uae_u32
 #define RW4 uae_u32
-#define MEMR uae_u32
-#define MEMW uae_u32
-#define MEMRW uae_u32
+#define MEMR uintptr
+#define MEMW uintptr
+#define MEMRW uintptr
 
 #define FW   uae_u32
 #define FR   uae_u32
@@ -283,12 +289,12 @@ DECLARE(bts_l_ri(RW4 r, IMM i));
 DECLARE(bts_l_rr(RW4 r, R4 b));
 DECLARE(btr_l_ri(RW4 r, IMM i));
 DECLARE(btr_l_rr(RW4 r, R4 b));
-DECLARE(mov_l_rm(W4 d, IMM s));
+DECLARE(mov_l_rm(W4 d, MEMR s));
 DECLARE(call_r(R4 r));
-DECLARE(sub_l_mi(IMM d, IMM s));
-DECLARE(mov_l_mi(IMM d, IMM s));
-DECLARE(mov_w_mi(IMM d, IMM s));
-DECLARE(mov_b_mi(IMM d, IMM s));
+DECLARE(sub_l_mi(MEMRW d, IMM s));
+DECLARE(mov_l_mi(MEMW d, IMM s));
+DECLARE(mov_w_mi(MEMW d, IMM s));
+DECLARE(mov_b_mi(MEMW d, IMM s));
 DECLARE(rol_b_ri(RW1 r, IMM i));
 DECLARE(rol_w_ri(RW2 r, IMM i));
 DECLARE(rol_l_ri(RW4 r, IMM i));
@@ -320,14 +326,14 @@ DECLARE(shra_l_ri(RW4 r, IMM i));
 DECLARE(shra_w_ri(RW2 r, IMM i));
 DECLARE(shra_b_ri(RW1 r, IMM i));
 DECLARE(setcc(W1 d, IMM cc));
-DECLARE(setcc_m(IMM d, IMM cc));
+DECLARE(setcc_m(MEMW d, IMM cc));
 DECLARE(cmov_b_rr(RW1 d, R1 s, IMM cc));
 DECLARE(cmov_w_rr(RW2 d, R2 s, IMM cc));
 DECLARE(cmov_l_rr(RW4 d, R4 s, IMM cc));
-DECLARE(cmov_l_rm(RW4 d, IMM s, IMM cc));
+DECLARE(cmov_l_rm(RW4 d, MEMR s, IMM cc));
 DECLARE(bsf_l_rr(W4 d, R4 s));
-DECLARE(pop_m(IMM d));
-DECLARE(push_m(IMM d));
+DECLARE(pop_m(MEMW d));
+DECLARE(push_m(MEMR d));
 DECLARE(pop_l(W4 d));
 DECLARE(push_l_i(IMM i));
 DECLARE(push_l(R4 s));
@@ -348,7 +354,7 @@ DECLARE(mov_b_rrm_indexed(W1 d, R4 baser, R4 index));
 DECLARE(mov_l_mrr_indexed(R4 baser, R4 index, R4 s));
 DECLARE(mov_w_mrr_indexed(R4 baser, R4 index, R2 s));
 DECLARE(mov_b_mrr_indexed(R4 baser, R4 index, R1 s));
-DECLARE(mov_l_rm_indexed(W4 d, IMM base, R4 index));
+DECLARE(mov_l_rm_indexed(W4 d, MEMR base, R4 index));
 DECLARE(mov_l_rR(W4 d, R4 s, IMM offset));
 DECLARE(mov_w_rR(W2 d, R4 s, IMM offset));
 DECLARE(mov_b_rR(W1 d, R4 s, IMM offset));
@@ -369,17 +375,17 @@ DECLARE(mov_b_bRr(R4 d, R1 s, IMM offset));
 DECLARE(gen_bswap_32(RW4 r));
 DECLARE(gen_bswap_16(RW2 r));
 DECLARE(mov_l_rr(W4 d, R4 s));
-DECLARE(mov_l_mr(IMM d, R4 s));
-DECLARE(mov_w_mr(IMM d, R2 s));
-DECLARE(mov_w_rm(W2 d, IMM s));
-DECLARE(mov_b_mr(IMM d, R1 s));
-DECLARE(mov_b_rm(W1 d, IMM s));
+DECLARE(mov_l_mr(MEMW d, R4 s));
+DECLARE(mov_w_mr(MEMW d, R2 s));
+DECLARE(mov_w_rm(W2 d, MEMR s));
+DECLARE(mov_b_mr(MEMW d, R1 s));
+DECLARE(mov_b_rm(W1 d, MEMR s));
 DECLARE(mov_l_ri(W4 d, IMM s));
 DECLARE(mov_w_ri(W2 d, IMM s));
 DECLARE(mov_b_ri(W1 d, IMM s));
-DECLARE(add_l_mi(IMM d, IMM s) );
-DECLARE(add_w_mi(IMM d, IMM s) );
-DECLARE(add_b_mi(IMM d, IMM s) );
+DECLARE(add_l_mi(MEMRW d, IMM s) );
+DECLARE(add_w_mi(MEMRW d, IMM s) );
+DECLARE(add_b_mi(MEMRW d, IMM s) );
 DECLARE(test_l_ri(R4 d, IMM i));
 DECLARE(test_l_rr(R4 d, R4 s));
 DECLARE(test_w_rr(R2 d, R2 s));
@@ -426,6 +432,10 @@ DECLARE(end_needflags(void));
 DECLARE(make_flags_live(void));
 DECLARE(call_r_11(R4 r, W4 out1, R4 in1, IMM osize, IMM isize));
 DECLARE(call_r_02(R4 r, R4 in1, R4 in2, IMM isize1, IMM isize2));
+#ifdef CPU_64_BIT
+DECLARE(call_bank_r_11(W4 out1, R4 in1, IMM offset, IMM osize));
+DECLARE(call_bank_r_02(R4 in1, R4 in2, IMM offset, IMM isize2));
+#endif
 DECLARE(readmem_new(R4 address, W4 dest, IMM offset, IMM size, W4 tmp));
 DECLARE(writemem_new(R4 address, R4 source, IMM offset, IMM size, W4 tmp));
 DECLARE(forget_about(W4 r));
@@ -453,7 +463,7 @@ DECLARE(fmov_ext_ri(FW r, IMM i1, IMM i2, IMM i3));
 DECLARE(fmov_ext_mr(MEMW m, FR r));
 DECLARE(fmov_ext_rm(FW r, MEMR m));
 DECLARE(fmov_rr(FW d, FR s));
-DECLARE(fldcw_m_indexed(R4 index, IMM base));
+DECLARE(fldcw_m_indexed(R4 index, MEMR base));
 DECLARE(ftst_r(FR r));
 DECLARE(dont_care_fflags(void));
 DECLARE(fsqrt_rr(FW d, FR s));
@@ -512,6 +522,7 @@ extern void sync_m68k_pc(void);
 extern uae_u32 get_const(int r);
 extern int  is_const(int r);
 extern void register_branch(uae_u32 not_taken, uae_u32 taken, uae_u8 cond);
+extern void register_call(uae_u32 ret);
 extern void empty_optimizer(void);
 
 #define comp_get_ibyte(o) do_get_mem_byte((uae_u8 *)(comp_pc_p + (o) + 1))
@@ -556,6 +567,7 @@ typedef struct blockinfo_t {
     uae_u8 needed_flags;
     uae_u8 status;
     uae_u8 havestate;
+    uae_u8 haveretstub; /* Pushes a return stub onto the return stack */
 
     dependency  dep[2];  /* Holds things we depend on */
     dependency* deplist; /* List of things that depend on this */
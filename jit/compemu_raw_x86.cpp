@@ -13,7 +13,7 @@ only target, and it's easier this way... */
 #define EBP_INDEX 5
 #define ESI_INDEX 6
 #define EDI_INDEX 7
-#if defined(__x86_64__)
+#if defined(CPU_64_BIT)
 #define R8_INDEX  8
 #define R9_INDEX  9
 #define R10_INDEX 10
@@ -61,16 +61,22 @@ only target, and it's easier this way... */
 #define STACK_ALIGN		16
 #define STACK_OFFSET	sizeof(void *)
 
-uae_u8 always_used[]={4,0xff};
-#if defined(__x86_64__)
-uae_s8 can_byte[]={0,1,2,3,5,6,7,8,9,10,11,12,13,14,15,-1};
-uae_s8 can_word[]={0,1,2,3,5,6,7,8,9,10,11,12,13,14,15,-1};
+#if defined(CPU_64_BIT)
+/* %r11 is the scratch register for 64-bit addresses and far jumps */
+uae_u8 always_used[]={4,11,0xff};
+uae_u8 can_byte[]={0,1,2,3,5,6,7,8,9,10,12,13,14,15,0xff};
+uae_u8 can_word[]={0,1,2,3,5,6,7,8,9,10,12,13,14,15,0xff};
 #else
+uae_u8 always_used[]={4,0xff};
 uae_u8 can_byte[]={0,1,2,3,0xff};
 uae_u8 can_word[]={0,1,2,3,5,6,7,0xff};
 #endif
 
+#if defined(CPU_64_BIT)
+uae_u8 call_saved[]={0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0};
+#else
 uae_u8 call_saved[]={0,0,0,0,1,0,0,0};
+#endif
 
 /* This *should* be the same as call_saved. But:
 - We might not really know which registers are saved, and which aren't,
@@ -79,7 +85,12 @@ also saving those registers
 - Special registers (such like the stack pointer) should not be "preserved"
 by pushing, even though they are "saved" across function calls
 */
+#if defined(CPU_64_BIT)
+/* Win64 callee-saved registers: rbx, rbp, rsi, rdi and r12-r15 */
+uae_u8 need_to_preserve[]={0,0,0,1,0,1,1,1,0,0,0,0,1,1,1,1};
+#else
 uae_u8 need_to_preserve[]={1,1,1,1,0,1,1,1};
+#endif
 
 /* Whether classes of instructions do or don't clobber the native flags */
 #define CLOBBER_MOV
@@ -96,45 +107,1001 @@ uae_u8 need_to_preserve[]={1,1,1,1,0,1,1,1};
 #define CLOBBER_OR   clobber_flags()
 #define CLOBBER_XOR  clobber_flags()
 
-#define CLOBBER_ROL  clobber_flags()
-#define CLOBBER_ROR  clobber_flags()
-#define CLOBBER_SHLL clobber_flags()
-#define CLOBBER_SHRL clobber_flags()
-#define CLOBBER_SHRA clobber_flags()
-#define CLOBBER_TEST clobber_flags()
-#define CLOBBER_CL16
-#define CLOBBER_CL8
-#define CLOBBER_SE16
-#define CLOBBER_SE8
-#define CLOBBER_ZE16
-#define CLOBBER_ZE8
-#define CLOBBER_SW16 clobber_flags()
-#define CLOBBER_SW32
-#define CLOBBER_SETCC
-#define CLOBBER_MUL  clobber_flags()
-#define CLOBBER_BT   clobber_flags()
-#define CLOBBER_BSF  clobber_flags()
+#define CLOBBER_ROL  clobber_flags()
+#define CLOBBER_ROR  clobber_flags()
+#define CLOBBER_SHLL clobber_flags()
+#define CLOBBER_SHRL clobber_flags()
+#define CLOBBER_SHRA clobber_flags()
+#define CLOBBER_TEST clobber_flags()
+#define CLOBBER_CL16
+#define CLOBBER_CL8
+#define CLOBBER_SE16
+#define CLOBBER_SE8
+#define CLOBBER_ZE16
+#define CLOBBER_ZE8
+#define CLOBBER_SW16 clobber_flags()
+#define CLOBBER_SW32
+#define CLOBBER_SETCC
+#define CLOBBER_MUL  clobber_flags()
+#define CLOBBER_BT   clobber_flags()
+#define CLOBBER_BSF  clobber_flags()
+
+/*************************************************************************
+* Actual encoding of the instructions on the target CPU                 *
+*************************************************************************/
+
+//#include "compemu_optimizer_x86.c"
+
+STATIC_INLINE uae_u16 swap16(uae_u16 x)
+{
+	return ((x&0xff00)>>8)|((x&0x00ff)<<8);
+}
+
+STATIC_INLINE uae_u32 swap32(uae_u32 x)
+{
+	return ((x&0xff00)<<8)|((x&0x00ff)<<24)|((x&0xff0000)>>8)|((x&0xff000000)>>24);
+}
+
+STATIC_INLINE int isbyte(uae_s32 x)
+{
+	return (x>=-128 && x<=127);
+}
+
+#if defined(CPU_64_BIT)
+
+/* The x86-64 encodings are generated by the run-time assembler macros
+in codegen_x86.h, hand-coding every REX prefix is not much fun. The
+virtual registers stay 32 bits wide. */
+#define X86_TARGET_64BIT		1
+/* Guest addresses are 32-bit, keep address arithmetic on them wrapping
+around the way it does on the 32-bit host. */
+#define ADDR32					x86_emit_byte(0x67),
+#define X86_FLAT_REGISTERS		0
+#define X86_OPTIMIZE_ALU		1
+#define X86_OPTIMIZE_ROTSHI		1
+#include "codegen_x86.h"
+
+#define x86_emit_byte(B)		emit_byte(B)
+#define x86_emit_word(W)		emit_word(W)
+#define x86_emit_long(L)		emit_long(L)
+#define x86_emit_quad(Q)		emit_quad(Q)
+#define x86_get_target()		get_target()
+#define x86_emit_failure(MSG)	jit_abort(L"JIT: %S", MSG)
+
+#include "compemu_raw_x86_64.h"
+
+LOWFUNC(NONE,WRITE,1,raw_push_l_r,(R4 r))
+{
+	PUSHQr(r);
+}
+LENDFUNC(NONE,WRITE,1,raw_push_l_r,(R4 r))
+
+	LOWFUNC(NONE,READ,1,raw_pop_l_r,(R4 r))
+{
+	POPQr(r);
+}
+LENDFUNC(NONE,READ,1,raw_pop_l_r,(R4 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_bt_l_ri,(R4 r, IMM i))
+{
+	BTLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_bt_l_ri,(R4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_bt_l_rr,(R4 r, R4 b))
+{
+	BTLrr(b, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_bt_l_rr,(R4 r, R4 b))
+
+	LOWFUNC(WRITE,NONE,2,raw_btc_l_ri,(RW4 r, IMM i))
+{
+	BTCLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_btc_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_btc_l_rr,(RW4 r, R4 b))
+{
+	BTCLrr(b, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_btc_l_rr,(RW4 r, R4 b))
+
+	LOWFUNC(WRITE,NONE,2,raw_btr_l_ri,(RW4 r, IMM i))
+{
+	BTRLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_btr_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_btr_l_rr,(RW4 r, R4 b))
+{
+	BTRLrr(b, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_btr_l_rr,(RW4 r, R4 b))
+
+	LOWFUNC(WRITE,NONE,2,raw_bts_l_ri,(RW4 r, IMM i))
+{
+	BTSLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_bts_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_bts_l_rr,(RW4 r, R4 b))
+{
+	BTSLrr(b, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_bts_l_rr,(RW4 r, R4 b))
+
+	LOWFUNC(WRITE,NONE,2,raw_sub_w_ri,(RW2 d, IMM i))
+{
+	SUBWir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_sub_w_ri,(RW2 d, IMM i))
+
+	LOWFUNC(NONE,WRITE,2,raw_mov_l_mi,(MEMW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	MOVLim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,2,raw_mov_l_mi,(MEMW d, IMM s))
+
+	LOWFUNC(NONE,WRITE,2,raw_mov_w_mi,(MEMW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	MOVWim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,2,raw_mov_w_mi,(MEMW d, IMM s))
+
+	LOWFUNC(NONE,WRITE,2,raw_mov_b_mi,(MEMW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	MOVBim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,2,raw_mov_b_mi,(MEMW d, IMM s))
+
+	LOWFUNC(WRITE,RMW,2,raw_rol_b_mi,(MEMRW d, IMM i))
+{
+	int b = raw_abs(&d, 1);
+	ROLBim(i, d, b, X86_NOREG, 1);
+}
+LENDFUNC(WRITE,RMW,2,raw_rol_b_mi,(MEMRW d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_rol_b_ri,(RW1 r, IMM i))
+{
+	ROLBir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_rol_b_ri,(RW1 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_rol_w_ri,(RW2 r, IMM i))
+{
+	ROLWir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_rol_w_ri,(RW2 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_rol_l_ri,(RW4 r, IMM i))
+{
+	ROLLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_rol_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_rol_l_rr,(RW4 d, R1 r))
+{
+	ROLLrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_rol_l_rr,(RW4 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_rol_w_rr,(RW2 d, R1 r))
+{
+	ROLWrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_rol_w_rr,(RW2 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_rol_b_rr,(RW1 d, R1 r))
+{
+	ROLBrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_rol_b_rr,(RW1 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shll_l_rr,(RW4 d, R1 r))
+{
+	SHLLrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shll_l_rr,(RW4 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shll_w_rr,(RW2 d, R1 r))
+{
+	SHLWrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shll_w_rr,(RW2 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shll_b_rr,(RW1 d, R1 r))
+{
+	SHLBrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shll_b_rr,(RW1 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_ror_b_ri,(RW1 r, IMM i))
+{
+	RORBir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_ror_b_ri,(RW1 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_ror_w_ri,(RW2 r, IMM i))
+{
+	RORWir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_ror_w_ri,(RW2 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_ror_l_ri,(RW4 r, IMM i))
+{
+	RORLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_ror_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_ror_l_rr,(RW4 d, R1 r))
+{
+	RORLrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_ror_l_rr,(RW4 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_ror_w_rr,(RW2 d, R1 r))
+{
+	RORWrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_ror_w_rr,(RW2 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_ror_b_rr,(RW1 d, R1 r))
+{
+	RORBrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_ror_b_rr,(RW1 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shrl_l_rr,(RW4 d, R1 r))
+{
+	SHRLrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shrl_l_rr,(RW4 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shrl_w_rr,(RW2 d, R1 r))
+{
+	SHRWrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shrl_w_rr,(RW2 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shrl_b_rr,(RW1 d, R1 r))
+{
+	SHRBrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shrl_b_rr,(RW1 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shra_l_rr,(RW4 d, R1 r))
+{
+	SARLrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shra_l_rr,(RW4 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shra_w_rr,(RW2 d, R1 r))
+{
+	SARWrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shra_w_rr,(RW2 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shra_b_rr,(RW1 d, R1 r))
+{
+	SARBrr(r, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_shra_b_rr,(RW1 d, R1 r))
+
+	LOWFUNC(WRITE,NONE,2,raw_shll_l_ri,(RW4 r, IMM i))
+{
+	SHLLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shll_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shll_w_ri,(RW2 r, IMM i))
+{
+	SHLWir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shll_w_ri,(RW2 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shll_b_ri,(RW1 r, IMM i))
+{
+	SHLBir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shll_b_ri,(RW1 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shrl_l_ri,(RW4 r, IMM i))
+{
+	SHRLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shrl_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shrl_w_ri,(RW2 r, IMM i))
+{
+	SHRWir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shrl_w_ri,(RW2 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shrl_b_ri,(RW1 r, IMM i))
+{
+	SHRBir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shrl_b_ri,(RW1 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shra_l_ri,(RW4 r, IMM i))
+{
+	SARLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shra_l_ri,(RW4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shra_w_ri,(RW2 r, IMM i))
+{
+	SARWir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shra_w_ri,(RW2 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_shra_b_ri,(RW1 r, IMM i))
+{
+	SARBir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_shra_b_ri,(RW1 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,1,raw_sahf,(R2 dummy_ah))
+{
+	SAHF();
+}
+LENDFUNC(WRITE,NONE,1,raw_sahf,(R2 dummy_ah))
+
+	LOWFUNC(NONE,NONE,1,raw_cpuid,(R4 dummy_eax))
+{
+	CPUID();
+}
+LENDFUNC(NONE,NONE,1,raw_cpuid,(R4 dummy_eax))
+
+	LOWFUNC(READ,NONE,1,raw_lahf,(W2 dummy_ah))
+{
+	LAHF();
+}
+LENDFUNC(READ,NONE,1,raw_lahf,(W2 dummy_ah))
+
+	LOWFUNC(READ,NONE,2,raw_setcc,(W1 d, IMM cc))
+{
+	SETCCir(cc, d);
+}
+LENDFUNC(READ,NONE,2,raw_setcc,(W1 d, IMM cc))
+
+	LOWFUNC(READ,WRITE,2,raw_setcc_m,(MEMW d, IMM cc))
+{
+	int b = raw_abs(&d, 1);
+	SETCCim(cc, d, b, X86_NOREG, 1);
+}
+LENDFUNC(READ,WRITE,2,raw_setcc_m,(MEMW d, IMM cc))
+
+	LOWFUNC(READ,NONE,3,raw_cmov_b_rr,(RW1 d, R1 s, IMM cc))
+{
+	uae_s8 *target_p = (uae_s8 *)x86_get_target() + 1;
+	JCCSii(cc^1, 0);
+	MOVBrr(s, d);
+	*target_p = (uintptr)x86_get_target() - ((uintptr)target_p + 1);
+}
+LENDFUNC(READ,NONE,3,raw_cmov_b_rr,(RW1 d, R1 s, IMM cc))
+
+	LOWFUNC(READ,NONE,3,raw_cmov_w_rr,(RW2 d, R2 s, IMM cc))
+{
+	CMOVWrr(cc, s, d);
+}
+LENDFUNC(READ,NONE,3,raw_cmov_w_rr,(RW2 d, R2 s, IMM cc))
+
+	LOWFUNC(READ,NONE,3,raw_cmov_l_rr,(RW4 d, R4 s, IMM cc))
+{
+	CMOVLrr(cc, s, d);
+}
+LENDFUNC(READ,NONE,3,raw_cmov_l_rr,(RW4 d, R4 s, IMM cc))
+
+	LOWFUNC(WRITE,NONE,2,raw_bsf_l_rr,(W4 d, R4 s))
+{
+	BSFLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_bsf_l_rr,(W4 d, R4 s))
+
+	LOWFUNC(NONE,NONE,2,raw_sign_extend_16_rr,(W4 d, R2 s))
+{
+	MOVSWLrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_sign_extend_16_rr,(W4 d, R2 s))
+
+	LOWFUNC(NONE,NONE,2,raw_sign_extend_8_rr,(W4 d, R1 s))
+{
+	MOVSBLrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_sign_extend_8_rr,(W4 d, R1 s))
+
+	LOWFUNC(NONE,NONE,2,raw_zero_extend_16_rr,(W4 d, R2 s))
+{
+	MOVZWLrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_zero_extend_16_rr,(W4 d, R2 s))
+
+	LOWFUNC(NONE,NONE,2,raw_zero_extend_8_rr,(W4 d, R1 s))
+{
+	MOVZBLrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_zero_extend_8_rr,(W4 d, R1 s))
+
+	LOWFUNC(NONE,NONE,2,raw_imul_32_32,(RW4 d, R4 s))
+{
+	IMULLrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_imul_32_32,(RW4 d, R4 s))
+
+	LOWFUNC(NONE,NONE,2,raw_imul_64_32,(RW4 d, RW4 s))
+{
+#ifdef JIT_DEBUG
+	if (d!=MUL_NREG1 || s!=MUL_NREG2) {
+		write_log (L"JIT: Bad register in IMUL: d=%d, s=%d\n",d,s);
+		abort();
+	}
+#endif
+	IMULLr(s);
+}
+LENDFUNC(NONE,NONE,2,raw_imul_64_32,(RW4 d, RW4 s))
+
+	LOWFUNC(NONE,NONE,2,raw_mul_64_32,(RW4 d, RW4 s))
+{
+#ifdef JIT_DEBUG
+	if (d!=MUL_NREG1 || s!=MUL_NREG2) {
+		write_log (L"JIT: Bad register in MUL: d=%d, s=%d\n",d,s);
+		abort();
+	}
+#endif
+	MULLr(s);
+}
+LENDFUNC(NONE,NONE,2,raw_mul_64_32,(RW4 d, RW4 s))
+
+	LOWFUNC(NONE,NONE,2,raw_mov_b_rr,(W1 d, R1 s))
+{
+	MOVBrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_mov_b_rr,(W1 d, R1 s))
+
+	LOWFUNC(NONE,NONE,2,raw_mov_w_rr,(W2 d, R2 s))
+{
+	MOVWrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_mov_w_rr,(W2 d, R2 s))
+
+	LOWFUNC(NONE,READ,3,raw_mov_l_rrm_indexed,(W4 d, R4 baser, R4 index))
+{
+	ADDR32 MOVLmr(0, baser, index, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_l_rrm_indexed,(W4 d, R4 baser, R4 index))
+
+	LOWFUNC(NONE,READ,3,raw_mov_w_rrm_indexed,(W2 d, R4 baser, R4 index))
+{
+	ADDR32 MOVWmr(0, baser, index, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_w_rrm_indexed,(W2 d, R4 baser, R4 index))
+
+	LOWFUNC(NONE,READ,3,raw_mov_b_rrm_indexed,(W1 d, R4 baser, R4 index))
+{
+	ADDR32 MOVBmr(0, baser, index, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_b_rrm_indexed,(W1 d, R4 baser, R4 index))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_l_mrr_indexed,(R4 baser, R4 index, R4 s))
+{
+	ADDR32 MOVLrm(s, 0, baser, index, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_l_mrr_indexed,(R4 baser, R4 index, R4 s))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_w_mrr_indexed,(R4 baser, R4 index, R2 s))
+{
+	ADDR32 MOVWrm(s, 0, baser, index, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_w_mrr_indexed,(R4 baser, R4 index, R2 s))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_b_mrr_indexed,(R4 baser, R4 index, R1 s))
+{
+	ADDR32 MOVBrm(s, 0, baser, index, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_b_mrr_indexed,(R4 baser, R4 index, R1 s))
+
+	LOWFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, MEMR base, R4 index))
+{
+	/* base is a table of host pointers, only the low half is wanted */
+	int b = raw_abs(&base, 0);
+	MOVLmr(base, b, index, 8, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, MEMR base, R4 index))
+
+	LOWFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, MEMR base, R4 index, IMM cond))
+{
+	/* base is a table of host pointers, fetch all of it */
+	int b = raw_abs(&base, 0);
+	CMOVQmr(cond, base, b, index, 8, d);
+}
+LENDFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, MEMR base, R4 index, IMM cond))
+
+	LOWFUNC(NONE,READ,3,raw_cmov_l_rm,(W4 d, MEMR mem, IMM cond))
+{
+	int b = raw_abs(&mem, 1);
+	CMOVLmr(cond, mem, b, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_cmov_l_rm,(W4 d, MEMR mem, IMM cond))
+
+	LOWFUNC(NONE,READ,3,raw_mov_l_rR,(W4 d, R4 s, IMM offset))
+{
+	ADDR32 MOVLmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_l_rR,(W4 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,READ,3,raw_mov_w_rR,(W2 d, R4 s, IMM offset))
+{
+	ADDR32 MOVWmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_w_rR,(W2 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,READ,3,raw_mov_b_rR,(W1 d, R4 s, IMM offset))
+{
+	ADDR32 MOVBmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_b_rR,(W1 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,READ,3,raw_mov_l_brR,(W4 d, R4 s, IMM offset))
+{
+	ADDR32 MOVLmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_l_brR,(W4 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,READ,3,raw_mov_w_brR,(W2 d, R4 s, IMM offset))
+{
+	ADDR32 MOVWmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_w_brR,(W2 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,READ,3,raw_mov_b_brR,(W1 d, R4 s, IMM offset))
+{
+	ADDR32 MOVBmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,3,raw_mov_b_brR,(W1 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_l_Ri,(R4 d, IMM i, IMM offset))
+{
+	ADDR32 MOVLim(i, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_l_Ri,(R4 d, IMM i, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_w_Ri,(R4 d, IMM i, IMM offset))
+{
+	ADDR32 MOVWim(i, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_w_Ri,(R4 d, IMM i, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_b_Ri,(R4 d, IMM i, IMM offset))
+{
+	ADDR32 MOVBim(i, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_b_Ri,(R4 d, IMM i, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_l_Rr,(R4 d, R4 s, IMM offset))
+{
+	ADDR32 MOVLrm(s, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_l_Rr,(R4 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_w_Rr,(R4 d, R2 s, IMM offset))
+{
+	ADDR32 MOVWrm(s, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_w_Rr,(R4 d, R2 s, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_b_Rr,(R4 d, R1 s, IMM offset))
+{
+	ADDR32 MOVBrm(s, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_b_Rr,(R4 d, R1 s, IMM offset))
+
+	LOWFUNC(NONE,NONE,3,raw_lea_l_brr,(W4 d, R4 s, IMM offset))
+{
+	LEALmr(offset, s, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,NONE,3,raw_lea_l_brr,(W4 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,NONE,5,raw_lea_l_brr_indexed,(W4 d, R4 s, R4 index, IMM factor, IMM offset))
+{
+	LEALmr(offset, s, index, factor, d);
+}
+LENDFUNC(NONE,NONE,5,raw_lea_l_brr_indexed,(W4 d, R4 s, R4 index, IMM factor, IMM offset))
+
+	LOWFUNC(NONE,NONE,3,raw_lea_l_rr_indexed,(W4 d, R4 s, R4 index))
+{
+	LEALmr(0, s, index, 1, d);
+}
+LENDFUNC(NONE,NONE,3,raw_lea_l_rr_indexed,(W4 d, R4 s, R4 index))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_l_bRr,(R4 d, R4 s, IMM offset))
+{
+	ADDR32 MOVLrm(s, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_l_bRr,(R4 d, R4 s, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_w_bRr,(R4 d, R2 s, IMM offset))
+{
+	ADDR32 MOVWrm(s, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_w_bRr,(R4 d, R2 s, IMM offset))
+
+	LOWFUNC(NONE,WRITE,3,raw_mov_b_bRr,(R4 d, R1 s, IMM offset))
+{
+	ADDR32 MOVBrm(s, offset, d, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,3,raw_mov_b_bRr,(R4 d, R1 s, IMM offset))
+
+	LOWFUNC(NONE,NONE,1,raw_bswap_32,(RW4 r))
+{
+	BSWAPLr(r);
+}
+LENDFUNC(NONE,NONE,1,raw_bswap_32,(RW4 r))
+
+	LOWFUNC(WRITE,NONE,1,raw_bswap_16,(RW2 r))
+{
+	ROLWir(8, r);
+}
+LENDFUNC(WRITE,NONE,1,raw_bswap_16,(RW2 r))
+
+	LOWFUNC(NONE,NONE,2,raw_mov_l_rr,(W4 d, R4 s))
+{
+	MOVLrr(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_mov_l_rr,(W4 d, R4 s))
+
+	LOWFUNC(NONE,WRITE,2,raw_mov_l_mr,(MEMW d, R4 s))
+{
+	int b = raw_abs(&d, 1);
+	MOVLrm(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,2,raw_mov_l_mr,(MEMW d, R4 s))
+
+	LOWFUNC(NONE,READ,2,raw_mov_l_rm,(W4 d, MEMR s))
+{
+	int b = raw_abs(&s, 1);
+	MOVLmr(s, b, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,2,raw_mov_l_rm,(W4 d, MEMR s))
+
+	LOWFUNC(NONE,WRITE,2,raw_mov_w_mr,(MEMW d, R2 s))
+{
+	int b = raw_abs(&d, 1);
+	MOVWrm(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,2,raw_mov_w_mr,(MEMW d, R2 s))
+
+	LOWFUNC(NONE,READ,2,raw_mov_w_rm,(W2 d, MEMR s))
+{
+	int b = raw_abs(&s, 1);
+	MOVWmr(s, b, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,2,raw_mov_w_rm,(W2 d, MEMR s))
+
+	LOWFUNC(NONE,WRITE,2,raw_mov_b_mr,(MEMW d, R1 s))
+{
+	int b = raw_abs(&d, 1);
+	MOVBrm(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(NONE,WRITE,2,raw_mov_b_mr,(MEMW d, R1 s))
+
+	LOWFUNC(NONE,READ,2,raw_mov_b_rm,(W1 d, MEMR s))
+{
+	int b = raw_abs(&s, 1);
+	MOVBmr(s, b, X86_NOREG, 1, d);
+}
+LENDFUNC(NONE,READ,2,raw_mov_b_rm,(W1 d, MEMR s))
+
+	LOWFUNC(NONE,NONE,2,raw_mov_l_ri,(W4 d, IMM s))
+{
+	MOVLir(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_mov_l_ri,(W4 d, IMM s))
+
+	LOWFUNC(NONE,NONE,2,raw_mov_w_ri,(W2 d, IMM s))
+{
+	MOVWir(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_mov_w_ri,(W2 d, IMM s))
+
+	LOWFUNC(NONE,NONE,2,raw_mov_b_ri,(W1 d, IMM s))
+{
+	MOVBir(s, d);
+}
+LENDFUNC(NONE,NONE,2,raw_mov_b_ri,(W1 d, IMM s))
+
+	LOWFUNC(RMW,RMW,2,raw_adc_l_mi,(MEMRW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	ADCLim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(RMW,RMW,2,raw_adc_l_mi,(MEMRW d, IMM s))
+
+	LOWFUNC(WRITE,RMW,2,raw_add_l_mi,(MEMRW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	ADDLim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(WRITE,RMW,2,raw_add_l_mi,(MEMRW d, IMM s))
+
+	LOWFUNC(WRITE,RMW,2,raw_add_w_mi,(MEMRW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	ADDWim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(WRITE,RMW,2,raw_add_w_mi,(MEMRW d, IMM s))
+
+	LOWFUNC(WRITE,RMW,2,raw_add_b_mi,(MEMRW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	ADDBim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(WRITE,RMW,2,raw_add_b_mi,(MEMRW d, IMM s))
+
+	LOWFUNC(WRITE,NONE,2,raw_test_l_ri,(R4 d, IMM i))
+{
+	TESTLir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_test_l_ri,(R4 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_test_l_rr,(R4 d, R4 s))
+{
+	TESTLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_test_l_rr,(R4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_test_w_rr,(R2 d, R2 s))
+{
+	TESTWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_test_w_rr,(R2 d, R2 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_test_b_rr,(R1 d, R1 s))
+{
+	TESTBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_test_b_rr,(R1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_and_l_ri,(RW4 d, IMM i))
+{
+	ANDLir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_and_l_ri,(RW4 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_and_w_ri,(RW2 d, IMM i))
+{
+	ANDWir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_and_w_ri,(RW2 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_and_l,(RW4 d, R4 s))
+{
+	ANDLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_and_l,(RW4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_and_w,(RW2 d, R2 s))
+{
+	ANDWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_and_w,(RW2 d, R2 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_and_b,(RW1 d, R1 s))
+{
+	ANDBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_and_b,(RW1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_or_l_ri,(RW4 d, IMM i))
+{
+	ORLir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_or_l_ri,(RW4 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_or_l,(RW4 d, R4 s))
+{
+	ORLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_or_l,(RW4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_or_w,(RW2 d, R2 s))
+{
+	ORWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_or_w,(RW2 d, R2 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_or_b,(RW1 d, R1 s))
+{
+	ORBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_or_b,(RW1 d, R1 s))
+
+	LOWFUNC(RMW,NONE,2,raw_adc_l,(RW4 d, R4 s))
+{
+	ADCLrr(s, d);
+}
+LENDFUNC(RMW,NONE,2,raw_adc_l,(RW4 d, R4 s))
+
+	LOWFUNC(RMW,NONE,2,raw_adc_w,(RW2 d, R2 s))
+{
+	ADCWrr(s, d);
+}
+LENDFUNC(RMW,NONE,2,raw_adc_w,(RW2 d, R2 s))
+
+	LOWFUNC(RMW,NONE,2,raw_adc_b,(RW1 d, R1 s))
+{
+	ADCBrr(s, d);
+}
+LENDFUNC(RMW,NONE,2,raw_adc_b,(RW1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_add_l,(RW4 d, R4 s))
+{
+	ADDLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_add_l,(RW4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_add_w,(RW2 d, R2 s))
+{
+	ADDWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_add_w,(RW2 d, R2 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_add_b,(RW1 d, R1 s))
+{
+	ADDBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_add_b,(RW1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_sub_l_ri,(RW4 d, IMM i))
+{
+	SUBLir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_sub_l_ri,(RW4 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_sub_b_ri,(RW1 d, IMM i))
+{
+	SUBBir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_sub_b_ri,(RW1 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_add_l_ri,(RW4 d, IMM i))
+{
+	ADDLir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_add_l_ri,(RW4 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_add_w_ri,(RW2 d, IMM i))
+{
+	ADDWir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_add_w_ri,(RW2 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_add_b_ri,(RW1 d, IMM i))
+{
+	ADDBir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_add_b_ri,(RW1 d, IMM i))
+
+	LOWFUNC(RMW,NONE,2,raw_sbb_l,(RW4 d, R4 s))
+{
+	SBBLrr(s, d);
+}
+LENDFUNC(RMW,NONE,2,raw_sbb_l,(RW4 d, R4 s))
+
+	LOWFUNC(RMW,NONE,2,raw_sbb_w,(RW2 d, R2 s))
+{
+	SBBWrr(s, d);
+}
+LENDFUNC(RMW,NONE,2,raw_sbb_w,(RW2 d, R2 s))
+
+	LOWFUNC(RMW,NONE,2,raw_sbb_b,(RW1 d, R1 s))
+{
+	SBBBrr(s, d);
+}
+LENDFUNC(RMW,NONE,2,raw_sbb_b,(RW1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_sub_l,(RW4 d, R4 s))
+{
+	SUBLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_sub_l,(RW4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_sub_w,(RW2 d, R2 s))
+{
+	SUBWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_sub_w,(RW2 d, R2 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_sub_b,(RW1 d, R1 s))
+{
+	SUBBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_sub_b,(RW1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_cmp_l,(R4 d, R4 s))
+{
+	CMPLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_cmp_l,(R4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_cmp_l_ri,(R4 r, IMM i))
+{
+	CMPLir(i, r);
+}
+LENDFUNC(WRITE,NONE,2,raw_cmp_l_ri,(R4 r, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_cmp_w,(R2 d, R2 s))
+{
+	CMPWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_cmp_w,(R2 d, R2 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_cmp_b_ri,(R1 d, IMM i))
+{
+	CMPBir(i, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_cmp_b_ri,(R1 d, IMM i))
+
+	LOWFUNC(WRITE,NONE,2,raw_cmp_b,(R1 d, R1 s))
+{
+	CMPBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_cmp_b,(R1 d, R1 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_xor_l,(RW4 d, R4 s))
+{
+	XORLrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_xor_l,(RW4 d, R4 s))
+
+	LOWFUNC(WRITE,NONE,2,raw_xor_w,(RW2 d, R2 s))
+{
+	XORWrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_xor_w,(RW2 d, R2 s))
 
-/*************************************************************************
-* Actual encoding of the instructions on the target CPU                 *
-*************************************************************************/
+	LOWFUNC(WRITE,NONE,2,raw_xor_b,(RW1 d, R1 s))
+{
+	XORBrr(s, d);
+}
+LENDFUNC(WRITE,NONE,2,raw_xor_b,(RW1 d, R1 s))
 
-//#include "compemu_optimizer_x86.c"
+	LOWFUNC(WRITE,RMW,2,raw_sub_l_mi,(MEMRW d, IMM s))
+{
+	int b = raw_abs(&d, 1);
+	SUBLim(s, d, b, X86_NOREG, 1);
+}
+LENDFUNC(WRITE,RMW,2,raw_sub_l_mi,(MEMRW d, IMM s))
 
-STATIC_INLINE uae_u16 swap16(uae_u16 x)
+	LOWFUNC(WRITE,READ,2,raw_cmp_l_mi,(MEMR d, IMM s))
 {
-	return ((x&0xff00)>>8)|((x&0x00ff)<<8);
+	int b = raw_abs(&d, 1);
+	CMPLim(s, d, b, X86_NOREG, 1);
 }
+LENDFUNC(WRITE,READ,2,raw_cmp_l_mi,(MEMR d, IMM s))
 
-STATIC_INLINE uae_u32 swap32(uae_u32 x)
+	LOWFUNC(NONE,NONE,2,raw_xchg_l_rr,(RW4 r1, RW4 r2))
 {
-	return ((x&0xff00)<<8)|((x&0x00ff)<<24)|((x&0xff0000)>>8)|((x&0xff000000)>>24);
+	XCHGLrr(r2, r1);
 }
+LENDFUNC(NONE,NONE,2,raw_xchg_l_rr,(RW4 r1, RW4 r2))
 
-STATIC_INLINE int isbyte(uae_s32 x)
+	LOWFUNC(READ,WRITE,0,raw_pushfl,(void))
 {
-	return (x>=-128 && x<=127);
+	PUSHF();
+}
+LENDFUNC(READ,WRITE,0,raw_pushfl,(void))
+
+	LOWFUNC(WRITE,READ,0,raw_popfl,(void))
+{
+	POPF();
 }
+LENDFUNC(WRITE,READ,0,raw_popfl,(void))
+
+#else
 
 LOWFUNC(NONE,WRITE,1,raw_push_l_r,(R4 r))
 {
@@ -764,16 +1731,16 @@ LENDFUNC(NONE,WRITE,3,raw_mov_w_mrr_indexed,(R4 baser, R4 index, R2 s))
 }
 LENDFUNC(NONE,WRITE,3,raw_mov_b_mrr_indexed,(R4 baser, R4 index, R1 s))
 
-	LOWFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, IMM base, R4 index))
+	LOWFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, MEMR base, R4 index))
 {
 	emit_byte(0x8b);
 	emit_byte(0x04+8*d);
 	emit_byte(0x85+8*index);
 	emit_long(base);
 }
-LENDFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, IMM base, R4 index))
+LENDFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, MEMR base, R4 index))
 
-	LOWFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, IMM base, R4 index, IMM cond))
+	LOWFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, MEMR base, R4 index, IMM cond))
 {
 	if (have_cmov) {
 		emit_byte(0x0f);
@@ -789,9 +1756,9 @@ LENDFUNC(NONE,READ,3,raw_mov_l_rm_indexed,(W4 d, IMM base, R4 index))
 	emit_byte(0x85+8*index);
 	emit_long(base);
 }
-LENDFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, IMM base, R4 index, IMM cond))
+LENDFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, MEMR base, R4 index, IMM cond))
 
-	LOWFUNC(NONE,READ,3,raw_cmov_l_rm,(W4 d, IMM mem, IMM cond))
+	LOWFUNC(NONE,READ,3,raw_cmov_l_rm,(W4 d, MEMR mem, IMM cond))
 {
 	if (have_cmov) {
 		emit_byte(0x0f);
@@ -808,7 +1775,7 @@ LENDFUNC(NONE,READ,4,raw_cmov_l_rm_indexed,(W4 d, IMM base, R4 index, IMM cond))
 		emit_long(mem);
 	}
 }
-LENDFUNC(NONE,READ,3,raw_cmov_l_rm,(W4 d, IMM mem, IMM cond))
+LENDFUNC(NONE,READ,3,raw_cmov_l_rm,(W4 d, MEMR mem, IMM cond))
 
 	LOWFUNC(NONE,READ,3,raw_mov_l_rR,(W4 d, R4 s, IMM offset))
 {
@@ -1003,13 +1970,13 @@ LENDFUNC(WRITE,NONE,1,raw_bswap_16,(RW2 r))
 }
 LENDFUNC(NONE,NONE,2,raw_mov_l_rr,(W4 d, R4 s))
 
-	LOWFUNC(NONE,WRITE,2,raw_mov_l_mr,(IMM d, R4 s))
+	LOWFUNC(NONE,WRITE,2,raw_mov_l_mr,(MEMW d, R4 s))
 {
 	emit_byte(0x89);
 	emit_byte(0x05+8*s);
 	emit_long(d);
 }
-LENDFUNC(NONE,WRITE,2,raw_mov_l_mr,(IMM d, R4 s))
+LENDFUNC(NONE,WRITE,2,raw_mov_l_mr,(MEMW d, R4 s))
 
 	LOWFUNC(NONE,READ,2,raw_mov_l_rm,(W4 d, MEMR s))
 {
@@ -1019,39 +1986,39 @@ LENDFUNC(NONE,WRITE,2,raw_mov_l_mr,(IMM d, R4 s))
 }
 LENDFUNC(NONE,READ,2,raw_mov_l_rm,(W4 d, MEMR s))
 
-	LOWFUNC(NONE,WRITE,2,raw_mov_w_mr,(IMM d, R2 s))
+	LOWFUNC(NONE,WRITE,2,raw_mov_w_mr,(MEMW d, R2 s))
 {
 	emit_byte(0x66);
 	emit_byte(0x89);
 	emit_byte(0x05+8*s);
 	emit_long(d);
 }
-LENDFUNC(NONE,WRITE,2,raw_mov_w_mr,(IMM d, R2 s))
+LENDFUNC(NONE,WRITE,2,raw_mov_w_mr,(MEMW d, R2 s))
 
-	LOWFUNC(NONE,READ,2,raw_mov_w_rm,(W2 d, IMM s))
+	LOWFUNC(NONE,READ,2,raw_mov_w_rm,(W2 d, MEMR s))
 {
 	emit_byte(0x66);
 	emit_byte(0x8b);
 	emit_byte(0x05+8*d);
 	emit_long(s);
 }
-LENDFUNC(NONE,READ,2,raw_mov_w_rm,(W2 d, IMM s))
+LENDFUNC(NONE,READ,2,raw_mov_w_rm,(W2 d, MEMR s))
 
-	LOWFUNC(NONE,WRITE,2,raw_mov_b_mr,(IMM d, R1 s))
+	LOWFUNC(NONE,WRITE,2,raw_mov_b_mr,(MEMW d, R1 s))
 {
 	emit_byte(0x88);
 	emit_byte(0x05+8*s);
 	emit_long(d);
 }
-LENDFUNC(NONE,WRITE,2,raw_mov_b_mr,(IMM d, R1 s))
+LENDFUNC(NONE,WRITE,2,raw_mov_b_mr,(MEMW d, R1 s))
 
-	LOWFUNC(NONE,READ,2,raw_mov_b_rm,(W1 d, IMM s))
+	LOWFUNC(NONE,READ,2,raw_mov_b_rm,(W1 d, MEMR s))
 {
 	emit_byte(0x8a);
 	emit_byte(0x05+8*d);
 	emit_long(s);
 }
-LENDFUNC(NONE,READ,2,raw_mov_b_rm,(W1 d, IMM s))
+LENDFUNC(NONE,READ,2,raw_mov_b_rm,(W1 d, MEMR s))
 
 	LOWFUNC(NONE,NONE,2,raw_mov_l_ri,(W4 d, IMM s))
 {
@@ -1084,16 +2051,16 @@ LENDFUNC(NONE,NONE,2,raw_mov_b_ri,(W1 d, IMM s))
 }
 LENDFUNC(RMW,RMW,2,raw_adc_l_mi,(MEMRW d, IMM s))
 
-	LOWFUNC(WRITE,RMW,2,raw_add_l_mi,(IMM d, IMM s))
+	LOWFUNC(WRITE,RMW,2,raw_add_l_mi,(MEMRW d, IMM s))
 {
 	emit_byte(0x81);
 	emit_byte(0x05);
 	emit_long(d);
 	emit_long(s);
 }
-LENDFUNC(WRITE,RMW,2,raw_add_l_mi,(IMM d, IMM s))
+LENDFUNC(WRITE,RMW,2,raw_add_l_mi,(MEMRW d, IMM s))
 
-	LOWFUNC(WRITE,RMW,2,raw_add_w_mi,(IMM d, IMM s))
+	LOWFUNC(WRITE,RMW,2,raw_add_w_mi,(MEMRW d, IMM s))
 {
 	emit_byte(0x66);
 	emit_byte(0x81);
@@ -1101,16 +2068,16 @@ LENDFUNC(WRITE,RMW,2,raw_add_l_mi,(IMM d, IMM s))
 	emit_long(d);
 	emit_word(s);
 }
-LENDFUNC(WRITE,RMW,2,raw_add_w_mi,(IMM d, IMM s))
+LENDFUNC(WRITE,RMW,2,raw_add_w_mi,(MEMRW d, IMM s))
 
-	LOWFUNC(WRITE,RMW,2,raw_add_b_mi,(IMM d, IMM s))
+	LOWFUNC(WRITE,RMW,2,raw_add_b_mi,(MEMRW d, IMM s))
 {
 	emit_byte(0x80);
 	emit_byte(0x05);
 	emit_long(d);
 	emit_byte(s);
 }
-LENDFUNC(WRITE,RMW,2,raw_add_b_mi,(IMM d, IMM s))
+LENDFUNC(WRITE,RMW,2,raw_add_b_mi,(MEMRW d, IMM s))
 
 	LOWFUNC(WRITE,NONE,2,raw_test_l_ri,(R4 d, IMM i))
 {
@@ -1459,6 +2426,8 @@ LENDFUNC(READ,WRITE,0,raw_pushfl,(void))
 }
 LENDFUNC(WRITE,READ,0,raw_popfl,(void))
 
+#endif
+
 	/*************************************************************************
 	* Unoptimizable stuff --- jump                                          *
 	*************************************************************************/
@@ -1466,19 +2435,44 @@ LENDFUNC(WRITE,READ,0,raw_popfl,(void))
 	STATIC_INLINE void raw_call_r(R4 r)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	CALLsr(r);
+#else
 	emit_byte(0xff);
 	emit_byte(0xd0+r);
+#endif
 }
 
 STATIC_INLINE void raw_jmp_r(R4 r)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	JMPsr(r);
+#else
 	emit_byte(0xff);
 	emit_byte(0xe0+r);
+#endif
+}
+
+/* Load a host pointer into a native register */
+STATIC_INLINE void raw_mov_p_ri(R4 r, uintptr i)
+{
+#if defined(CPU_64_BIT)
+	MOVQir(i, r);
+#else
+	raw_mov_l_ri(r, i);
+#endif
 }
 
-STATIC_INLINE void raw_jmp_m_indexed(uae_u32 base, uae_u32 r, uae_u32 m)
+STATIC_INLINE void raw_jmp_m_indexed(uintptr base, uae_u32 r, uae_u32 m)
 {
+#if defined(CPU_64_BIT)
+	int b;
+
+	lopt_emit_all();
+	b = raw_abs(&base, 0);
+	JMPsm(base, b, r, m);
+#else
 	int sib;
 
 	switch (m) {
@@ -1493,52 +2487,106 @@ STATIC_INLINE void raw_jmp_m_indexed(uae_u32 base, uae_u32 r, uae_u32 m)
 	emit_byte(0x24);
 	emit_byte(8*r+sib);
 	emit_long(base);
+#endif
+}
+
+/* Store a pointer sized immediate to base[r]. tmp is clobbered on x86-64 */
+STATIC_INLINE void raw_mov_p_mi_indexed(uintptr base, uae_u32 r, uintptr v, uae_u32 tmp)
+{
+#if defined(CPU_64_BIT)
+	lopt_emit_all();
+	raw_mov_q_mi_indexed(base, r, v, tmp);
+#else
+	lopt_emit_all();
+	emit_byte(0xc7);
+	emit_byte(0x04);
+	emit_byte(8*r+0x85);
+	emit_long(base);
+	emit_long(v);
+#endif
 }
 
-STATIC_INLINE void raw_jmp_m(uae_u32 base)
+STATIC_INLINE void raw_jmp_m(uintptr base)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	int b = raw_abs(&base, 1);
+	JMPsm(base, b, X86_NOREG, 1);
+#else
 	emit_byte(0xff);
 	emit_byte(0x25);
 	emit_long(base);
+#endif
 }
 
-STATIC_INLINE void raw_call(uae_u32 t)
+STATIC_INLINE void raw_call(uintptr t)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	if (!raw_rel32_ok(t)) {
+		MOVQir(t, R11_INDEX);
+		CALLsr(R11_INDEX);
+		return;
+	}
+#endif
 	emit_byte(0xe8);
-	emit_long(t-(uae_u32)target-4);
+	emit_long(t-(uintptr)target-4);
 }
 
-STATIC_INLINE void raw_jmp(uae_u32 t)
+STATIC_INLINE void raw_jmp(uintptr t)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	if (!raw_rel32_ok(t)) {
+		MOVQir(t, R11_INDEX);
+		JMPsr(R11_INDEX);
+		return;
+	}
+#endif
 	emit_byte(0xe9);
-	emit_long(t-(uae_u32)target-4);
+	emit_long(t-(uintptr)target-4);
 }
 
-STATIC_INLINE void raw_jl(uae_u32 t)
+STATIC_INLINE void raw_jl(uintptr t)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	if (!raw_rel32_ok(t)) {
+		raw_jcc_far(0x0c, t);
+		return;
+	}
+#endif
 	emit_byte(0x0f);
 	emit_byte(0x8c);
-	emit_long(t-(uae_u32)target-4);
+	emit_long(t-(uintptr)target-4);
 }
 
-STATIC_INLINE void raw_jz(uae_u32 t)
+STATIC_INLINE void raw_jz(uintptr t)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	if (!raw_rel32_ok(t)) {
+		raw_jcc_far(0x04, t);
+		return;
+	}
+#endif
 	emit_byte(0x0f);
 	emit_byte(0x84);
-	emit_long(t-(uae_u32)target-4);
+	emit_long(t-(uintptr)target-4);
 }
 
-STATIC_INLINE void raw_jnz(uae_u32 t)
+STATIC_INLINE void raw_jnz(uintptr t)
 {
 	lopt_emit_all();
+#if defined(CPU_64_BIT)
+	if (!raw_rel32_ok(t)) {
+		raw_jcc_far(0x05, t);
+		return;
+	}
+#endif
 	emit_byte(0x0f);
 	emit_byte(0x85);
-	emit_long(t-(uae_u32)target-4);
+	emit_long(t-(uintptr)target-4);
 }
 
 STATIC_INLINE void raw_jnz_l_oponly(void)
@@ -1603,11 +2651,18 @@ STATIC_INLINE void raw_flags_to_reg(int r)
 {
 	raw_lahf(0);  /* Most flags in AH */
 	//raw_setcc(r,0); /* V flag in AL */
-	raw_setcc_m((uae_u32)live.state[FLAGTMP].mem,0);
+	raw_setcc_m((uintptr)live.state[FLAGTMP].mem,0);
 
 #if 1   /* Let's avoid those nasty partial register stalls */
-	//raw_mov_b_mr((uae_u32)live.state[FLAGTMP].mem,r);
-	raw_mov_b_mr(((uae_u32)live.state[FLAGTMP].mem)+1,r+4);
+	//raw_mov_b_mr((uintptr)live.state[FLAGTMP].mem,r);
+#if defined(CPU_64_BIT)
+	/* %ah can't be encoded together with a REX prefix, which the store
+	may need, so go through %al */
+	raw_mov_b_rr(r,r-EAX_INDEX+AH_INDEX);
+	raw_mov_b_mr(((uintptr)live.state[FLAGTMP].mem)+1,r);
+#else
+	raw_mov_b_mr(((uintptr)live.state[FLAGTMP].mem)+1,r+4);
+#endif
 	//live.state[FLAGTMP].status=CLEAN;
 	live.state[FLAGTMP].status=INMEM;
 	live.state[FLAGTMP].realreg=-1;
@@ -1632,10 +2687,10 @@ flag reload to avoid the partial memory stall */
 STATIC_INLINE void raw_load_flagreg(uae_u32 target, uae_u32 r)
 {
 #if 1
-	raw_mov_l_rm(target,(uae_u32)live.state[r].mem);
+	raw_mov_l_rm(target,(uintptr)live.state[r].mem);
 #else
-	raw_mov_b_rm(target,(uae_u32)live.state[r].mem);
-	raw_mov_b_rm(target+4,((uae_u32)live.state[r].mem)+1);
+	raw_mov_b_rm(target,(uintptr)live.state[r].mem);
+	raw_mov_b_rm(target+4,((uintptr)live.state[r].mem)+1);
 #endif
 }
 
@@ -1643,9 +2698,9 @@ STATIC_INLINE void raw_load_flagreg(uae_u32 target, uae_u32 r)
 STATIC_INLINE void raw_load_flagx(uae_u32 target, uae_u32 r)
 {
 	if (live.nat[target].canword)
-		raw_mov_w_rm(target,(uae_u32)live.state[r].mem);
+		raw_mov_w_rm(target,(uintptr)live.state[r].mem);
 	else
-		raw_mov_l_rm(target,(uae_u32)live.state[r].mem);
+		raw_mov_l_rm(target,(uintptr)live.state[r].mem);
 }
 
 #define NATIVE_FLAG_Z 0x40
@@ -1667,7 +2722,20 @@ STATIC_INLINE void raw_flags_set_zero(int f, int r, int t)
 
 STATIC_INLINE void raw_inc_sp(int off)
 {
+#if defined(CPU_64_BIT)
+	ADDQir(off, ESP_INDEX);
+#else
 	raw_add_l_ri(4,off);
+#endif
+}
+
+STATIC_INLINE void raw_dec_sp(int off)
+{
+#if defined(CPU_64_BIT)
+	SUBQir(off, ESP_INDEX);
+#else
+	raw_sub_l_ri(4,off);
+#endif
 }
 
 /*************************************************************************
@@ -1708,6 +2776,7 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 	int size=4;
 	int dir=-1;
 	int len=0;
+	int rex=0;
 
 	if (n_except != STATUS_ACCESS_VIOLATION || !canbang || currprefs.cachesize == 0)
 		return EXCEPTION_CONTINUE_SEARCH;
@@ -1729,11 +2798,20 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 		write_log (L"JIT: Argh --- Am already in a handler. Shouldn't happen!\n");
 
 	if (canbang && i>=compiled_code && i<=current_compile_p) {
-		if (*i==0x66) {
+		for (;;) {
+			if (*i==0x66)
+				size=2;
+			else if (*i!=0x67) /* x64 guest accesses are addr32 */
+				break;
 			i++;
-			size=2;
 			len++;
 		}
+#if defined(CPU_64_BIT)
+		if ((*i&0xf0)==0x40) {
+			rex=*i++;
+			len++;
+		}
+#endif
 
 		switch(i[0]) {
 		case 0x8a:
@@ -1799,10 +2877,29 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 
 	if (r!=-1) {
 		void* pr=NULL;
+
+		/* A SIB byte follows the ModR/M byte */
+		if ((i[1]&0xc0)!=0xc0 && (i[1]&7)==4)
+			len++;
+#if defined(CPU_64_BIT)
+		if (rex&4)
+			r+=8;
+#endif
 #ifdef JIT_DEBUG
 		write_log (L"JIT: register was %d, direction was %d, size was %d\n",r,dir,size);
 #endif
 
+#if defined(CPU_64_BIT)
+		/* With a REX prefix, byte registers 4-7 are %spl-%dil, not %ah-%bh */
+		if (rex && size==1 && r>=4 && r<8) {
+			switch(r) {
+			case 4: pr=&(pContext->Rsp); break;
+			case 5: pr=&(pContext->Rbp); break;
+			case 6: pr=&(pContext->Rsi); break;
+			case 7: pr=&(pContext->Rdi); break;
+			}
+		} else
+#endif
 		switch(r) {
 #if defined(CPU_64_BIT)
 		case 0: pr=&(pContext->Rax); break;
@@ -1819,6 +2916,14 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 		case 7: pr=(size>1)?
 					(void*)(&(pContext->Rdi)):
 			(void*)(((uae_u8*)&(pContext->Rbx))+1); break;
+		case 8: pr=&(pContext->R8); break;
+		case 9: pr=&(pContext->R9); break;
+		case 10: pr=&(pContext->R10); break;
+		case 11: pr=&(pContext->R11); break;
+		case 12: pr=&(pContext->R12); break;
+		case 13: pr=&(pContext->R13); break;
+		case 14: pr=&(pContext->R14); break;
+		case 15: pr=&(pContext->R15); break;
 #else
 		case 0: pr=&(pContext->Eax); break;
 		case 1: pr=&(pContext->Ecx); break;
@@ -1839,9 +2944,16 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 		}
 		if (pr) {
 			blockinfo* bi;
+			int oldsegv=currprefs.comp_oldsegv;
 
-			if (currprefs.comp_oldsegv) {
-				addr-=(uae_u32)NATMEM_OFFSET;
+#if defined(CPU_64_BIT)
+			/* The jump patched in below needs veccode within rel32 reach */
+			if ((uae_s64)((uintptr)veccode-(uintptr)ctxPC) <= -0x7ff00000LL ||
+				(uae_s64)((uintptr)veccode-(uintptr)ctxPC) >= 0x7ff00000LL)
+				oldsegv=1;
+#endif
+			if (oldsegv) {
+				addr-=(uae_u32)(uintptr)NATMEM_OFFSET;
 
 #ifdef JIT_DEBUG
 				if ((addr>=0x10000000 && addr<0x40000000) ||
@@ -1853,7 +2965,12 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 					switch (size) {
 					case 1: *((uae_u8*)pr)=get_byte (addr); break;
 					case 2: *((uae_u16*)pr)=swap16(get_word (addr)); break;
+#if defined(CPU_64_BIT)
+					/* 32-bit loads clear the upper half */
+					case 4: *((uae_u64*)pr)=swap32(get_long (addr)); break;
+#else
 					case 4: *((uae_u32*)pr)=swap32(get_long (addr)); break;
+#endif
 					default: abort();
 					}
 				}
@@ -1876,8 +2993,13 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 				void* tmp=target;
 				int i;
 				uae_u8 vecbuf[5];
+				int rr=r;
 
-				addr-=(uae_u32)NATMEM_OFFSET;
+				addr-=(uae_u32)(uintptr)NATMEM_OFFSET;
+#if defined(CPU_64_BIT)
+				if (!rex && size==1 && r>=4 && r<8)
+					rr=r-4+AH_INDEX;
+#endif
 
 #ifdef JIT_DEBUG
 				if ((addr>=0x10000000 && addr<0x40000000) ||
@@ -1890,7 +3012,7 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 				for (i=0;i<5;i++)
 					vecbuf[i]=target[i];
 				emit_byte(0xe9);
-				emit_long((uae_u32)veccode-(uae_u32)target-4);
+				emit_long((uintptr)veccode-(uintptr)target-4);
 #ifdef JIT_DEBUG
 
 				write_log (L"JIT: Create jump to %p\n",veccode);
@@ -1902,9 +3024,9 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 
 				if (dir==SIG_READ) {
 					switch(size) {
-					case 1: raw_mov_b_ri(r,get_byte (addr)); break;
-					case 2: raw_mov_w_ri(r,swap16(get_word (addr))); break;
-					case 4: raw_mov_l_ri(r,swap32(get_long (addr))); break;
+					case 1: raw_mov_b_ri(rr,get_byte (addr)); break;
+					case 2: raw_mov_w_ri(rr,swap16(get_word (addr))); break;
+					case 4: raw_mov_l_ri(rr,swap32(get_long (addr))); break;
 					default: abort();
 					}
 				}
@@ -1918,9 +3040,9 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 				}
 				for (i=0;i<5;i++)
 					raw_mov_b_mi(ctxPC+i,vecbuf[i]);
-				raw_mov_l_mi((uae_u32)&in_handler,0);
+				raw_mov_l_mi((uintptr)&in_handler,0);
 				emit_byte(0xe9);
-				emit_long(ctxPC+len-(uae_u32)target-4);
+				emit_long(ctxPC+len-(uintptr)target-4);
 				in_handler=1;
 				target=(uae_u8*)tmp;
 			}
@@ -1986,6 +3108,18 @@ int EvalException (LPEXCEPTION_POINTERS blah, int n_except)
 #endif
 	return EXCEPTION_CONTINUE_SEARCH;
 }
+#if defined(CPU_64_BIT)
+/* Win64 can't unwind through translated code, so __except frames never
+   see its faults. Catch them first, but only when they come from the cache. */
+static LONG CALLBACK EvalVectoredException(PEXCEPTION_POINTERS blah)
+{
+	uae_u8 *pc = (uae_u8*)blah->ContextRecord->Rip;
+
+	if (!compiled_code || pc < compiled_code || pc >= current_compile_p)
+		return EXCEPTION_CONTINUE_SEARCH;
+	return EvalException (blah, blah->ExceptionRecord->ExceptionCode);
+}
+#endif
 #else
 static void vec(int x, struct sigcontext sc)
 {
@@ -2399,12 +3533,16 @@ static void raw_init_cpu(void)
 	cpuid(0x80000000, &xlvl, NULL, NULL, NULL);
 	if ( (xlvl & 0xffff0000) == 0x80000000 ) {
 		if ( xlvl >= 0x80000001 ) {
-			uae_u32 features;
-			cpuid(0x80000001, NULL, NULL, NULL, &features);
+			uae_u32 features, ecx;
+			cpuid(0x80000001, NULL, NULL, &ecx, &features);
 			if (features & (1 << 29)) {
 				/* Assume x86-64 if long mode is supported */
 				c->x86_processor = X86_PROCESSOR_K8;
 			}
+#if defined(CPU_64_BIT)
+			/* Early x86-64 parts lack LAHF/SAHF in long mode */
+			have_lahf_lm = ecx & 1;
+#endif
 		}
 	}
 
@@ -2609,6 +3747,10 @@ static void raw_init_cpu(void)
 	if (have_cmov)
 		have_rat_stall=1;
 #endif
+#if defined(CPU_64_BIT)
+	if (!have_lahf_lm)
+		write_log (L"JIT: CPU lacks LAHF/SAHF in long mode, JIT disabled\n");
+#endif
 }
 #endif
 
@@ -2616,6 +3758,42 @@ static void raw_init_cpu(void)
 * FPU stuff                                                             *
 *************************************************************************/
 
+/* x87 operation "op /reg" on the memory at absolute address m */
+STATIC_INLINE void raw_fp_mem(int op, int reg, uintptr m)
+{
+#ifdef CPU_64_BIT
+	int b = raw_abs(&m, 1);
+	_ESCmi(m, b, X86_NOREG, 1, (reg<<3)|(op&7));
+#else
+	emit_byte(op);
+	emit_byte(0x05+8*reg);
+	emit_long(m);
+#endif
+}
+
+/* Scratch space of up to 12 bytes at [esp] for values on their way to
+or from the x87. %rsp is kept 16-byte aligned on x64. */
+STATIC_INLINE void raw_fp_stack_alloc(int n)
+{
+#ifdef CPU_64_BIT
+	SUBQir(16, ESP_INDEX);
+#else
+	emit_byte(0x83);
+	emit_byte(0xc4);
+	emit_byte(-n);
+#endif
+}
+
+STATIC_INLINE void raw_fp_stack_free(int n)
+{
+#ifdef CPU_64_BIT
+	ADDQir(16, ESP_INDEX);
+#else
+	emit_byte(0x83);
+	emit_byte(0xc4);
+	emit_byte(n);
+#endif
+}
 
 STATIC_INLINE void raw_fp_init(void)
 {
@@ -2721,18 +3899,14 @@ STATIC_INLINE void tos_make(int r)
 LOWFUNC(NONE,WRITE,2,raw_fmov_mr,(MEMW m, FR r))
 {
 	make_tos(r);
-	emit_byte(0xdd);
-	emit_byte(0x15);
-	emit_long(m);
+	raw_fp_mem(0xdd,2,m);
 }
 LENDFUNC(NONE,WRITE,2,raw_fmov_mr,(MEMW m, FR r))
 
 	LOWFUNC(NONE,WRITE,2,raw_fmov_mr_drop,(MEMW m, FR r))
 {
 	make_tos(r);
-	emit_byte(0xdd);
-	emit_byte(0x1d);
-	emit_long(m);
+	raw_fp_mem(0xdd,3,m);
 	live.onstack[live.tos]=-1;
 	live.tos--;
 	live.spos[r]=-2;
@@ -2741,18 +3915,14 @@ LENDFUNC(NONE,WRITE,2,raw_fmov_mr,(MEMW m, FR r))
 
 	LOWFUNC(NONE,READ,2,raw_fmov_rm,(FW r, MEMR m))
 {
-	emit_byte(0xdd);
-	emit_byte(0x05);
-	emit_long(m);
+	raw_fp_mem(0xdd,0,m);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,2,raw_fmov_rm,(FW r, MEMR m))
 
 	LOWFUNC(NONE,READ,2,raw_fmovi_rm,(FW r, MEMR m))
 {
-	emit_byte(0xdb);
-	emit_byte(0x05);
-	emit_long(m);
+	raw_fp_mem(0xdb,0,m);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,2,raw_fmovi_rm,(FW r, MEMR m))
@@ -2767,45 +3937,40 @@ LENDFUNC(NONE,READ,2,raw_fmovi_rm,(FW r, MEMR m))
 	*/
 
 	int rs;
+	uae_u8 *jae;
 	usereg(r);
 	rs = stackpos(r)+1;
 
 	/* Lower bound onto stack */
-	emit_byte(0xdd);
-	emit_byte(0x05);
-	emit_long((uae_u32)&bounds[0]); /* fld double from lower */
+	raw_fp_mem(0xdd,0,(uintptr)&bounds[0]); /* fld double from lower */
 
 	/* Clamp to lower */
 	emit_byte(0xdb);
 	emit_byte(0xf0+rs); /* fcomi lower,r */
 	emit_byte(0x73);
-	emit_byte(12);      /* jae to writeback */
+	jae=get_target();
+	emit_byte(0);       /* jae to writeback */
 
 	/* Upper bound onto stack */
 	emit_byte(0xdd);
 	emit_byte(0xd8);	/* fstp st(0) */
-	emit_byte(0xdd);
-	emit_byte(0x05);
-	emit_long((uae_u32)&bounds[1]); /* fld double from upper */
+	raw_fp_mem(0xdd,0,(uintptr)&bounds[1]); /* fld double from upper */
 
 	/* Clamp to upper */
 	emit_byte(0xdb);
 	emit_byte(0xf0+rs); /* fcomi upper,r */
 	emit_byte(0xdb);
 	emit_byte(0xd0+rs); /* fcmovnbe upper,r */
+	*jae=(uintptr)get_target()-((uintptr)jae+1);
 
 	/* Store to destination */
-	emit_byte(0xdb);
-	emit_byte(0x1d);
-	emit_long(m);
+	raw_fp_mem(0xdb,3,m);
 }
 LENDFUNC(NONE,WRITE,3,raw_fmovi_mrb,(MEMW m, FR r, double *bounds))
 
 	LOWFUNC(NONE,READ,2,raw_fmovs_rm,(FW r, MEMR m))
 {
-	emit_byte(0xd9);
-	emit_byte(0x05);
-	emit_long(m);
+	raw_fp_mem(0xd9,0,m);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,2,raw_fmovs_rm,(FW r, MEMR m))
@@ -2813,106 +3978,111 @@ LENDFUNC(NONE,READ,2,raw_fmovs_rm,(FW r, MEMR m))
 	LOWFUNC(NONE,WRITE,2,raw_fmovs_mr,(MEMW m, FR r))
 {
 	make_tos(r);
-	emit_byte(0xd9);
-	emit_byte(0x15);
-	emit_long(m);
+	raw_fp_mem(0xd9,2,m);
 }
 LENDFUNC(NONE,WRITE,2,raw_fmovs_mr,(MEMW m, FR r))
 
 	LOWFUNC(NONE,NONE,1,raw_fcuts_r,(FRW r))
 {
 	make_tos(r);     /* TOS = r */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0xfc); /* add -4 to esp */
+	raw_fp_stack_alloc(4);
 	emit_byte(0xd9);
 	emit_byte(0x1c);
 	emit_byte(0x24); /* fstp store r as SINGLE to [esp] and pop */
 	emit_byte(0xd9);
 	emit_byte(0x04);
 	emit_byte(0x24); /* fld load r as SINGLE from [esp] */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0x04); /* add +4 to esp */
+	raw_fp_stack_free(4);
 }
 LENDFUNC(NONE,NONE,1,raw_fcuts_r,(FRW r))
 
 	LOWFUNC(NONE,NONE,1,raw_fcut_r,(FRW r))
 {
 	make_tos(r);     /* TOS = r */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0xf8); /* add -8 to esp */
+	raw_fp_stack_alloc(8);
 	emit_byte(0xdd);
 	emit_byte(0x1c);
 	emit_byte(0x24); /* fstp store r as DOUBLE to [esp] and pop */
 	emit_byte(0xdd);
 	emit_byte(0x04);
 	emit_byte(0x24); /* fld load r as DOUBLE from [esp] */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0x08); /* add +8 to esp */
+	raw_fp_stack_free(8);
 }
 LENDFUNC(NONE,NONE,1,raw_fcut_r,(FRW r))
 
 	LOWFUNC(NONE,READ,2,raw_fmovl_ri,(FW r, IMMS i))
 {
+#ifdef CPU_64_BIT
+	raw_fp_stack_alloc(4);
+	MOVLim(i, 0, ESP_INDEX, X86_NOREG, 1);
+#else
 	emit_byte(0x68);
 	emit_long(i);    /* push immediate32 onto [esp] */
+#endif
 	emit_byte(0xdb);
 	emit_byte(0x04);
 	emit_byte(0x24); /* fild load m32int from [esp] */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0x04); /* add +4 to esp */
+	raw_fp_stack_free(4);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,2,raw_fmovl_ri,(FW r, IMMS i))
 
 	LOWFUNC(NONE,READ,2,raw_fmovs_ri,(FW r, IMM i))
 {
+#ifdef CPU_64_BIT
+	raw_fp_stack_alloc(4);
+	MOVLim(i, 0, ESP_INDEX, X86_NOREG, 1);
+#else
 	emit_byte(0x68);
 	emit_long(i);    /* push immediate32 onto [esp] */
+#endif
 	emit_byte(0xd9);
 	emit_byte(0x04);
 	emit_byte(0x24); /* fld load m32real from [esp] */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0x04); /* add +4 to esp */
+	raw_fp_stack_free(4);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,2,raw_fmovs_ri,(FW r, IMM i))
 
 	LOWFUNC(NONE,READ,3,raw_fmov_ri,(FW r, IMM i1, IMM i2))
 {
+#ifdef CPU_64_BIT
+	raw_fp_stack_alloc(8);
+	MOVLim(i1, 0, ESP_INDEX, X86_NOREG, 1);
+	MOVLim(i2, 4, ESP_INDEX, X86_NOREG, 1);
+#else
 	emit_byte(0x68);
 	emit_long(i2);   /* push immediate32 onto [esp] */
 	emit_byte(0x68);
 	emit_long(i1);   /* push immediate32 onto [esp] */
+#endif
 	emit_byte(0xdd);
 	emit_byte(0x04);
 	emit_byte(0x24); /* fld load m64real from [esp] */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0x08); /* add +8 to esp */
+	raw_fp_stack_free(8);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,3,raw_fmov_ri,(FW r, IMM i1, IMM i2))
 
 	LOWFUNC(NONE,READ,4,raw_fmov_ext_ri,(FW r, IMM i1, IMM i2, IMM i3))
 {
+#ifdef CPU_64_BIT
+	raw_fp_stack_alloc(12);
+	MOVLim(i1, 0, ESP_INDEX, X86_NOREG, 1);
+	MOVLim(i2, 4, ESP_INDEX, X86_NOREG, 1);
+	MOVLim(i3, 8, ESP_INDEX, X86_NOREG, 1);
+#else
 	emit_byte(0x68);
 	emit_long(i3);   /* push immediate32 onto [esp] */
 	emit_byte(0x68);
 	emit_long(i2);   /* push immediate32 onto [esp] */
 	emit_byte(0x68);
 	emit_long(i1);   /* push immediate32 onto [esp] */
+#endif
 	emit_byte(0xdb);
 	emit_byte(0x2c);
 	emit_byte(0x24); /* fld load m80real from [esp] */
-	emit_byte(0x83);
-	emit_byte(0xc4);
-	emit_byte(0x0c); /* add +12 to esp */
+	raw_fp_stack_free(12);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,4,raw_fmov_ext_ri,(FW r, IMM i1, IMM i2, IMMi3))
@@ -2928,18 +4098,14 @@ LENDFUNC(NONE,READ,4,raw_fmov_ext_ri,(FW r, IMM i1, IMM i2, IMMi3))
 	emit_byte(0xd9);     /* Get a copy to the top of stack */
 	emit_byte(0xc0+rs);
 
-	emit_byte(0xdb);  /* store and pop it */
-	emit_byte(0x3d);
-	emit_long(m);
+	raw_fp_mem(0xdb,7,m); /* store and pop it */
 }
 LENDFUNC(NONE,WRITE,2,raw_fmov_ext_mr,(MEMW m, FR r))
 
 	LOWFUNC(NONE,WRITE,2,raw_fmov_ext_mr_drop,(MEMW m, FR r))
 {
 	make_tos(r);
-	emit_byte(0xdb);  /* store and pop it */
-	emit_byte(0x3d);
-	emit_long(m);
+	raw_fp_mem(0xdb,7,m); /* store and pop it */
 	live.onstack[live.tos]=-1;
 	live.tos--;
 	live.spos[r]=-2;
@@ -2948,9 +4114,7 @@ LENDFUNC(NONE,WRITE,2,raw_fmov_ext_mr,(MEMW m, FR r))
 
 	LOWFUNC(NONE,READ,2,raw_fmov_ext_rm,(FW r, MEMR m))
 {
-	emit_byte(0xdb);
-	emit_byte(0x2d);
-	emit_long(m);
+	raw_fp_mem(0xdb,5,m);
 	tos_make(r);
 }
 LENDFUNC(NONE,READ,2,raw_fmov_ext_rm,(FW r, MEMR m))
@@ -3022,13 +4186,18 @@ LENDFUNC(NONE,NONE,1,raw_fmov_0,(FW r))
 }
 LENDFUNC(NONE,NONE,2,raw_fmov_rr,(FW d, FR s))
 
-	LOWFUNC(NONE,READ,2,raw_fldcw_m_indexed,(R4 index, IMM base))
+	LOWFUNC(NONE,READ,2,raw_fldcw_m_indexed,(R4 index, MEMR base))
 {
+#ifdef CPU_64_BIT
+	int b = raw_abs(&base, 0);
+	_ESCmi(base, b, index, 1, 051); /* fldcw */
+#else
 	emit_byte(0xd9);
 	emit_byte(0xa8+index);
 	emit_long(base);
+#endif
 }
-LENDFUNC(NONE,READ,2,raw_fldcw_m_indexed,(R4 index, IMM base))
+LENDFUNC(NONE,READ,2,raw_fldcw_m_indexed,(R4 index, MEMR base))
 
 	LOWFUNC(NONE,NONE,2,raw_fsqrt_rr,(FW d, FR s))
 {
@@ -3285,9 +4454,7 @@ LENDFUNC(NONE,NONE,2,raw_fscale_rr,(FRW d, FR s))
 	emit_byte(0xe1);    /* fsub frac(x) = x - int(x) */
 	emit_byte(0xd9);
 	emit_byte(0xf0);    /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one); /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);    /* fscale (2^frac(x))*2^int(x) */
 	emit_byte(0xdd);
@@ -3321,9 +4488,7 @@ LENDFUNC(NONE,NONE,2,raw_ftwotox_rr,(FW d, FR s))
 	emit_byte(0xe1);    /* fsub x*log2(e) - int(x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);    /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);    /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xdd);
@@ -3392,9 +4557,7 @@ LENDFUNC(NONE,NONE,2,raw_fetoxM1_rr,(FW d, FR s))
 	emit_byte(0xe1);    /* fsub x*log2(10) - int(x*log2(10))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);    /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);    /* fscale (2^frac(x))*2^int(x*log2(10)) */
 	emit_byte(0xdd);
@@ -3539,9 +4702,7 @@ LOWFUNC(NONE,NONE,2,raw_facos_rr,(FW d, FR s))
 	emit_byte(0xc9);    /* fxch swap x with sqrt(1-(x^2))  */
 	emit_byte(0xd9);
 	emit_byte(0xf3);    /* fpatan atan(x/sqrt(1-(x^2))) & pop */
-	emit_byte(0xdb);
-	emit_byte(0x2d);
-	emit_long((uae_u32)&pihalf); /* fld load pi/2 from pihalf */
+	raw_fp_mem(0xdb,5,(uintptr)&pihalf); /* fld load pi/2 from pihalf */
 	emit_byte(0xde);
 	emit_byte(0xe1);    /* fsubrp pi/2 - asin(x) & pop */
 	tos_make(d);        /* store y=acos(x) */
@@ -3624,9 +4785,7 @@ LENDFUNC(NONE,NONE,2,raw_fatanh_rr,(FW d, FR s))
 	if (tr>=0) {
 		emit_byte(0xd9);
 		emit_byte(0xca); /* fxch swap with temp-reg */
-		emit_byte(0x83);
-		emit_byte(0xc4);
-		emit_byte(0xf4); /* add -12 to esp */
+		raw_fp_stack_alloc(12);
 		emit_byte(0xdb);
 		emit_byte(0x3c);
 		emit_byte(0x24); /* fstp store temp-reg to [esp] & pop */
@@ -3643,9 +4802,7 @@ LENDFUNC(NONE,NONE,2,raw_fatanh_rr,(FW d, FR s))
 	emit_byte(0xe1);     /* fsub -x*log2(e) - int(-x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);     /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);     /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xd9);
@@ -3660,9 +4817,7 @@ LENDFUNC(NONE,NONE,2,raw_fatanh_rr,(FW d, FR s))
 	emit_byte(0xe1);     /* fsub x*log2(e) - int(x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);     /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);     /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xdd);
@@ -3671,9 +4826,7 @@ LENDFUNC(NONE,NONE,2,raw_fatanh_rr,(FW d, FR s))
 		emit_byte(0xdb);
 		emit_byte(0x2c);
 		emit_byte(0x24); /* fld load temp-reg from [esp] */
-		emit_byte(0x83);
-		emit_byte(0xc4);
-		emit_byte(0x0c); /* add +12 to esp */
+		raw_fp_stack_free(12);
 		emit_byte(0xd9);
 		emit_byte(0xca); /* fxch swap temp-reg with e^-x in tr */
 		emit_byte(0xde);
@@ -3719,9 +4872,7 @@ LENDFUNC(NONE,NONE,2,raw_fsinh_rr,(FW d, FR s))
 	if (tr>=0) {
 		emit_byte(0xd9);
 		emit_byte(0xca); /* fxch swap with temp-reg */
-		emit_byte(0x83);
-		emit_byte(0xc4);
-		emit_byte(0xf4); /* add -12 to esp */
+		raw_fp_stack_alloc(12);
 		emit_byte(0xdb);
 		emit_byte(0x3c);
 		emit_byte(0x24); /* fstp store temp-reg to [esp] & pop */
@@ -3738,9 +4889,7 @@ LENDFUNC(NONE,NONE,2,raw_fsinh_rr,(FW d, FR s))
 	emit_byte(0xe1);     /* fsub -x*log2(e) - int(-x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);     /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);     /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xd9);
@@ -3755,9 +4904,7 @@ LENDFUNC(NONE,NONE,2,raw_fsinh_rr,(FW d, FR s))
 	emit_byte(0xe1);     /* fsub x*log2(e) - int(x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);     /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);     /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xdd);
@@ -3766,9 +4913,7 @@ LENDFUNC(NONE,NONE,2,raw_fsinh_rr,(FW d, FR s))
 		emit_byte(0xdb);
 		emit_byte(0x2c);
 		emit_byte(0x24); /* fld load temp-reg from [esp] */
-		emit_byte(0x83);
-		emit_byte(0xc4);
-		emit_byte(0x0c); /* add +12 to esp */
+		raw_fp_stack_free(12);
 		emit_byte(0xd9);
 		emit_byte(0xca); /* fxch swap temp-reg with e^-x in tr */
 	}
@@ -3810,9 +4955,7 @@ LENDFUNC(NONE,NONE,2,raw_fcosh_rr,(FW d, FR s))
 	if (tr>=0) {
 		emit_byte(0xd9);
 		emit_byte(0xca); /* fxch swap with temp-reg */
-		emit_byte(0x83);
-		emit_byte(0xc4);
-		emit_byte(0xf4); /* add -12 to esp */
+		raw_fp_stack_alloc(12);
 		emit_byte(0xdb);
 		emit_byte(0x3c);
 		emit_byte(0x24); /* fstp store temp-reg to [esp] & pop */
@@ -3829,9 +4972,7 @@ LENDFUNC(NONE,NONE,2,raw_fcosh_rr,(FW d, FR s))
 	emit_byte(0xe1);     /* fsub -x*log2(e) - int(-x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);     /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);     /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xd9);
@@ -3846,9 +4987,7 @@ LENDFUNC(NONE,NONE,2,raw_fcosh_rr,(FW d, FR s))
 	emit_byte(0xe1);     /* fsub x*log2(e) - int(x*log2(e))  */
 	emit_byte(0xd9);
 	emit_byte(0xf0);     /* f2xm1 (2^frac(x))-1 */
-	emit_byte(0xd8);
-	emit_byte(0x05);
-	emit_long((uae_u32)&one);  /* fadd (2^frac(x))-1 + 1 */
+	raw_fp_mem(0xd8,0,(uintptr)&one); /* fadd (2^frac(x))-1 + 1 */
 	emit_byte(0xd9);
 	emit_byte(0xfd);     /* fscale (2^frac(x))*2^int(x*log2(e)) */
 	emit_byte(0xdd);
@@ -3863,9 +5002,7 @@ LENDFUNC(NONE,NONE,2,raw_fcosh_rr,(FW d, FR s))
 		emit_byte(0xdb);
 		emit_byte(0x2c);
 		emit_byte(0x24); /* fld load temp-reg from [esp] */
-		emit_byte(0x83);
-		emit_byte(0xc4);
-		emit_byte(0x0c); /* add +12 to esp */
+		raw_fp_stack_free(12);
 		emit_byte(0xd9);
 		emit_byte(0xca); /* fxch swap temp-reg with e^-x in tr */
 		emit_byte(0xde);
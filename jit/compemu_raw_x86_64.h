@@ -0,0 +1,60 @@
+/* x86-64 helpers shared by compemu_raw_x86.cpp and test_codegen_x86.
+Expects codegen_x86.h, R11_INDEX/EAX_INDEX and lopt_emit_all() to be
+defined already. */
+
+/* Prepare an absolute address m for use as a memory operand. Returns
+the base register to use with it: X86_NOREG if m can be reached as
+it is (RIP-relative if rip is set, or as a sign-extended disp32),
+or %r11, loaded with m, with m set to 0. */
+STATIC_INLINE int raw_abs(uintptr *m, int rip)
+{
+	uae_s64 d = (uae_s64)(*m - (uintptr)get_target());
+
+	if (rip && d > -0x7ff00000LL && d < 0x7ff00000LL)
+		return X86_NOREG;
+	if (*m < 0x80000000)
+		return X86_NOREG;
+	MOVQir(*m, R11_INDEX);
+	*m = 0;
+	return R11_INDEX;
+}
+
+/* Can t be reached from the current target with a rel32? Leaves some
+slack for the instruction being emitted. */
+STATIC_INLINE int raw_rel32_ok(uintptr t)
+{
+	uae_s64 d = (uae_s64)(t - (uintptr)get_target());
+
+	return d > -0x7ff00000LL && d < 0x7ff00000LL;
+}
+
+/* jcc to a target out of rel32 range: j!cc over a jump through %r11 */
+STATIC_INLINE void raw_jcc_far(int cc, uintptr t)
+{
+	emit_byte(0x70+(cc^1));
+	emit_byte(13);
+	MOVQir(t, R11_INDEX);
+	JMPsr(R11_INDEX);
+}
+
+/* Call mem_banks[r>>16]->(handler at offset), the bank pointers being
+too wide to pass through the 32-bit register allocator */
+STATIC_INLINE void raw_call_bank(uintptr banks, uae_u32 r, uae_u32 offset)
+{
+	lopt_emit_all();
+	MOVLrr(r, EAX_INDEX);
+	SHRLir(16, EAX_INDEX);
+	MOVQir(banks, R11_INDEX);
+	MOVQmr(0, R11_INDEX, EAX_INDEX, 8, R11_INDEX);
+	CALLsm(offset, R11_INDEX, X86_NOREG, 1);
+}
+
+/* Store a 64-bit immediate to base[r], tmp is clobbered */
+STATIC_INLINE void raw_mov_q_mi_indexed(uintptr base, uae_u32 r, uintptr v, uae_u32 tmp)
+{
+	int b;
+
+	MOVQir(v, tmp);
+	b = raw_abs(&base, 0);
+	MOVQrm(tmp, base, b, r, 8);
+}
@@ -17,7 +17,7 @@
 #include "compemu.h"
 
 
-#define NATMEM_OFFSETX (uae_u32)NATMEM_OFFSET
+#define NATMEM_OFFSETX (uae_u32)(uintptr)NATMEM_OFFSET
 
 // %%% BRIAN KING WAS HERE %%%
 extern bool canbang;
@@ -33,16 +33,19 @@ uae_u8* comp_pc_p;
 uae_u8* start_pc_p;
 uae_u32 start_pc;
 uae_u32 current_block_pc_p;
-uae_u32 current_block_start_target;
+uintptr current_block_start_target;
 uae_u32 needed_flags;
 static uae_u32 next_pc_p;
 static uae_u32 taken_pc_p;
 static int     branch_cc;
+static uae_u32 call_pc_p;
 int segvcount=0;
 int soft_flush_count=0;
 int hard_flush_count=0;
 int compile_count=0;
 int checksum_count=0;
+int evict_count=0;
+int recompile_count=0;
 static uae_u8* current_compile_p=NULL;
 static uae_u8* max_compile_start;
 uae_u8* compiled_code=NULL;
@@ -51,6 +54,7 @@ static uae_s32 reg_alloc_run;
 static int		lazy_flush		= 1;	// Flag: lazy translation cache invalidation
 static int		avoid_fpu		= 1;	// Flag: compile FPU instructions ?
 static int		have_cmov		= 0;	// target has CMOV instructions ?
+static int		have_lahf_lm		= 1;	// target has LAHF supported in long mode ?
 static int		have_rat_stall		= 1;	// target has partial register stalls ?
 const int		tune_alignment		= 1;	// Tune code alignments for running CPU ?
 const int		tune_nop_fillers	= 1;	// Tune no-op fillers for architecture
@@ -249,6 +253,23 @@ STATIC_INLINE void add_to_dormant(blockinfo* bi)
 	bi->prev_p=&dormant;
 }
 
+/* Return address prediction. A block ending in JSR/BSR pushes the address
+it returns to along with a stub that chains to the block there, a block
+ending in RTS jumps to that stub if the prediction holds. The stubs live
+in block code, so they all go when any such code is thrown away. */
+#define RAS_SIZE 16
+
+static struct {
+	uae_u32 sp;
+	uintptr pc[RAS_SIZE]; /* Only the low 32 bits are compared */
+	void* stub[RAS_SIZE];
+} ras;
+
+STATIC_INLINE void ras_clear(void)
+{
+	memset(&ras,0,sizeof(ras));
+}
+
 STATIC_INLINE void remove_dep(dependency* d)
 {
 	if (d->prev_p)
@@ -265,11 +286,15 @@ STATIC_INLINE void remove_deps(blockinfo* bi)
 {
 	remove_dep(&(bi->dep[0]));
 	remove_dep(&(bi->dep[1]));
+	if (bi->haveretstub) {
+		ras_clear();
+		bi->haveretstub=0;
+	}
 }
 
 STATIC_INLINE void adjust_jmpdep(dependency* d, void* a)
 {
-	*(d->jmp_off)=(uae_u32)a-((uae_u32)d->jmp_off+4);
+	*(d->jmp_off)=(uintptr)a-((uintptr)d->jmp_off+4);
 }
 
 /********************************************************************
@@ -571,6 +596,12 @@ STATIC_INLINE void emit_long(uae_u32 x)
 	target+=4;
 }
 
+STATIC_INLINE void emit_quad(uae_u64 x)
+{
+	*((uae_u64*)target)=x;
+	target+=8;
+}
+
 STATIC_INLINE uae_u32 reverse32(uae_u32 oldv)
 {
 	return ((oldv>>24)&0xff) | ((oldv>>8)&0xff00) |
@@ -781,9 +812,9 @@ static  void tomem(int r)
 
 	if (live.state[r].status==DIRTY) {
 		switch (live.state[r].dirtysize) {
-		case 1: raw_mov_b_mr((uae_u32)live.state[r].mem,rr); break;
-		case 2: raw_mov_w_mr((uae_u32)live.state[r].mem,rr); break;
-		case 4: raw_mov_l_mr((uae_u32)live.state[r].mem,rr); break;
+		case 1: raw_mov_b_mr((uintptr)live.state[r].mem,rr); break;
+		case 2: raw_mov_w_mr((uintptr)live.state[r].mem,rr); break;
+		case 4: raw_mov_l_mr((uintptr)live.state[r].mem,rr); break;
 		default: abort();
 		}
 		set_status(r,CLEAN);
@@ -809,7 +840,7 @@ STATIC_INLINE void writeback_const(int r)
 		jit_abort (L"JIT: Trying to write back constant NF_HANDLER!\n");
 	}
 
-	raw_mov_l_mi((uae_u32)live.state[r].mem,live.state[r].val);
+	raw_mov_l_mi((uintptr)live.state[r].mem,live.state[r].val);
 	live.state[r].val=0;
 	set_status(r,INMEM);
 }
@@ -937,7 +968,7 @@ static  int alloc_reg_hinted(int r, int size, int willclobber, int hint)
 			jit_abort (L"live.nat[rr].nholds!=1");
 		if (size==4 && live.state[r].validsize==2) {
 			log_isused(bestreg);
-			raw_mov_l_rm(bestreg,(uae_u32)live.state[r].mem);
+			raw_mov_l_rm(bestreg,(uintptr)live.state[r].mem);
 			raw_bswap_32(bestreg);
 			raw_zero_extend_16_rr(rr,rr);
 			raw_zero_extend_16_rr(bestreg,bestreg);
@@ -968,7 +999,7 @@ static  int alloc_reg_hinted(int r, int size, int willclobber, int hint)
 				else if (r==FLAGX)
 					raw_load_flagx(bestreg,r);
 				else {
-					raw_mov_l_rm(bestreg,(uae_u32)live.state[r].mem);
+					raw_mov_l_rm(bestreg,(uintptr)live.state[r].mem);
 				}
 				live.state[r].dirtysize=0;
 				set_status(r,CLEAN);
@@ -1419,9 +1450,9 @@ static  void f_tomem(int r)
 {
 	if (live.fate[r].status==DIRTY) {
 #if USE_LONG_DOUBLE
-		raw_fmov_ext_mr((uae_u32)live.fate[r].mem,live.fate[r].realreg);
+		raw_fmov_ext_mr((uintptr)live.fate[r].mem,live.fate[r].realreg);
 #else
-		raw_fmov_mr((uae_u32)live.fate[r].mem,live.fate[r].realreg);
+		raw_fmov_mr((uintptr)live.fate[r].mem,live.fate[r].realreg);
 #endif
 		live.fate[r].status=CLEAN;
 	}
@@ -1431,9 +1462,9 @@ static  void f_tomem_drop(int r)
 {
 	if (live.fate[r].status==DIRTY) {
 #if USE_LONG_DOUBLE
-		raw_fmov_ext_mr_drop((uae_u32)live.fate[r].mem,live.fate[r].realreg);
+		raw_fmov_ext_mr_drop((uintptr)live.fate[r].mem,live.fate[r].realreg);
 #else
-		raw_fmov_mr_drop((uae_u32)live.fate[r].mem,live.fate[r].realreg);
+		raw_fmov_mr_drop((uintptr)live.fate[r].mem,live.fate[r].realreg);
 #endif
 		live.fate[r].status=INMEM;
 	}
@@ -1539,9 +1570,9 @@ static  int f_alloc_reg(int r, int willclobber)
 	if (!willclobber) {
 		if (live.fate[r].status!=UNDEF) {
 #if USE_LONG_DOUBLE
-			raw_fmov_ext_rm(bestreg,(uae_u32)live.fate[r].mem);
+			raw_fmov_ext_rm(bestreg,(uintptr)live.fate[r].mem);
 #else
-			raw_fmov_rm(bestreg,(uae_u32)live.fate[r].mem);
+			raw_fmov_rm(bestreg,(uintptr)live.fate[r].mem);
 #endif
 		}
 		live.fate[r].status=CLEAN;
@@ -1745,7 +1776,7 @@ MENDFUNC(0,dont_care_flags,(void))
 {
 	evict(FLAGX);
 	make_flags_live_internal();
-	COMPCALL(setcc_m)((uae_u32)live.state[FLAGX].mem + 1,2);
+	COMPCALL(setcc_m)((uintptr)live.state[FLAGX].mem + 1,2);
 }
 MENDFUNC(0,duplicate_carry,(void))
 
@@ -1767,7 +1798,7 @@ MENDFUNC(0,duplicate_carry,(void))
 		COMPCALL(rol_w_ri(FLAGX, 8));
 		isclean(FLAGX);
 		/* Why is the above faster than the below? */
-		//raw_rol_b_mi((uae_u32)live.state[FLAGX].mem,8);
+		//raw_rol_b_mi((uintptr)live.state[FLAGX].mem,8);
 	}
 }
 MENDFUNC(0,restore_carry,(void))
@@ -1892,14 +1923,14 @@ MENDFUNC(2,bts_l_ri,(RW4 r, IMM i))
 }
 MENDFUNC(2,bts_l_rr,(RW4 r, R4 b))
 
-	MIDFUNC(2,mov_l_rm,(W4 d, IMM s))
+	MIDFUNC(2,mov_l_rm,(W4 d, MEMR s))
 {
 	CLOBBER_MOV;
 	d=writereg(d,4);
 	raw_mov_l_rm(d,s);
 	unlock(d);
 }
-MENDFUNC(2,mov_l_rm,(W4 d, IMM s))
+MENDFUNC(2,mov_l_rm,(W4 d, MEMR s))
 
 
 	MIDFUNC(1,call_r,(R4 r)) /* Clobbering is implicit */
@@ -1910,33 +1941,33 @@ MENDFUNC(2,mov_l_rm,(W4 d, IMM s))
 }
 MENDFUNC(1,call_r,(R4 r)) /* Clobbering is implicit */
 
-	MIDFUNC(2,sub_l_mi,(IMM d, IMM s))
+	MIDFUNC(2,sub_l_mi,(MEMRW d, IMM s))
 {
 	CLOBBER_SUB;
 	raw_sub_l_mi(d,s) ;
 }
-MENDFUNC(2,sub_l_mi,(IMM d, IMM s))
+MENDFUNC(2,sub_l_mi,(MEMRW d, IMM s))
 
-	MIDFUNC(2,mov_l_mi,(IMM d, IMM s))
+	MIDFUNC(2,mov_l_mi,(MEMW d, IMM s))
 {
 	CLOBBER_MOV;
 	raw_mov_l_mi(d,s) ;
 }
-MENDFUNC(2,mov_l_mi,(IMM d, IMM s))
+MENDFUNC(2,mov_l_mi,(MEMW d, IMM s))
 
-	MIDFUNC(2,mov_w_mi,(IMM d, IMM s))
+	MIDFUNC(2,mov_w_mi,(MEMW d, IMM s))
 {
 	CLOBBER_MOV;
 	raw_mov_w_mi(d,s) ;
 }
-MENDFUNC(2,mov_w_mi,(IMM d, IMM s))
+MENDFUNC(2,mov_w_mi,(MEMW d, IMM s))
 
-	MIDFUNC(2,mov_b_mi,(IMM d, IMM s))
+	MIDFUNC(2,mov_b_mi,(MEMW d, IMM s))
 {
 	CLOBBER_MOV;
 	raw_mov_b_mi(d,s) ;
 }
-MENDFUNC(2,mov_b_mi,(IMM d, IMM s))
+MENDFUNC(2,mov_b_mi,(MEMW d, IMM s))
 
 	MIDFUNC(2,rol_b_ri,(RW1 r, IMM i))
 {
@@ -2396,12 +2427,12 @@ MENDFUNC(2,shra_b_rr,(RW1 d, R1 r))
 }
 MENDFUNC(2,setcc,(W1 d, IMM cc))
 
-	MIDFUNC(2,setcc_m,(IMM d, IMM cc))
+	MIDFUNC(2,setcc_m,(MEMW d, IMM cc))
 {
 	CLOBBER_SETCC;
 	raw_setcc_m(d,cc);
 }
-MENDFUNC(2,setcc_m,(IMM d, IMM cc))
+MENDFUNC(2,setcc_m,(MEMW d, IMM cc))
 
 	MIDFUNC(3,cmov_b_rr,(RW1 d, R1 s, IMM cc))
 {
@@ -2468,14 +2499,14 @@ MENDFUNC(3,cmov_l_rr,(RW4 d, R4 s, IMM cc))
 }
 MENDFUNC(1,setzflg_l,(RW4 r))
 
-	MIDFUNC(3,cmov_l_rm,(RW4 d, IMM s, IMM cc))
+	MIDFUNC(3,cmov_l_rm,(RW4 d, MEMR s, IMM cc))
 {
 	CLOBBER_CMOV;
 	d=rmw(d,4,4);
 	raw_cmov_l_rm(d,s,cc);
 	unlock(d);
 }
-MENDFUNC(3,cmov_l_rm,(RW4 d, IMM s, IMM cc))
+MENDFUNC(3,cmov_l_rm,(RW4 d, MEMR s, IMM cc))
 
 	MIDFUNC(2,bsf_l_rr,(W4 d, R4 s))
 {
@@ -2769,25 +2800,25 @@ MENDFUNC(3,mov_w_mrr_indexed,(R4 baser, R4 index, R2 s))
 MENDFUNC(3,mov_b_mrr_indexed,(R4 baser, R4 index, R1 s))
 
 	/* Read a long from base+4*index */
-	MIDFUNC(3,mov_l_rm_indexed,(W4 d, IMM base, R4 index))
+	MIDFUNC(3,mov_l_rm_indexed,(W4 d, MEMR base, R4 index))
 {
 	int indexreg=index;
 
 	if (isconst(index)) {
-		COMPCALL(mov_l_rm)(d,base+4*live.state[index].val);
+		COMPCALL(mov_l_rm)(d,base+sizeof(void*)*live.state[index].val);
 		return;
 	}
 
 	CLOBBER_MOV;
 	index=readreg_offset(index,4);
-	base+=get_offset(indexreg)*4;
+	base+=get_offset(indexreg)*sizeof(void*);
 	d=writereg(d,4);
 
 	raw_mov_l_rm_indexed(d,base,index);
 	unlock(index);
 	unlock(d);
 }
-MENDFUNC(3,mov_l_rm_indexed,(W4 d, IMM base, R4 index))
+MENDFUNC(3,mov_l_rm_indexed,(W4 d, MEMR base, R4 index))
 
 	/* read the long at the address contained in s+offset and store in d */
 	MIDFUNC(3,mov_l_rR,(W4 d, R4 s, IMM offset))
@@ -3179,7 +3210,7 @@ MENDFUNC(1,gen_bswap_16,(RW2 r))
 }
 MENDFUNC(2,mov_l_rr,(W4 d, R4 s))
 
-	MIDFUNC(2,mov_l_mr,(IMM d, R4 s))
+	MIDFUNC(2,mov_l_mr,(MEMW d, R4 s))
 {
 	if (isconst(s)) {
 		COMPCALL(mov_l_mi)(d,live.state[s].val);
@@ -3191,10 +3222,10 @@ MENDFUNC(2,mov_l_rr,(W4 d, R4 s))
 	raw_mov_l_mr(d,s);
 	unlock(s);
 }
-MENDFUNC(2,mov_l_mr,(IMM d, R4 s))
+MENDFUNC(2,mov_l_mr,(MEMW d, R4 s))
 
 
-	MIDFUNC(2,mov_w_mr,(IMM d, R2 s))
+	MIDFUNC(2,mov_w_mr,(MEMW d, R2 s))
 {
 	if (isconst(s)) {
 		COMPCALL(mov_w_mi)(d,(uae_u16)live.state[s].val);
@@ -3206,9 +3237,9 @@ MENDFUNC(2,mov_l_mr,(IMM d, R4 s))
 	raw_mov_w_mr(d,s);
 	unlock(s);
 }
-MENDFUNC(2,mov_w_mr,(IMM d, R2 s))
+MENDFUNC(2,mov_w_mr,(MEMW d, R2 s))
 
-	MIDFUNC(2,mov_w_rm,(W2 d, IMM s))
+	MIDFUNC(2,mov_w_rm,(W2 d, MEMR s))
 {
 	CLOBBER_MOV;
 	d=writereg(d,2);
@@ -3216,9 +3247,9 @@ MENDFUNC(2,mov_w_mr,(IMM d, R2 s))
 	raw_mov_w_rm(d,s);
 	unlock(d);
 }
-MENDFUNC(2,mov_w_rm,(W2 d, IMM s))
+MENDFUNC(2,mov_w_rm,(W2 d, MEMR s))
 
-	MIDFUNC(2,mov_b_mr,(IMM d, R1 s))
+	MIDFUNC(2,mov_b_mr,(MEMW d, R1 s))
 {
 	if (isconst(s)) {
 		COMPCALL(mov_b_mi)(d,(uae_u8)live.state[s].val);
@@ -3231,9 +3262,9 @@ MENDFUNC(2,mov_w_rm,(W2 d, IMM s))
 	raw_mov_b_mr(d,s);
 	unlock(s);
 }
-MENDFUNC(2,mov_b_mr,(IMM d, R1 s))
+MENDFUNC(2,mov_b_mr,(MEMW d, R1 s))
 
-	MIDFUNC(2,mov_b_rm,(W1 d, IMM s))
+	MIDFUNC(2,mov_b_rm,(W1 d, MEMR s))
 {
 	CLOBBER_MOV;
 	d=writereg(d,1);
@@ -3241,7 +3272,7 @@ MENDFUNC(2,mov_b_mr,(IMM d, R1 s))
 	raw_mov_b_rm(d,s);
 	unlock(d);
 }
-MENDFUNC(2,mov_b_rm,(W1 d, IMM s))
+MENDFUNC(2,mov_b_rm,(W1 d, MEMR s))
 
 	MIDFUNC(2,mov_l_ri,(W4 d, IMM s))
 {
@@ -3271,26 +3302,26 @@ MENDFUNC(2,mov_w_ri,(W2 d, IMM s))
 MENDFUNC(2,mov_b_ri,(W1 d, IMM s))
 
 
-	MIDFUNC(2,add_l_mi,(IMM d, IMM s))
+	MIDFUNC(2,add_l_mi,(MEMRW d, IMM s))
 {
 	CLOBBER_ADD;
 	raw_add_l_mi(d,s) ;
 }
-MENDFUNC(2,add_l_mi,(IMM d, IMM s))
+MENDFUNC(2,add_l_mi,(MEMRW d, IMM s))
 
-	MIDFUNC(2,add_w_mi,(IMM d, IMM s))
+	MIDFUNC(2,add_w_mi,(MEMRW d, IMM s))
 {
 	CLOBBER_ADD;
 	raw_add_w_mi(d,s) ;
 }
-MENDFUNC(2,add_w_mi,(IMM d, IMM s))
+MENDFUNC(2,add_w_mi,(MEMRW d, IMM s))
 
-	MIDFUNC(2,add_b_mi,(IMM d, IMM s))
+	MIDFUNC(2,add_b_mi,(MEMRW d, IMM s))
 {
 	CLOBBER_ADD;
 	raw_add_b_mi(d,s) ;
 }
-MENDFUNC(2,add_b_mi,(IMM d, IMM s))
+MENDFUNC(2,add_b_mi,(MEMRW d, IMM s))
 
 
 	MIDFUNC(2,test_l_ri,(R4 d, IMM i))
@@ -3871,6 +3902,56 @@ MENDFUNC(5,call_r_11,(W4 out1, R4 r, R4 in1, IMM osize, IMM isize))
 }
 MENDFUNC(5,call_r_02,(R4 r, R4 in1, R4 in2, IMM isize1, IMM isize2))
 
+#ifdef CPU_64_BIT
+/* Like call_r_11/call_r_02, but the handler is fetched straight from
+mem_banks[in1>>16] at the call, as the bank pointer is 64 bits wide */
+	MIDFUNC(4,call_bank_r_11,(W4 out1, R4 in1, IMM offset, IMM osize))
+{
+	clobber_flags();
+	remove_all_offsets();
+	if (osize==4) {
+		if (out1!=in1) {
+			COMPCALL(forget_about)(out1);
+		}
+	}
+	else {
+		tomem_c(out1);
+	}
+
+	in1=readreg_specific(in1,4,REG_PAR1);
+	prepare_for_call_1();
+	unlock(in1);
+	prepare_for_call_2();
+	raw_call_bank((uintptr)mem_banks,in1,offset);
+
+	live.nat[REG_RESULT].holds[0]=out1;
+	live.nat[REG_RESULT].nholds=1;
+	live.nat[REG_RESULT].touched=touchcnt++;
+
+	live.state[out1].realreg=REG_RESULT;
+	live.state[out1].realind=0;
+	live.state[out1].val=0;
+	live.state[out1].validsize=osize;
+	live.state[out1].dirtysize=osize;
+	set_status(out1,DIRTY);
+}
+MENDFUNC(4,call_bank_r_11,(W4 out1, R4 in1, IMM offset, IMM osize))
+
+	MIDFUNC(4,call_bank_r_02,(R4 in1, R4 in2, IMM offset, IMM isize2))
+{
+	clobber_flags();
+	remove_all_offsets();
+	in1=readreg_specific(in1,4,REG_PAR1);
+	in2=readreg_specific(in2,isize2,REG_PAR2);
+	prepare_for_call_1();
+	unlock(in1);
+	unlock(in2);
+	prepare_for_call_2();
+	raw_call_bank((uintptr)mem_banks,in1,offset);
+}
+MENDFUNC(4,call_bank_r_02,(R4 in1, R4 in2, IMM offset, IMM isize2))
+#endif
+
 	MIDFUNC(1,forget_about,(W4 r))
 {
 	if (isinreg(r))
@@ -4078,14 +4159,14 @@ MENDFUNC(2,fmov_ext_rm,(FW r, MEMR m))
 }
 MENDFUNC(2,fmov_rr,(FW d, FR s))
 
-	MIDFUNC(2,fldcw_m_indexed,(R4 index, IMM base))
+	MIDFUNC(2,fldcw_m_indexed,(R4 index, MEMR base))
 {
 	index=readreg(index,4);
 
 	raw_fldcw_m_indexed(index,base);
 	unlock(index);
 }
-MENDFUNC(2,fldcw_m_indexed,(R4 index, IMM base))
+MENDFUNC(2,fldcw_m_indexed,(R4 index, MEMR base))
 
 	MIDFUNC(1,ftst_r,(FR r))
 {
@@ -4704,7 +4785,7 @@ STATIC_INLINE void match_states(smallstate* s)
 					write_log (L"JIT: natreg %d holds %d vregs, should be empty\n",
 						n,live.nat[n].nholds);
 				}
-				raw_mov_l_rm(n,(uae_u32)live.state[i].mem);
+				raw_mov_l_rm(n,(uintptr)live.state[i].mem);
 				live.state[i].validsize=4;
 				live.state[i].dirtysize=0;
 				live.state[i].realreg=n;
@@ -4789,7 +4870,7 @@ void flush(int save_regs)
 				switch(live.state[i].status) {
 				case INMEM:
 					if (live.state[i].val) {
-						raw_add_l_mi((uae_u32)live.state[i].mem,live.state[i].val);
+						raw_add_l_mi((uintptr)live.state[i].mem,live.state[i].val);
 						live.state[i].val=0;
 					}
 					break;
@@ -4953,7 +5034,12 @@ void register_branch(uae_u32 not_taken, uae_u32 taken, uae_u8 cond)
 	branch_cc=cond;
 }
 
-static uae_u32 get_handler_address(uae_u32 addr)
+void register_call(uae_u32 ret)
+{
+	call_pc_p=ret;
+}
+
+static uintptr get_handler_address(uae_u32 addr)
 {
 	uae_u32 cl=cacheline(addr);
 	blockinfo* bi=get_blockinfo_addr_new((void*)addr,0);
@@ -4962,10 +5048,10 @@ static uae_u32 get_handler_address(uae_u32 addr)
 	if (!bi && reg_alloc_run)
 		return 0;
 #endif
-	return (uae_u32)&(bi->direct_handler_to_use);
+	return (uintptr)&(bi->direct_handler_to_use);
 }
 
-static uae_u32 get_handler(uae_u32 addr)
+static uintptr get_handler(uae_u32 addr)
 {
 	uae_u32 cl=cacheline(addr);
 	blockinfo* bi=get_blockinfo_addr_new((void*)addr,0);
@@ -4974,7 +5060,63 @@ static uae_u32 get_handler(uae_u32 addr)
 	if (!bi && reg_alloc_run)
 		return 0;
 #endif
-	return (uae_u32)bi->direct_handler_to_use;
+	return (uintptr)bi->direct_handler_to_use;
+}
+
+/* Block exit after a call to ret. Emits the return stub (skipped over here)
+and pushes it. r holds the exit address and must survive, or is -1. */
+static void ras_push(blockinfo* bi, uae_u32 ret, int r)
+{
+	int r2=(r==0)?1:0;
+	int r3=(r==2)?1:2;
+	uae_u32* jmpadd;
+	uae_u32* tba;
+	uae_u8* stub;
+
+	raw_jmp_l_oponly();
+	jmpadd=(uae_u32*)get_target();
+	emit_long(0);
+
+	/* Entered from ras_pop with the flags of its countdown update */
+	stub=get_target();
+	get_blockinfo_addr_new((void*)ret,1);
+	raw_jcc_l_oponly(9);
+	tba=(uae_u32*)get_target();
+	emit_long(get_handler(ret)-((uintptr)tba+4));
+	raw_mov_l_mi((uintptr)&regs.pc_p,ret);
+	raw_jmp((uintptr)popall_do_nothing);
+	create_jmpdep(bi,1,tba,ret);
+	*jmpadd=(uintptr)get_target()-((uintptr)jmpadd+4);
+
+	raw_mov_l_rm(r2,(uintptr)&ras.sp);
+	raw_add_l_ri(r2,1);
+	raw_and_l_ri(r2,RAS_SIZE-1);
+	raw_mov_l_mr((uintptr)&ras.sp,r2);
+	raw_mov_p_mi_indexed((uintptr)ras.pc,r2,ret,r3);
+	raw_mov_p_mi_indexed((uintptr)ras.stub,r2,(uintptr)stub,r3);
+	bi->haveretstub=1;
+}
+
+/* Block exit after RTS to the address in r. Takes the top stub if it
+was pushed for that address, else falls through. */
+static void ras_pop(int r, uae_u32 cycles)
+{
+	int r2=(r==0)?1:0;
+	int r3=(r==2)?1:2;
+	uae_s8* branchadd;
+
+	raw_mov_l_rm(r2,(uintptr)&ras.sp);
+	raw_mov_l_rm_indexed(r3,(uintptr)ras.pc,r2);
+	raw_cmp_l(r3,r);
+	raw_jnz_b_oponly();
+	branchadd=(uae_s8*)get_target();
+	emit_byte(0);
+	raw_lea_l_brr(r3,r2,-1);
+	raw_and_l_ri(r3,RAS_SIZE-1);
+	raw_mov_l_mr((uintptr)&ras.sp,r3);
+	raw_sub_l_mi((uintptr)&countdown,cycles);
+	raw_jmp_m_indexed((uintptr)ras.stub,r2,sizeof(void*));
+	*branchadd=(uintptr)get_target()-((uintptr)branchadd+1);
 }
 
 static void load_handler(int reg, uae_u32 addr)
@@ -5007,7 +5149,7 @@ static void writemem_real(int address, int source, int offset, int size, int tmp
 
 	mov_l_rr(f,address);
 	shrl_l_ri(f,16);  /* The index into the baseaddr table */
-	mov_l_rm_indexed(f,(uae_u32)(baseaddr),f);
+	mov_l_rm_indexed(f,(uintptr)(baseaddr),f);
 
 	if (address==source) { /* IBrowse does this! */
 		if (size > 1) {
@@ -5031,15 +5173,20 @@ static void writemem_real(int address, int source, int offset, int size, int tmp
 
 STATIC_INLINE void writemem(int address, int source, int offset, int size, int tmp)
 {
+#ifdef CPU_64_BIT
+	/* Bank pointers don't fit in a 32-bit register */
+	call_bank_r_02(address,source,offset,size);
+#else
 	int f=tmp;
 
 	mov_l_rr(f,address);
 	shrl_l_ri(f,16);   /* The index into the mem bank table */
-	mov_l_rm_indexed(f,(uae_u32)mem_banks,f);
+	mov_l_rm_indexed(f,(uintptr)mem_banks,f);
 	/* Now f holds a pointer to the actual membank */
 	mov_l_rR(f,f,offset);
 	/* Now f holds the address of the b/w/lput function */
 	call_r_02(f,address,source,4,size);
+#endif
 	forget_about(tmp);
 }
 
@@ -5055,7 +5202,7 @@ void writebyte(int address, int source, int tmp)
 	}
 
 	if ((special_mem&S_WRITE) || distrust)
-		writemem_special(address,source,20,1,tmp);
+		writemem_special(address,source,offsetof(addrbank,bput),1,tmp);
 	else
 		writemem_real(address,source,20,1,tmp,0);
 }
@@ -5073,7 +5220,7 @@ STATIC_INLINE void writeword_general(int address, int source, int tmp,
 	}
 
 	if ((special_mem&S_WRITE) || distrust)
-		writemem_special(address,source,16,2,tmp);
+		writemem_special(address,source,offsetof(addrbank,wput),2,tmp);
 	else
 		writemem_real(address,source,16,2,tmp,clobber);
 }
@@ -5101,7 +5248,7 @@ STATIC_INLINE void writelong_general(int address, int source, int tmp,
 	}
 
 	if ((special_mem&S_WRITE) || distrust)
-		writemem_special(address,source,12,4,tmp);
+		writemem_special(address,source,offsetof(addrbank,lput),4,tmp);
 	else
 		writemem_real(address,source,12,4,tmp,clobber);
 }
@@ -5143,7 +5290,7 @@ static void readmem_real(int address, int dest, int offset, int size, int tmp)
 
 	mov_l_rr(f,address);
 	shrl_l_ri(f,16);   /* The index into the baseaddr table */
-	mov_l_rm_indexed(f,(uae_u32)baseaddr,f);
+	mov_l_rm_indexed(f,(uintptr)baseaddr,f);
 	/* f now holds the offset */
 
 	switch(size) {
@@ -5158,15 +5305,20 @@ static void readmem_real(int address, int dest, int offset, int size, int tmp)
 
 STATIC_INLINE void readmem(int address, int dest, int offset, int size, int tmp)
 {
+#ifdef CPU_64_BIT
+	/* Bank pointers don't fit in a 32-bit register */
+	call_bank_r_11(dest,address,offset,size);
+#else
 	int f=tmp;
 
 	mov_l_rr(f,address);
 	shrl_l_ri(f,16);   /* The index into the mem bank table */
-	mov_l_rm_indexed(f,(uae_u32)mem_banks,f);
+	mov_l_rm_indexed(f,(uintptr)mem_banks,f);
 	/* Now f holds a pointer to the actual membank */
 	mov_l_rR(f,f,offset);
 	/* Now f holds the address of the b/w/lget function */
 	call_r_11(dest,f,address,size,4);
+#endif
 	forget_about(tmp);
 }
 
@@ -5182,7 +5334,7 @@ void readbyte(int address, int dest, int tmp)
 	}
 
 	if ((special_mem&S_READ) || distrust)
-		readmem_special(address,dest,8,1,tmp);
+		readmem_special(address,dest,offsetof(addrbank,bget),1,tmp);
 	else
 		readmem_real(address,dest,8,1,tmp);
 }
@@ -5199,7 +5351,7 @@ void readword(int address, int dest, int tmp)
 	}
 
 	if ((special_mem&S_READ) || distrust)
-		readmem_special(address,dest,4,2,tmp);
+		readmem_special(address,dest,offsetof(addrbank,wget),2,tmp);
 	else
 		readmem_real(address,dest,4,2,tmp);
 }
@@ -5216,7 +5368,7 @@ void readlong(int address, int dest, int tmp)
 	}
 
 	if ((special_mem&S_READ) || distrust)
-		readmem_special(address,dest,0,4,tmp);
+		readmem_special(address,dest,offsetof(addrbank,lget),4,tmp);
 	else
 		readmem_real(address,dest,0,4,tmp);
 }
@@ -5226,7 +5378,7 @@ void readlong(int address, int dest, int tmp)
 /* This one might appear a bit odd... */
 STATIC_INLINE void get_n_addr_old(int address, int dest, int tmp)
 {
-	readmem(address,dest,24,4,tmp);
+	readmem(address,dest,offsetof(addrbank,xlateaddr),4,tmp);
 }
 
 STATIC_INLINE void get_n_addr_real(int address, int dest, int tmp)
@@ -5245,7 +5397,7 @@ STATIC_INLINE void get_n_addr_real(int address, int dest, int tmp)
 	mov_l_rr(f,address);
 	mov_l_rr(dest,address); // gb-- nop if dest==address
 	shrl_l_ri(f,16);
-	mov_l_rm_indexed(f,(uae_u32)baseaddr,f);
+	mov_l_rm_indexed(f,(uintptr)baseaddr,f);
 	add_l(dest,f);
 	forget_about(tmp);
 }
@@ -5278,7 +5430,7 @@ would --- otherwise we end up translating everything twice */
 		f=dest;
 	mov_l_rr(f,address);
 	shrl_l_ri(f,16);   /* The index into the baseaddr bank table */
-	mov_l_rm_indexed(dest,(uae_u32)baseaddr,f);
+	mov_l_rm_indexed(dest,(uintptr)baseaddr,f);
 	add_l(dest,address);
 	and_l_ri (dest, ~1);
 	forget_about(tmp);
@@ -5369,11 +5521,50 @@ int get_cache_state(void)
 	return letit;
 }
 
+/* The translation cache is split into segments which are filled in
+turn. Once the last one is full, only the oldest segment is thrown away
+and reused, so the blocks compiled since then stay where they are. */
+#define CACHE_SEGMENTS 4
+#define MIN_SEGMENT_SIZE (16*BYTES_PER_INST)
+
+static int cache_segments;
+static int cur_segment;
+static uae_u32 segment_size;
+static uae_u32 segment_used[CACHE_SEGMENTS];
+
+/* One bit per (even) cacheline whose block was evicted, so compiling
+it again can be counted as a recompile. Collisions make it approximate. */
+static uae_u32 evicted_cl[TAGSIZE/64];
+
+STATIC_INLINE void set_cache_segment(int n)
+{
+	cur_segment=n;
+	current_compile_p=compiled_code+n*segment_size;
+	max_compile_start=current_compile_p+segment_size-BYTES_PER_INST;
+}
+
 uae_u32 get_jitted_size(void)
 {
-	if (compiled_code)
-		return current_compile_p-compiled_code;
-	return 0;
+	uae_u32 size=0;
+	int i;
+
+	if (!compiled_code)
+		return 0;
+	for (i=0;i<cache_segments;i++) {
+		if (i!=cur_segment)
+			size+=segment_used[i];
+	}
+	return size+(current_compile_p-(compiled_code+cur_segment*segment_size));
+}
+
+uae_u32 get_jit_evict_count(void)
+{
+	return evict_count;
+}
+
+uae_u32 get_jit_recompile_count(void)
+{
+	return recompile_count;
 }
 
 void alloc_cache(void)
@@ -5396,8 +5587,12 @@ void alloc_cache(void)
 			currprefs.cachesize/=2;
 	}
 	if (compiled_code) {
-		max_compile_start=compiled_code+currprefs.cachesize*1024-BYTES_PER_INST;
-		current_compile_p=compiled_code;
+		cache_segments=CACHE_SEGMENTS;
+		while (cache_segments>1 && currprefs.cachesize*1024/cache_segments<MIN_SEGMENT_SIZE)
+			cache_segments/=2;
+		segment_size=(currprefs.cachesize*1024/cache_segments)&~31;
+		memset(segment_used,0,sizeof(segment_used));
+		set_cache_segment(0);
 	}
 }
 
@@ -5553,63 +5748,69 @@ static void check_checksum(void)
 }
 
 
+static int popall_stack_space=0;
+
+STATIC_INLINE void raw_pop_preserved_regs(void)
+{
+	int i;
+
+	if (popall_stack_space)
+		raw_inc_sp(popall_stack_space);
+	for (i=0;i<N_REGS;i++) {
+		if (need_to_preserve[i])
+			raw_pop_l_r(i);
+	}
+}
+
 STATIC_INLINE void create_popalls(void)
 {
 	int i,r;
+	int npushed=0;
 
 	current_compile_p=popallspace;
 	set_target(current_compile_p);
 #if USE_PUSH_POP
+#ifdef CPU_64_BIT
+	/* Win64 wants %rsp 16-byte aligned at every call, and 32 bytes of
+	home space for the callee to spill its register arguments into */
+	for (i=0;i<N_REGS;i++) {
+		if (need_to_preserve[i])
+			npushed++;
+	}
+	popall_stack_space=32+((npushed&1)?0:8);
+#endif
 	/* If we can't use gcc inline assembly, we need to pop some
 	registers before jumping back to the various get-out routines.
 	This generates the code for it.
 	*/
 	popall_do_nothing=current_compile_p;
-	for (i=0;i<N_REGS;i++) {
-		if (need_to_preserve[i])
-			raw_pop_l_r(i);
-	}
-	raw_jmp((uae_u32)do_nothing);
+	raw_pop_preserved_regs();
+	raw_jmp((uintptr)do_nothing);
 	align_target(32);
 
 	popall_execute_normal=get_target();
-	for (i=0;i<N_REGS;i++) {
-		if (need_to_preserve[i])
-			raw_pop_l_r(i);
-	}
-	raw_jmp((uae_u32)execute_normal);
+	raw_pop_preserved_regs();
+	raw_jmp((uintptr)execute_normal);
 	align_target(32);
 
 	popall_cache_miss=get_target();
-	for (i=0;i<N_REGS;i++) {
-		if (need_to_preserve[i])
-			raw_pop_l_r(i);
-	}
-	raw_jmp((uae_u32)cache_miss);
+	raw_pop_preserved_regs();
+	raw_jmp((uintptr)cache_miss);
 	align_target(32);
 
 	popall_recompile_block=get_target();
-	for (i=0;i<N_REGS;i++) {
-		if (need_to_preserve[i])
-			raw_pop_l_r(i);
-	}
-	raw_jmp((uae_u32)recompile_block);
+	raw_pop_preserved_regs();
+	raw_jmp((uintptr)recompile_block);
 	align_target(32);
 
 	popall_exec_nostats=get_target();
-	for (i=0;i<N_REGS;i++) {
-		if (need_to_preserve[i])
-			raw_pop_l_r(i);
-	}
-	raw_jmp((uae_u32)exec_nostats);
+	raw_pop_preserved_regs();
+	raw_jmp((uintptr)exec_nostats);
 	align_target(32);
 
 	popall_check_checksum=get_target();
-	for (i=0;i<N_REGS;i++) {
-		if (need_to_preserve[i])
-			raw_pop_l_r(i);
-	}
-	raw_jmp((uae_u32)check_checksum);
+	raw_pop_preserved_regs();
+	raw_jmp((uintptr)check_checksum);
 	align_target(32);
 
 	current_compile_p=get_target();
@@ -5630,11 +5831,13 @@ STATIC_INLINE void create_popalls(void)
 		if (need_to_preserve[i])
 			raw_push_l_r(i);
 	}
+	if (popall_stack_space)
+		raw_dec_sp(popall_stack_space);
 #endif
 	r=REG_PC_TMP;
-	raw_mov_l_rm(r,(uae_u32)&regs.pc_p);
+	raw_mov_l_rm(r,(uintptr)&regs.pc_p);
 	raw_and_l_ri(r,TAGMASK);
-	raw_jmp_m_indexed((uae_u32)cache_tags,r,4);
+	raw_jmp_m_indexed((uintptr)cache_tags,r,sizeof(cacheline));
 }
 
 STATIC_INLINE void reset_lists(void)
@@ -5654,15 +5857,15 @@ static void prepare_block(blockinfo* bi)
 	set_target(current_compile_p);
 	align_target(32);
 	bi->direct_pen=(cpuop_func*)get_target();
-	raw_mov_l_rm(0,(uae_u32)&(bi->pc_p));
-	raw_mov_l_mr((uae_u32)&regs.pc_p,0);
-	raw_jmp((uae_u32)popall_execute_normal);
+	raw_mov_l_rm(0,(uintptr)&(bi->pc_p));
+	raw_mov_l_mr((uintptr)&regs.pc_p,0);
+	raw_jmp((uintptr)popall_execute_normal);
 
 	align_target(32);
 	bi->direct_pcc=(cpuop_func*)get_target();
-	raw_mov_l_rm(0,(uae_u32)&(bi->pc_p));
-	raw_mov_l_mr((uae_u32)&regs.pc_p,0);
-	raw_jmp((uae_u32)popall_check_checksum);
+	raw_mov_l_rm(0,(uintptr)&(bi->pc_p));
+	raw_mov_l_mr((uintptr)&regs.pc_p,0);
+	raw_jmp((uintptr)popall_check_checksum);
 
 	align_target(32);
 	current_compile_p=get_target();
@@ -5675,6 +5878,7 @@ static void prepare_block(blockinfo* bi)
 	bi->env=default_ss;
 	bi->status=BI_NEW;
 	bi->havestate=0;
+	bi->haveretstub=0;
 	//bi->env=empty_ss;
 }
 
@@ -5704,6 +5908,12 @@ void build_comp(void)
 	write_log (L"JIT: Setting signal handler\n");
 #ifndef _WIN32
 	signal(SIGSEGV,vec);
+#elif defined(CPU_64_BIT)
+	/* x64 SEH can't unwind through generated code, so the __except
+	filter around m68k_go never sees faults raised there */
+	static PVOID vechandler;
+	if (!vechandler)
+		vechandler = AddVectoredExceptionHandler (1, EvalVectoredException);
 #endif
 #endif
 	write_log (L"JIT: Building Compiler function table\n");
@@ -5846,12 +6056,189 @@ static void flush_icache_hard(uae_u32 ptr, int n)
 	}
 
 	reset_lists();
+	ras_clear();
+	memset(evicted_cl,0,sizeof(evicted_cl));
 	if (!compiled_code)
 		return;
-	current_compile_p=compiled_code;
+	memset(segment_used,0,sizeof(segment_used));
+	set_cache_segment(0);
 	set_special(0); /* To get out of compiled code */
 }
 
+/********************************************************************
+* Partial eviction of the translation cache                        *
+********************************************************************/
+
+STATIC_INLINE void mark_evicted(blockinfo* bi)
+{
+	uae_u32 cl=cacheline(bi->pc_p)>>1;
+
+	evicted_cl[cl>>5]|=1<<(cl&31);
+}
+
+STATIC_INLINE int was_evicted(blockinfo* bi)
+{
+	uae_u32 cl=cacheline(bi->pc_p)>>1;
+
+	if (!(evicted_cl[cl>>5] & (1<<(cl&31))))
+		return 0;
+	evicted_cl[cl>>5]&=~(1<<(cl&31));
+	return 1;
+}
+
+/* Blocks that jump straight into bi now leave through their dispatcher
+exit instead. A zero displacement makes the jns fall through to it. */
+STATIC_INLINE void unlink_deps(blockinfo* bi)
+{
+	dependency* x=bi->deplist;
+
+	while (x) {
+		dependency* next=x->next;
+
+		if (x->jmp_off)
+			adjust_jmpdep(x,(uae_u8*)x->jmp_off+4);
+		x->jmp_off=NULL;
+		x->target=NULL;
+		x->prev_p=NULL;
+		x->next=NULL;
+		x=next;
+	}
+	bi->deplist=NULL;
+}
+
+/* A blockinfo inside the segment goes away completely. One that lives
+elsewhere but has its code there is just invalidated, it keeps its
+direct_pen stub so the blocks linked to it don't have to let go. */
+static void evict_blocks(blockinfo* bi, uae_u8* start, uae_u8* end)
+{
+	while (bi) {
+		blockinfo* next=bi->next;
+
+		if ((uae_u8*)bi>=start && (uae_u8*)bi<end) {
+			unlink_deps(bi);
+			remove_deps(bi);
+			remove_from_lists(bi);
+			mark_evicted(bi);
+		} else if (bi->handler && (uae_u8*)bi->handler>=start && (uae_u8*)bi->handler<end) {
+			uae_u32 cl=cacheline(bi->pc_p);
+
+			invalidate_block(bi);
+			if (bi==cache_tags[cl+1].bi)
+				cache_tags[cl].handler=(cpuop_func*)popall_execute_normal;
+			mark_evicted(bi);
+		}
+		bi=next;
+	}
+}
+
+/* Called instead of a hard flush when the current segment is full */
+static void next_cache_segment(void)
+{
+	uae_u8* start;
+	int i;
+
+	if (cache_segments<2) {
+		flush_icache_hard(0, 3);
+		set_target(current_compile_p);
+		return;
+	}
+	evict_count++;
+	segment_used[cur_segment]=current_compile_p-(compiled_code+cur_segment*segment_size);
+	set_cache_segment((cur_segment+1)%cache_segments);
+	segment_used[cur_segment]=0;
+	start=current_compile_p;
+
+	/* Spare blockinfos may sit anywhere, new ones are handed out in order */
+	for (i=0;i<MAX_HOLD_BI;i++)
+		hold_bi[i]=NULL;
+	evict_blocks(active,start,start+segment_size);
+	evict_blocks(dormant,start,start+segment_size);
+	set_target(current_compile_p);
+}
+
+
+/* Write tracking. Where the host can tell which natmem pages were
+written since the last flush, only blocks on those pages need to be
+checked. */
+#define WATCH_PAGE_SHIFT 12
+#define WATCH_MAX_PAGES 4096
+
+#ifdef NATMEM_OFFSET
+static uae_u8* watch_pages[WATCH_MAX_PAGES];
+static int watch_count;
+static uae_u32 watch_size;
+static uae_u32 dirty_pages[(0x100000000ULL>>WATCH_PAGE_SHIFT)/32];
+#endif
+
+/* Returns 0 if the written pages are not known */
+static int mark_dirty_pages(void)
+{
+#ifdef NATMEM_OFFSET
+	int i;
+
+	if (!canbang)
+		return 0;
+	watch_count=mman_GetNatmemWrites(watch_pages,WATCH_MAX_PAGES,&watch_size);
+	if (watch_count<0)
+		return 0;
+	for (i=0;i<watch_count;i++) {
+		uae_u32 pg=(watch_pages[i]-natmem_offset)>>WATCH_PAGE_SHIFT;
+		dirty_pages[pg>>5]|=1<<(pg&31);
+	}
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+static void clear_dirty_pages(void)
+{
+#ifdef NATMEM_OFFSET
+	int i;
+
+	for (i=0;i<watch_count;i++) {
+		uae_u32 pg=(watch_pages[i]-natmem_offset)>>WATCH_PAGE_SHIFT;
+		dirty_pages[pg>>5]&=~(1<<(pg&31));
+	}
+	watch_count=0;
+#endif
+}
+
+STATIC_INLINE int block_on_dirty_page(blockinfo* bi)
+{
+#ifdef NATMEM_OFFSET
+	uae_u32 start=bi->min_pcp-(uae_u32)(uintptr)natmem_offset;
+	uae_u32 pg;
+
+	if (bi->min_pcp<(uae_u32)(uintptr)natmem_offset || start+bi->len>=watch_size)
+		return 1; /* Not watched */
+	for (pg=start>>WATCH_PAGE_SHIFT;pg<=(start+bi->len)>>WATCH_PAGE_SHIFT;pg++) {
+		if (dirty_pages[pg>>5] & (1<<(pg&31)))
+			return 1;
+	}
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+STATIC_INLINE void block_need_check(blockinfo* bi)
+{
+	uae_u32 cl=cacheline(bi->pc_p);
+
+	if (!bi->handler) {
+		/* invalidated block */
+		if (bi==cache_tags[cl+1].bi)
+			cache_tags[cl].handler=(cpuop_func*)popall_execute_normal;
+		bi->handler_to_use=(cpuop_func*)popall_execute_normal;
+		set_dhtu(bi,bi->direct_pen);
+	} else {
+		if (bi==cache_tags[cl+1].bi)
+			cache_tags[cl].handler=(cpuop_func*)popall_check_checksum;
+		bi->handler_to_use=(cpuop_func*)popall_check_checksum;
+		set_dhtu(bi,bi->direct_pcc);
+	}
+}
 
 /* "Soft flushing" --- instead of actually throwing everything away,
 we simply mark everything as "needs to be checked".
@@ -5870,21 +6257,25 @@ void flush_icache(uaecptr ptr, int n)
 	if (!active)
 		return;
 
+	if (mark_dirty_pages()) {
+		/* Blocks on untouched pages stay active */
+		bi=active;
+		while (bi) {
+			bi2=bi->next;
+			if (!bi->handler || block_on_dirty_page(bi)) {
+				block_need_check(bi);
+				remove_from_list(bi);
+				add_to_dormant(bi);
+			}
+			bi=bi2;
+		}
+		clear_dirty_pages();
+		return;
+	}
+
 	bi=active;
 	while (bi) {
-		uae_u32 cl=cacheline(bi->pc_p);
-		if (!bi->handler) {
-			/* invalidated block */
-			if (bi==cache_tags[cl+1].bi)
-				cache_tags[cl].handler=(cpuop_func*)popall_execute_normal;
-			bi->handler_to_use=(cpuop_func*)popall_execute_normal;
-			set_dhtu(bi,bi->direct_pen);
-		} else {
-			if (bi==cache_tags[cl+1].bi)
-				cache_tags[cl].handler=(cpuop_func*)popall_check_checksum;
-			bi->handler_to_use=(cpuop_func*)popall_check_checksum;
-			set_dhtu(bi,bi->direct_pcc);
-		}
+		block_need_check(bi);
 		bi2=bi;
 		bi=bi->next;
 	}
@@ -5909,12 +6300,23 @@ int failure;
 
 void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 {
+#ifdef CPU_64_BIT
+	/* Guest addresses are kept in 32-bit registers, and flags are moved
+	with LAHF/SAHF. Leave anything we can't handle to the interpreter. */
+	if (!canbang || !have_lahf_lm || (uintptr)natmem_offset_end > 0xffffffff)
+		return;
+	for (int j = 0; j < blocklen; j++) {
+		if ((uintptr)pc_hist[j].location > 0xffffffff)
+			return;
+	}
+#endif
 	if (letit && compiled_code && currprefs.cpu_model>=68020) {
 
 		/* OK, here we need to 'compile' a block */
 		int i;
 		int r;
 		int was_comp=0;
+		int was_rts=0;
 		uae_u8 liveflags[MAXRUN+1];
 		uae_u32 max_pcp=(uae_u32)pc_hist[0].location;
 		uae_u32 min_pcp=max_pcp;
@@ -5926,12 +6328,14 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 
 		compile_count++;
 		if (current_compile_p>=max_compile_start)
-			flush_icache_hard(0, 3);
+			next_cache_segment();
 
 		alloc_blockinfos();
 
 		bi=get_blockinfo_addr_new(pc_hist[0].location,0);
 		bi2=get_blockinfo(cl);
+		if (!bi->handler && was_evicted(bi))
+			recompile_count++;
 
 		optlev=bi->optlevel;
 		if (bi->handler) {
@@ -5993,8 +6397,8 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 
 		bi->handler=
 			bi->handler_to_use=(cpuop_func*)get_target();
-		raw_cmp_l_mi((uae_u32)&regs.pc_p,(uae_u32)pc_hist[0].location);
-		raw_jnz((uae_u32)popall_cache_miss);
+		raw_cmp_l_mi((uintptr)&regs.pc_p,(uae_u32)pc_hist[0].location);
+		raw_jnz((uintptr)popall_cache_miss);
 		/* This was 16 bytes on the x86, so now aligned on (n+1)*32 */
 
 		was_comp=0;
@@ -6008,23 +6412,24 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 
 		bi->direct_handler=(cpuop_func*)get_target();
 		set_dhtu(bi,bi->direct_handler);
-		current_block_start_target=(uae_u32)get_target();
+		current_block_start_target=(uintptr)get_target();
 
 		if (bi->count>=0) { /* Need to generate countdown code */
-			raw_mov_l_mi((uae_u32)&regs.pc_p,(uae_u32)pc_hist[0].location);
-			raw_sub_l_mi((uae_u32)&(bi->count),1);
-			raw_jl((uae_u32)popall_recompile_block);
+			raw_mov_l_mi((uintptr)&regs.pc_p,(uae_u32)pc_hist[0].location);
+			raw_sub_l_mi((uintptr)&(bi->count),1);
+			raw_jl((uintptr)popall_recompile_block);
 		}
 		if (optlev==0) { /* No need to actually translate */
 			/* Execute normally without keeping stats */
-			raw_mov_l_mi((uae_u32)&regs.pc_p,(uae_u32)pc_hist[0].location);
-			raw_jmp((uae_u32)popall_exec_nostats);
+			raw_mov_l_mi((uintptr)&regs.pc_p,(uae_u32)pc_hist[0].location);
+			raw_jmp((uintptr)popall_exec_nostats);
 		}
 		else {
 			reg_alloc_run=0;
 			next_pc_p=0;
 			taken_pc_p=0;
 			branch_cc=0;
+			call_pc_p=0;
 
 			log_startblock();
 			for (i=0;i<blocklen &&
@@ -6035,6 +6440,8 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 
 					opcode=cft_map((uae_u16)*pc_hist[i].location);
 					special_mem=pc_hist[i].specmem;
+					call_pc_p=0;
+					was_rts=(table68k[opcode].mnemo==i_RTS);
 					needed_flags=(liveflags[i+1] & prop[opcode].set_flags);
 					if (!needed_flags && currprefs.compnf) {
 #ifdef NOFLAGS_SUPPORT
@@ -6073,40 +6480,41 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 					else
 						failure=1;
 					if (failure) {
+						call_pc_p=0;
 						if (was_comp) {
 							flush(1);
 							was_comp=0;
 						}
 						raw_mov_l_ri(REG_PAR1,(uae_u32)opcode);
-						raw_mov_l_ri(REG_PAR2,(uae_u32)&regs);
+						raw_mov_p_ri(REG_PAR2,(uintptr)&regs);
 #if USE_NORMAL_CALLING_CONVENTION
 						raw_push_l_r(REG_PAR2);
 						raw_push_l_r(REG_PAR1);
 #endif
-						raw_mov_l_mi((uae_u32)&regs.pc_p,
+						raw_mov_l_mi((uintptr)&regs.pc_p,
 							(uae_u32)pc_hist[i].location);
-						raw_call((uae_u32)cputbl[opcode]);
-						//raw_add_l_mi((uae_u32)&oink,1); // FIXME
+						raw_call((uintptr)cputbl[opcode]);
+						//raw_add_l_mi((uintptr)&oink,1); // FIXME
 #if USE_NORMAL_CALLING_CONVENTION
 						raw_inc_sp(8);
 #endif
 						/*if (needed_flags)
-						raw_mov_l_mi((uae_u32)&foink3,(uae_u32)opcode+65536);
+						raw_mov_l_mi((uintptr)&foink3,(uae_u32)opcode+65536);
 						else
-						raw_mov_l_mi((uae_u32)&foink3,(uae_u32)opcode);
+						raw_mov_l_mi((uintptr)&foink3,(uae_u32)opcode);
 						*/
 
 						if (i<blocklen-1) {
 							uae_s8* branchadd;
 
-							raw_mov_l_rm(0,(uae_u32)specflags);
+							raw_mov_l_rm(0,(uintptr)specflags);
 							raw_test_l_rr(0,0);
 							raw_jz_b_oponly();
 							branchadd=(uae_s8*)get_target();
 							emit_byte(0);
-							raw_sub_l_mi((uae_u32)&countdown,scaled_cycles(totcycles));
-							raw_jmp((uae_u32)popall_do_nothing);
-							*branchadd=(uae_u32)get_target()-(uae_u32)branchadd-1;
+							raw_sub_l_mi((uintptr)&countdown,scaled_cycles(totcycles));
+							raw_jmp((uintptr)popall_do_nothing);
+							*branchadd=(uintptr)get_target()-(uintptr)branchadd-1;
 						}
 					}
 			}
@@ -6168,28 +6576,28 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 				tbi=get_blockinfo_addr_new((void*)t1,1);
 				match_states(&(tbi->env));
 				//flush(1); /* Can only get here if was_comp==1 */
-				raw_sub_l_mi((uae_u32)&countdown,scaled_cycles(totcycles));
+				raw_sub_l_mi((uintptr)&countdown,scaled_cycles(totcycles));
 				raw_jcc_l_oponly(9);
 				tba=(uae_u32*)get_target();
-				emit_long(get_handler(t1)-((uae_u32)tba+4));
-				raw_mov_l_mi((uae_u32)&regs.pc_p,t1);
-				raw_jmp((uae_u32)popall_do_nothing);
+				emit_long(get_handler(t1)-((uintptr)tba+4));
+				raw_mov_l_mi((uintptr)&regs.pc_p,t1);
+				raw_jmp((uintptr)popall_do_nothing);
 				create_jmpdep(bi,0,tba,t1);
 
 				align_target(16);
 				/* not-predicted outcome */
-				*branchadd=(uae_u32)get_target()-((uae_u32)branchadd+4);
+				*branchadd=(uintptr)get_target()-((uintptr)branchadd+4);
 				live=tmp; /* Ouch again */
 				tbi=get_blockinfo_addr_new((void*)t2,1);
 				match_states(&(tbi->env));
 
 				//flush(1); /* Can only get here if was_comp==1 */
-				raw_sub_l_mi((uae_u32)&countdown,scaled_cycles(totcycles));
+				raw_sub_l_mi((uintptr)&countdown,scaled_cycles(totcycles));
 				raw_jcc_l_oponly(9);
 				tba=(uae_u32*)get_target();
-				emit_long(get_handler(t2)-((uae_u32)tba+4));
-				raw_mov_l_mi((uae_u32)&regs.pc_p,t2);
-				raw_jmp((uae_u32)popall_do_nothing);
+				emit_long(get_handler(t2)-((uintptr)tba+4));
+				raw_mov_l_mi((uintptr)&regs.pc_p,t2);
+				raw_jmp((uintptr)popall_do_nothing);
 				create_jmpdep(bi,1,tba,t2);
 			}
 			else
@@ -6197,6 +6605,8 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 				if (was_comp) {
 					flush(1);
 				}
+				if (was_comp && call_pc_p)
+					ras_push(bi,call_pc_p,isinreg(PC_P)?live.state[PC_P].realreg:-1);
 
 				/* Let's find out where next_handler is... */
 				if (was_comp && isinreg(PC_P)) {
@@ -6209,10 +6619,12 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 					else
 						r2=0;
 
+					if (was_rts)
+						ras_pop(r,scaled_cycles(totcycles));
 					raw_and_l_ri(r,TAGMASK);
-					raw_mov_l_ri(r2,(uae_u32)popall_do_nothing);
-					raw_sub_l_mi((uae_u32)&countdown,scaled_cycles(totcycles));
-					raw_cmov_l_rm_indexed(r2,(uae_u32)cache_tags,r,9);
+					raw_mov_p_ri(r2,(uintptr)popall_do_nothing);
+					raw_sub_l_mi((uintptr)&countdown,scaled_cycles(totcycles));
+					raw_cmov_l_rm_indexed(r2,(uintptr)cache_tags,r,9);
 					raw_jmp_r(r2);
 				}
 				else if (was_comp && isconst(PC_P)) {
@@ -6223,28 +6635,30 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 					tbi=get_blockinfo_addr_new((void*)v,1);
 					match_states(&(tbi->env));
 
-					raw_sub_l_mi((uae_u32)&countdown,scaled_cycles(totcycles));
+					raw_sub_l_mi((uintptr)&countdown,scaled_cycles(totcycles));
 					raw_jcc_l_oponly(9);
 					tba=(uae_u32*)get_target();
-					emit_long(get_handler(v)-((uae_u32)tba+4));
-					raw_mov_l_mi((uae_u32)&regs.pc_p,v);
-					raw_jmp((uae_u32)popall_do_nothing);
+					emit_long(get_handler(v)-((uintptr)tba+4));
+					raw_mov_l_mi((uintptr)&regs.pc_p,v);
+					raw_jmp((uintptr)popall_do_nothing);
 					create_jmpdep(bi,0,tba,v);
 				}
 				else {
 					int r2;
 
 					r=REG_PC_TMP;
-					raw_mov_l_rm(r,(uae_u32)&regs.pc_p);
+					raw_mov_l_rm(r,(uintptr)&regs.pc_p);
 					if (r==0)
 						r2=1;
 					else
 						r2=0;
 
+					if (was_rts)
+						ras_pop(r,scaled_cycles(totcycles));
 					raw_and_l_ri(r,TAGMASK);
-					raw_mov_l_ri(r2,(uae_u32)popall_do_nothing);
-					raw_sub_l_mi((uae_u32)&countdown,scaled_cycles(totcycles));
-					raw_cmov_l_rm_indexed(r2,(uae_u32)cache_tags,r,9);
+					raw_mov_p_ri(r2,(uintptr)popall_do_nothing);
+					raw_sub_l_mi((uintptr)&countdown,scaled_cycles(totcycles));
+					raw_cmov_l_rm_indexed(r2,(uintptr)cache_tags,r,9);
 					raw_jmp_r(r2);
 				}
 			}
@@ -6275,9 +6689,9 @@ void compile_block(cpu_history* pc_hist, int blocklen, int totcycles)
 		raise_in_cl_list(bi);
 		bi->nexthandler=current_compile_p;
 
-		/* We will flush soon, anyway, so let's do it now */
+		/* We will move on soon, anyway, so let's do it now */
 		if (current_compile_p>=max_compile_start)
-			flush_icache_hard(0, 3);
+			next_cache_segment();
 
 		do_extra_cycles(totcycles); /* for the compilation time */
 	}
@@ -1694,9 +1694,9 @@ gen_opcode (unsigned long int opcode)
 	comprintf("\tint newad=scratchie++;\n"
 		  "\treadlong(15,newad,scratchie);\n"
 		  "\tand_l_ri(newad,~1);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc,newad);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc,newad);\n"
 		  "\tget_n_addr_jmp(newad,PC_P,scratchie);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc_oldp,PC_P);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc_oldp,PC_P);\n"
 		  "\tm68k_pc_offset=0;\n"
 		  "\tadd_l(15,offs);\n");
 	gen_update_next_handler();
@@ -1724,9 +1724,9 @@ gen_opcode (unsigned long int opcode)
 	comprintf("\tint newad=scratchie++;\n"
 		  "\treadlong(15,newad,scratchie);\n"
 		  "\tand_l_ri(newad,~1);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc,newad);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc,newad);\n"
 		  "\tget_n_addr_jmp(newad,PC_P,scratchie);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc_oldp,PC_P);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc_oldp,PC_P);\n"
 		  "\tm68k_pc_offset=0;\n"
 		  "\tlea_l_brr(15,15,4);\n");
 	gen_update_next_handler();
@@ -1748,11 +1748,12 @@ gen_opcode (unsigned long int opcode)
 	comprintf("\tint ret=scratchie++;\n"
 		  "\tmov_l_ri(ret,retadd);\n"
 		  "\tsub_l_ri(15,4);\n"
-		  "\twritelong_clobber(15,ret,scratchie);\n");
+		  "\twritelong_clobber(15,ret,scratchie);\n"
+		  "\tregister_call((uae_u32)(uintptr)comp_pc_p+m68k_pc_offset);\n");
 	comprintf("\tand_l_ri(srca,~1);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc,srca);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc,srca);\n"
 		  "\tget_n_addr_jmp(srca,PC_P,scratchie);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc_oldp,PC_P);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc_oldp,PC_P);\n"
 		  "\tm68k_pc_offset=0;\n");
 	gen_update_next_handler();
 	break;
@@ -1760,9 +1761,9 @@ gen_opcode (unsigned long int opcode)
 	isjump;
 	genamode (curi->smode, "srcreg", curi->size, "src", 0, 0);
 	comprintf("\tand_l_ri(srca,~1);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc,srca);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc,srca);\n"
 		  "\tget_n_addr_jmp(srca,PC_P,scratchie);\n"
-		  "\tmov_l_mr((uae_u32)&regs.pc_oldp,PC_P);\n"
+		  "\tmov_l_mr((uintptr)&regs.pc_oldp,PC_P);\n"
 		  "\tm68k_pc_offset=0;\n");
 	gen_update_next_handler();
 	break;
@@ -1777,7 +1778,8 @@ gen_opcode (unsigned long int opcode)
 	comprintf("\tint ret=scratchie++;\n"
 		  "\tmov_l_ri(ret,retadd);\n"
 		  "\tsub_l_ri(15,4);\n"
-		  "\twritelong_clobber(15,ret,scratchie);\n");
+		  "\twritelong_clobber(15,ret,scratchie);\n"
+		  "\tregister_call((uae_u32)(uintptr)comp_pc_p+m68k_pc_offset);\n");
 	comprintf("\tadd_l_ri(src,m68k_pc_offset_thisinst+2);\n");
 	comprintf("\tm68k_pc_offset=0;\n");
 	comprintf("\tadd_l(PC_P,src);\n");
@@ -1785,6 +1787,15 @@ gen_opcode (unsigned long int opcode)
 	comprintf("\tcomp_pc_p=(uae_u8*)get_const(PC_P);\n");
 	break;
      case i_Bcc:
+	if (curi->size == sz_byte && curi->cc == 6) {
+	    /* SUBQ #1,Dn + BNE.S delay loop, let the interpreter collapse it */
+	    mayfail;
+	    comprintf("if (srcreg==-4 && m68k_pc_offset_thisinst>=2 && IS_DELAYLOOP_SUBQ(comp_get_iword(m68k_pc_offset_thisinst-2))) {\n"
+		"  FAIL(1);\n"
+		"  return 0;\n"
+		"} \n");
+	    start_brace();
+	}
 	comprintf("\tuae_u32 v1,v2;\n");
 	genamode (curi->smode, "srcreg", curi->size, "src", 1, 0);
 	/* That source is an immediate, so we can clobber it with abandon */
@@ -1862,6 +1873,13 @@ gen_opcode (unsigned long int opcode)
      case i_DBcc:
 	isjump;
 	uses_cmov;
+	/* DBcc.W Dn,* delay loop, let the interpreter collapse it */
+	mayfail;
+	comprintf("if ((uae_s16)comp_get_iword(m68k_pc_offset)==-2) {\n"
+		"  FAIL(1);\n"
+		"  return 0;\n"
+		"} \n");
+	start_brace();
 	genamode (curi->smode, "srcreg", curi->size, "src", 1, 0);
 	genamode (curi->dmode, "dstreg", curi->size, "offs", 1, 0);
 
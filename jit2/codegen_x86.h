@@ -425,7 +425,7 @@ typedef unsigned int	_ul;
 
 /* Use RIP-addressing in 64-bit mode, if possible */
 #define _x86_RIP_addressing_possible(D,O)	(X86_RIP_RELATIVE_ADDR && \
-						((uintptr)x86_get_target() + 4 + (O) - (D) <= 0xffffffff))
+						((uintptr)(D) - ((uintptr)x86_get_target() + 4 + (O)) + 0x80000000ULL <= 0xffffffffULL))
 
 #define _r_X(   R, D,B,I,S,O)	(_r0P(I) ? (_r0P(B)    ? (!X86_TARGET_64BIT ? _r_D(R,D) : \
 					                 (_x86_RIP_addressing_possible(D, O) ? \
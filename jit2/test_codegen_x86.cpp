@@ -31,7 +31,10 @@
  *
  *  TODO:
  *  - Rewrite to use internal BFD/opcodes format instead of string compares
- *  - Add reg/mem, imm/mem variations
+ *  - Add imm/mem variations
+ *
+ *  The x86-64 helpers of the JIT (jit/compemu_raw_x86_64.h) emit fixed
+ *  sequences and are compared byte for byte instead.
  */
 
 #define _BSD_SOURCE 1
@@ -56,6 +59,8 @@ static int verbose = 2;
 #define TEST_INST_ALU_CNT_REG	1
 #define TEST_INST_ALU_IMM_REG	1
 #define TEST_INST_ALU_MEM_REG	1
+#define TEST_INST_ALU_REG_MEM	1
+#define TEST_INST_RAW_X86_64	1
 #endif
 #if TEST_INST_FPU
 #define TEST_INST_FPU_UNARY	1
@@ -156,6 +161,47 @@ static inline uint8 *get_target(void)
     return target;
 }
 
+#if TEST_INST_RAW_X86_64 && X86_TARGET_64BIT
+#ifndef STATIC_INLINE
+#define STATIC_INLINE		static inline
+#endif
+typedef uint32 uae_u32;
+typedef int64 uae_s64;
+#define EAX_INDEX		0
+#define R11_INDEX		11
+#define lopt_emit_all()
+#include "../jit/compemu_raw_x86_64.h"
+
+static int put_quad(uint8 *p, uint64 v)
+{
+    memcpy(p, &v, 8);
+    return 8;
+}
+
+static int put_long(uint8 *p, uint32 v)
+{
+    memcpy(p, &v, 4);
+    return 4;
+}
+
+// Compare what a JIT helper emitted at [b, e) with the expected bytes
+static bool check_bytes(const char *name, const uint8 *b, const uint8 *e, const uint8 *ref, int n)
+{
+    if (e - b == n && memcmp(b, ref, n) == 0)
+	return true;
+    if (verbose > 1) {
+	fprintf(stderr, "%s:", name);
+	for (const uint8 *p = b; p < e; p++)
+	    fprintf(stderr, " %02x", *p);
+	fprintf(stderr, " | expected");
+	for (int j = 0; j < n; j++)
+	    fprintf(stderr, " %02x", ref[j]);
+	fprintf(stderr, "\n");
+    }
+    return false;
+}
+#endif
+
 static uint32 mon_read_byte(uintptr addr)
 {
     uint8 *m = (uint8 *)addr;
@@ -1385,6 +1431,205 @@ int main(void)
     n_all_failures += n_failures;
 #endif
 
+#if TEST_INST_ALU_REG_MEM
+    printf("Testing reg,mem forms\n");
+    n_tests = n_failures = 0;
+    for (int d = 0; d < off_table_count; d++) {
+	const uint32 D = off_table[d];
+	for (int B = -1; B < X86_MAX_ALU_REGS; B++) {
+	    for (int I = -1; I < X86_MAX_ALU_REGS; I++) {
+		if (I == X86_RSP)
+		    continue;
+		for (int S = 1; S < 16; S *= 2) {
+		    if (I == -1 && S > 1)
+			continue;
+		    for (int r = 0; r < X86_MAX_ALU_REGS; r++) {
+			set_target(block);
+			uint8 *b = get_target();
+			int i = 0;
+#define GEN(INSN, GENOP) do {				\
+			insns[i++] = INSN;		\
+			GENOP##rm(r, D, B, I, S);	\
+			} while (0)
+#define GEN64(INSN, GENOP) do {				\
+			if (X86_TARGET_64BIT)		\
+			    GEN(INSN, GENOP);		\
+			} while (0)
+#define GENA(INSN, GENOP) do {				\
+			if (VALID_REG8(r))		\
+			    GEN(INSN "b", GENOP##B);	\
+			GEN(INSN "w", GENOP##W);	\
+			GEN(INSN "l", GENOP##L);	\
+			GEN64(INSN "q", GENOP##Q);	\
+			} while (0)
+			GENA("adc", ADC);
+			GENA("add", ADD);
+			GENA("and", AND);
+			GENA("cmp", CMP);
+			GENA("or",  OR);
+			GENA("sbb", SBB);
+			GENA("sub", SUB);
+			GENA("xor", XOR);
+			GENA("mov", MOV);
+			GENA("xchg", XCHG);
+#undef  GENA
+#undef  GEN64
+#undef  GEN
+			int last_insn = i;
+			uint8 *e = get_target();
+
+			uint8 *p = b;
+			i = 0;
+			while (p < e) {
+			    int n = disass_x86(buffer, (uintptr)p);
+			    insn_t ii;
+			    parse_insn(&ii, buffer);
+
+			    if (!check_reg_mem(&ii, insns[i], D, B, I, S, r)) {
+				show_instruction(buffer, p);
+				n_failures++;
+			    }
+
+			    p += n;
+			    i += 1;
+			    n_tests++;
+			    show_status(n_tests);
+			}
+			if (i != last_insn)
+			    abort();
+		    }
+		}
+	    }
+	}
+    }
+    printf(" done %ld/%ld\n", n_tests - n_failures, n_tests);
+    n_all_tests += n_tests;
+    n_all_failures += n_failures;
+#endif
+
+#if TEST_INST_RAW_X86_64 && X86_TARGET_64BIT
+    printf("Testing JIT x86-64 helpers\n");
+    n_tests = n_failures = 0;
+    {
+	// far from the code buffer and above 2GB, only reachable through %r11
+	const uintptr far_addr = (uintptr)block + 0x100000000ULL;
+	uint8 ref[64];
+	uintptr m;
+	int n;
+
+	// raw_abs: RIP-relative near the code, disp32 below 2GB, else %r11
+	set_target(block);
+	m = (uintptr)block + 0x1000;
+	n_tests++;
+	if (raw_abs(&m, 1) != X86_NOREG || m != (uintptr)block + 0x1000 || get_target() != block) {
+	    fprintf(stderr, "raw_abs: RIP-relative address not used as is\n");
+	    n_failures++;
+	}
+	set_target(block);
+	m = 0x12345678;
+	n_tests++;
+	if (raw_abs(&m, 0) != X86_NOREG || m != 0x12345678 || get_target() != block) {
+	    fprintf(stderr, "raw_abs: disp32 address not used as is\n");
+	    n_failures++;
+	}
+	for (int rip = 0; rip < 2; rip++) {
+	    set_target(block);
+	    m = far_addr;
+	    int b = raw_abs(&m, rip);
+	    n = 0;
+	    ref[n++] = 0x49; ref[n++] = 0xbb;		// movabs $m,%r11
+	    n += put_quad(ref + n, far_addr);
+	    n_tests++;
+	    if (b != R11_INDEX || m != 0 || !check_bytes("raw_abs", block, get_target(), ref, n))
+		n_failures++;
+	}
+
+	// raw_jcc_far: j!cc skipping exactly the jump through %r11
+	for (int cc = 0; cc < 16; cc++) {
+	    set_target(block);
+	    raw_jcc_far(cc, far_addr);
+	    n = 0;
+	    ref[n++] = 0x70 + (cc ^ 1); ref[n++] = 13;
+	    ref[n++] = 0x49; ref[n++] = 0xbb;		// movabs $t,%r11
+	    n += put_quad(ref + n, far_addr);
+	    ref[n++] = 0x41; ref[n++] = 0xff; ref[n++] = 0xe3;	// jmp *%r11
+	    n_tests++;
+	    if (!check_bytes("raw_jcc_far", block, get_target(), ref, n))
+		n_failures++;
+	}
+
+	// raw_call_bank: call *offset(banks[r >> 16])
+	static const uae_u32 bank_offsets[] = { 0x10, 0x80 };
+	for (int r = 0; r < X86_MAX_ALU_REGS; r++) {
+	    if (r == X86_RSP || r == R11_INDEX)
+		continue;
+	    for (int o = 0; o < 2; o++) {
+		const uae_u32 offset = bank_offsets[o];
+		set_target(block);
+		raw_call_bank(far_addr, r, offset);
+		n = 0;
+		if (r >= 8)
+		    ref[n++] = 0x44;
+		ref[n++] = 0x89; ref[n++] = 0xc0 | ((r & 7) << 3);	// mov r,%eax
+		ref[n++] = 0xc1; ref[n++] = 0xe8; ref[n++] = 0x10;	// shr $16,%eax
+		ref[n++] = 0x49; ref[n++] = 0xbb;			// movabs $banks,%r11
+		n += put_quad(ref + n, far_addr);
+		ref[n++] = 0x4d; ref[n++] = 0x8b; ref[n++] = 0x1c; ref[n++] = 0xc3;	// mov (%r11,%rax,8),%r11
+		ref[n++] = 0x41; ref[n++] = 0xff;			// call *offset(%r11)
+		if (offset < 0x80) {
+		    ref[n++] = 0x53; ref[n++] = offset;
+		} else {
+		    ref[n++] = 0x93; n += put_long(ref + n, offset);
+		}
+		n_tests++;
+		if (!check_bytes("raw_call_bank", block, get_target(), ref, n))
+		    n_failures++;
+	    }
+	}
+
+	// raw_mov_q_mi_indexed, the x86-64 raw_mov_p_mi_indexed: disp32
+	// base below 2GB, %r11 base otherwise
+	const uint64 value = 0x123456789abcdef0ULL;
+	for (int r = 0; r < X86_MAX_ALU_REGS; r++) {
+	    if (r == X86_RSP || r == R11_INDEX)
+		continue;
+	    for (int tmp = 0; tmp < X86_MAX_ALU_REGS; tmp++) {
+		if (tmp == r || tmp == X86_RSP || tmp == R11_INDEX)
+		    continue;
+		for (int low = 0; low < 2; low++) {
+		    const uintptr base = low ? 0x12345678 : far_addr;
+		    set_target(block);
+		    raw_mov_q_mi_indexed(base, r, value, tmp);
+		    n = 0;
+		    ref[n++] = 0x48 | (tmp >> 3);		// movabs $v,tmp
+		    ref[n++] = 0xb8 | (tmp & 7);
+		    n += put_quad(ref + n, value);
+		    if (low) {					// mov tmp,base(,r,8)
+			ref[n++] = 0x48 | ((tmp >> 3) << 2) | ((r >> 3) << 1);
+			ref[n++] = 0x89;
+			ref[n++] = 0x04 | ((tmp & 7) << 3);
+			ref[n++] = 0xc5 | ((r & 7) << 3);
+			n += put_long(ref + n, base);
+		    } else {
+			ref[n++] = 0x49; ref[n++] = 0xbb;	// movabs $base,%r11
+			n += put_quad(ref + n, base);
+			ref[n++] = 0x49 | ((tmp >> 3) << 2) | ((r >> 3) << 1);	// mov tmp,(%r11,r,8)
+			ref[n++] = 0x89;
+			ref[n++] = 0x04 | ((tmp & 7) << 3);
+			ref[n++] = 0xc3 | ((r & 7) << 3);
+		    }
+		    n_tests++;
+		    if (!check_bytes("raw_mov_q_mi_indexed", block, get_target(), ref, n))
+			n_failures++;
+		}
+	    }
+	}
+    }
+    printf(" done %ld/%ld\n", n_tests - n_failures, n_tests);
+    n_all_tests += n_tests;
+    n_all_failures += n_failures;
+#endif
+
 #if TEST_INST_FPU_UNARY
     printf("Testing FPU unary forms\n");
     n_tests = n_failures = 0;
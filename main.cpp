@@ -9,6 +9,13 @@
 #include "sysconfig.h"
 #include "sysdeps.h"
 #include <assert.h>
+#ifdef HAVE_SSE2_INTRINSICS
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
 
 #include "options.h"
 #include "threaddep/thread.h"
@@ -100,6 +107,61 @@ uae_u32 uaerandgetseed (void)
 	return randseed;
 }
 
+/* 0, HOST_SIMD_SSE2 or HOST_SIMD_AVX2 */
+static int host_simd_detect (void)
+{
+#ifdef HAVE_SSE2_INTRINSICS
+	unsigned int r1[4], r7[4];
+	int avxos = 0;
+
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid (regs, 0);
+	if (regs[0] < 1)
+		return 0;
+	r7[1] = 0;
+	if (regs[0] >= 7) {
+		__cpuidex (regs, 7, 0);
+		r7[1] = regs[1];
+	}
+	__cpuid (regs, 1);
+	r1[2] = regs[2];
+	r1[3] = regs[3];
+#if _MSC_VER >= 1600
+	if (r1[2] & (1 << 27))
+		avxos = (_xgetbv (0) & 6) == 6;
+#endif
+#else
+	if (!__get_cpuid (1, &r1[0], &r1[1], &r1[2], &r1[3]))
+		return 0;
+	r7[1] = 0;
+	if (__get_cpuid_max (0, NULL) >= 7)
+		__cpuid_count (7, 0, r7[0], r7[1], r7[2], r7[3]);
+	if (r1[2] & (1 << 27)) {
+		unsigned int xlo, xhi;
+		__asm__ ("xgetbv" : "=a" (xlo), "=d" (xhi) : "c" (0));
+		avxos = (xlo & 6) == 6;
+	}
+#endif
+	if (!(r1[3] & (1 << 26)))
+		return 0;
+	if (avxos && (r1[2] & (1 << 28)) && (r7[1] & (1 << 5)))
+		return HOST_SIMD_AVX2;
+	return HOST_SIMD_SSE2;
+#else
+	return 0;
+#endif
+}
+
+int host_simd_level (void)
+{
+	static int level = -1;
+
+	if (level < 0)
+		level = host_simd_detect ();
+	return level;
+}
+
 void discard_prefs (struct uae_prefs *p, int type)
 {
 	struct strlist **ps = &p->all_lines;
@@ -32,6 +32,7 @@
 #include "a2091.h"
 #include "gayle.h"
 #include "debug.h"
+#include "cpummu.h"
 
 bool canbang;
 int candirect = -1;
@@ -357,6 +358,7 @@ static void REGPARAM2 chipmem_lput_ce2 (uaecptr addr, uae_u32 l)
 	special_mem |= S_WRITE;
 #endif
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	ce2_timeout ();
 	do_put_mem_long (m, l);
@@ -370,6 +372,7 @@ static void REGPARAM2 chipmem_wput_ce2 (uaecptr addr, uae_u32 w)
 	special_mem |= S_WRITE;
 #endif
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	ce2_timeout ();
 	do_put_mem_word (m, w);
@@ -381,6 +384,7 @@ static void REGPARAM2 chipmem_bput_ce2 (uaecptr addr, uae_u32 b)
 	special_mem |= S_WRITE;
 #endif
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 1);
 	ce2_timeout ();
 	chipmemory[addr] = b;
 }
@@ -419,6 +423,7 @@ void REGPARAM2 chipmem_lput (uaecptr addr, uae_u32 l)
 	uae_u32 *m;
 
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -428,6 +433,7 @@ void REGPARAM2 chipmem_wput (uaecptr addr, uae_u32 w)
 	uae_u16 *m;
 
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -435,6 +441,7 @@ void REGPARAM2 chipmem_wput (uaecptr addr, uae_u32 w)
 void REGPARAM2 chipmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr &= chipmem_mask;
+	decodecache_write (chipmemory + addr, 1);
 	chipmemory[addr] = b;
 }
 
@@ -515,6 +522,7 @@ static void REGPARAM2 chipmem_agnus_lput (uaecptr addr, uae_u32 l)
 	addr &= chipmem_full_mask;
 	if (addr >= chipmem_full_size)
 		return;
+	decodecache_write (chipmemory + addr, 4);
 	m = (uae_u32 *)(chipmemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -526,6 +534,7 @@ void REGPARAM2 chipmem_agnus_wput (uaecptr addr, uae_u32 w)
 	addr &= chipmem_full_mask;
 	if (addr >= chipmem_full_size)
 		return;
+	decodecache_write (chipmemory + addr, 2);
 	m = (uae_u16 *)(chipmemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -535,6 +544,7 @@ static void REGPARAM2 chipmem_agnus_bput (uaecptr addr, uae_u32 b)
 	addr &= chipmem_full_mask;
 	if (addr >= chipmem_full_size)
 		return;
+	decodecache_write (chipmemory + addr, 1);
 	chipmemory[addr] = b;
 }
 
@@ -655,6 +665,7 @@ static void REGPARAM2 bogomem_lput (uaecptr addr, uae_u32 l)
 {
 	uae_u32 *m;
 	addr &= bogomem_mask;
+	decodecache_write (bogomemory + addr, 4);
 	m = (uae_u32 *)(bogomemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -663,6 +674,7 @@ static void REGPARAM2 bogomem_wput (uaecptr addr, uae_u32 w)
 {
 	uae_u16 *m;
 	addr &= bogomem_mask;
+	decodecache_write (bogomemory + addr, 2);
 	m = (uae_u16 *)(bogomemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -670,6 +682,7 @@ static void REGPARAM2 bogomem_wput (uaecptr addr, uae_u32 w)
 static void REGPARAM2 bogomem_bput (uaecptr addr, uae_u32 b)
 {
 	addr &= bogomem_mask;
+	decodecache_write (bogomemory + addr, 1);
 	bogomemory[addr] = b;
 }
 
@@ -793,6 +806,7 @@ static void REGPARAM2 a3000lmem_lput (uaecptr addr, uae_u32 l)
 {
 	uae_u32 *m;
 	addr &= a3000lmem_mask;
+	decodecache_write (a3000lmemory + addr, 4);
 	m = (uae_u32 *)(a3000lmemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -801,6 +815,7 @@ static void REGPARAM2 a3000lmem_wput (uaecptr addr, uae_u32 w)
 {
 	uae_u16 *m;
 	addr &= a3000lmem_mask;
+	decodecache_write (a3000lmemory + addr, 2);
 	m = (uae_u16 *)(a3000lmemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -808,6 +823,7 @@ static void REGPARAM2 a3000lmem_wput (uaecptr addr, uae_u32 w)
 static void REGPARAM2 a3000lmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr &= a3000lmem_mask;
+	decodecache_write (a3000lmemory + addr, 1);
 	a3000lmemory[addr] = b;
 }
 
@@ -858,6 +874,7 @@ static void REGPARAM2 a3000hmem_lput (uaecptr addr, uae_u32 l)
 {
 	uae_u32 *m;
 	addr &= a3000hmem_mask;
+	decodecache_write (a3000hmemory + addr, 4);
 	m = (uae_u32 *)(a3000hmemory + addr);
 	do_put_mem_long (m, l);
 }
@@ -866,6 +883,7 @@ static void REGPARAM2 a3000hmem_wput (uaecptr addr, uae_u32 w)
 {
 	uae_u16 *m;
 	addr &= a3000hmem_mask;
+	decodecache_write (a3000hmemory + addr, 2);
 	m = (uae_u16 *)(a3000hmemory + addr);
 	do_put_mem_word (m, w);
 }
@@ -873,6 +891,7 @@ static void REGPARAM2 a3000hmem_wput (uaecptr addr, uae_u32 w)
 static void REGPARAM2 a3000hmem_bput (uaecptr addr, uae_u32 b)
 {
 	addr &= a3000hmem_mask;
+	decodecache_write (a3000hmemory + addr, 1);
 	a3000hmemory[addr] = b;
 }
 
@@ -2711,6 +2730,10 @@ void map_banks (addrbank *bank, int start, int size, int realsize)
 
 	old = debug_bankchange (-1);
 	flush_icache (0, 3); /* Sure don't want to keep any old mappings around! */
+	decodecache_flush ();
+#ifdef FULLMMU
+	mmu_flush_host_tlb ();
+#endif
 #ifdef NATMEM_OFFSET
 	delete_shmmaps (start << 16, size << 16);
 #endif
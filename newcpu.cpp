@@ -67,7 +67,11 @@ int movem_index1[256];
 int movem_index2[256];
 int movem_next[256];
 
-cpuop_func *cpufunctbl[65536];
+static cpuop_func *cpufunctbl_normal[65536];
+#ifdef CPUEMU_12_T
+static cpuop_func *cpufunctbl_tracer[65536];
+#endif
+cpuop_func **cpufunctbl = cpufunctbl_normal;
 
 struct mmufixup mmufixup[2];
 
@@ -179,6 +183,26 @@ void (*x_do_cycles_post)(unsigned long, uae_u32);
 
 static struct cputracestruct cputrace;
 
+static void build_cpufunctbl (void);
+static int tracer_tables;
+
+/* Generated cycle-exact tables call memory and cycle functions directly,
+* CPU tracer needs the x_* versions which are in separate "_t" tables.
+* Both are built by build_cpufunctbl (), switching only swaps the
+* pointer so it is safe in the middle of an instruction.
+*/
+static bool want_tracer_tables (void)
+{
+	return cpu_tracer != 0 && currprefs.cpu_cycle_exact && (currprefs.cpu_model == 68000 || currprefs.cpu_model == 68020);
+}
+static void set_tracer_tables (void)
+{
+#ifdef CPUEMU_12_T
+	tracer_tables = want_tracer_tables ();
+	cpufunctbl = tracer_tables ? cpufunctbl_tracer : cpufunctbl_normal;
+#endif
+}
+
 STATIC_INLINE void clear_trace (void)
 {
 	struct cputracememory *ctm = &cputrace.ctm[cputrace.memoryoffset++];
@@ -255,6 +279,7 @@ static bool check_trace (void)
 	write_log (L"CPU tracer playback complete. STARTCYCLES=%08x NOWCYCLES=%08x\n", cputrace.startcycles, get_cycles ());
 	cputrace.needendcycles = 1;
 	cpu_tracer = 0;
+	set_tracer_tables ();
 	return true;
 }
 
@@ -806,6 +831,7 @@ static void set_x_funcs (void)
 			x_do_cycles_post = cputracefunc2_x_do_cycles_post;
 		}
 	}
+	set_tracer_tables ();
 }
 
 bool can_cpu_tracer (void)
@@ -844,6 +870,7 @@ static void set_cpu_caches (void)
 
 	regs.prefetch020addr = 0xffffffff;
 	regs.cacheholdingaddr020 = 0xffffffff;
+	decodecache_flush ();
 
 #ifdef JIT
 	if (currprefs.cachesize) {
@@ -909,18 +936,324 @@ STATIC_INLINE void count_instr (unsigned int opcode)
 {
 }
 
+struct decodecache decodecache[DECODECACHE_SIZE];
+bool decodecache_active;
+uae_u32 decodecache_misses, decodecache_invalidates;
+/* host span of everything cached since the last flush */
+uae_u8 *decodecache_lo, *decodecache_hi;
+/* instruction bytes the _d handler of each opcode reads from the entry */
+static uae_u8 decodecache_len[65536];
+/* cpufunctbl has _d handlers, only m68k_run_2dc may call them */
+static bool decodecache_tables;
+static bool want_decodecache (void);
+
+void decodecache_flush (void)
+{
+	int i;
+
+	for (i = 0; i < DECODECACHE_SIZE; i++)
+		decodecache[i].pc_p = NULL;
+	decodecache_lo = (uae_u8*)~(size_t)0;
+	decodecache_hi = NULL;
+}
+
+/* RAM written behind the memory banks, SIMD blits, DMA from disk.
+Only the part that overlaps cached code matters, big ranges check
+each entry once. */
+void decodecache_write_range (uae_u8 *lo, uae_u8 *hi)
+{
+	int i;
+
+	if (lo < decodecache_lo)
+		lo = decodecache_lo;
+	if (hi > decodecache_hi)
+		hi = decodecache_hi;
+	if (lo >= hi)
+		return;
+	if (hi - lo < DECODECACHE_SIZE * 2) {
+		decodecache_write (lo, hi - lo);
+		return;
+	}
+	lo -= DECODECACHE_EXT * 2;
+	for (i = 0; i < DECODECACHE_SIZE; i++) {
+		struct decodecache *dc = &decodecache[i];
+		if (dc->pc_p >= lo && dc->pc_p < hi) {
+			dc->pc_p = NULL;
+			decodecache_invalidates++;
+		}
+	}
+}
+
+void decodecache_stats (void)
+{
+	console_out_f (L"Decode cache: %s, %d entries\n", decodecache_active ? L"active" : L"inactive", DECODECACHE_SIZE);
+	console_out_f (L"Misses %u, invalidates %u\n", decodecache_misses, decodecache_invalidates);
+#ifdef JIT
+	if (currprefs.cachesize) {
+		console_out_f (L"JIT cache: %uk of %dk used, %u segment evictions, %u evicted blocks recompiled\n",
+			get_jitted_size () / 1024, currprefs.cachesize,
+			get_jit_evict_count (), get_jit_recompile_count ());
+	}
+#endif
+}
+
+/* decode the opcode and copy the extension words its _d handler reads */
+static NOINLINE struct decodecache *decodecache_fill (struct decodecache *dc, uae_u8 *p)
+{
+	uae_u16 opcode = get_iword (0);
+	int len = decodecache_len[opcode];
+	int i;
+
+	dc->pc_p = p;
+	dc->opcode = opcode;
+	dc->handler = cpufunctbl[opcode];
+	dc->length = len < 2 ? 2 : len;
+	for (i = 2; i < len; i += 2)
+		dc->ext[(i - 2) >> 1] = get_iword (i);
+	if (p < decodecache_lo)
+		decodecache_lo = p;
+	if (p + dc->length > decodecache_hi)
+		decodecache_hi = p + dc->length;
+	decodecache_misses++;
+	return dc;
+}
+
+STATIC_INLINE struct decodecache *decodecache_get (void)
+{
+	uae_u8 *p = regs.pc_p;
+	struct decodecache *dc = decodecache_slot (p);
+	if (dc->pc_p != p)
+		return decodecache_fill (dc, p);
+	return dc;
+}
+
 static unsigned long REGPARAM2 op_illg_1 (uae_u32 opcode)
 {
 	op_illg (opcode);
 	return 4;
 }
 
-static void build_cpufunctbl (void)
+static void set_cpu_fused (void);
+
+/* instruction pair profiler, gencpu reads the result to generate fused pair handlers */
+#define PAIRPROFILE_SIZE 65536
+struct pairprofile
+{
+	uae_u32 pair;
+	uae_u32 count;
+};
+static struct pairprofile *pairprofile;
+static TCHAR pairprofile_name[MAX_DPATH];
+static uae_u16 pairprofile_prev;
+
+STATIC_INLINE void count_pair (uae_u16 opcode)
+{
+	uae_u32 pair = (pairprofile_prev << 16) | opcode;
+	uae_u32 idx = (pair * 2654435761u) >> 16;
+	int i;
+
+	pairprofile_prev = opcode;
+	for (i = 0; i < 16; i++) {
+		struct pairprofile *pp = &pairprofile[(idx + i) & (PAIRPROFILE_SIZE - 1)];
+		if (pp->count == 0)
+			pp->pair = pair;
+		if (pp->pair == pair) {
+			pp->count++;
+			return;
+		}
+	}
+}
+
+static int pairprofile_cmp (const void *el1, const void *el2)
+{
+	const struct pairprofile *p1 = (const struct pairprofile*)el1;
+	const struct pairprofile *p2 = (const struct pairprofile*)el2;
+	if (p1->count == p2->count)
+		return 0;
+	return p1->count < p2->count ? 1 : -1;
+}
+
+static void pairprofile_write (void)
+{
+	FILE *f;
+	unsigned long total = 0;
+	int i;
+
+	qsort (pairprofile, PAIRPROFILE_SIZE, sizeof (struct pairprofile), pairprofile_cmp);
+	for (i = 0; i < PAIRPROFILE_SIZE; i++)
+		total += pairprofile[i].count;
+	f = _tfopen (pairprofile_name, L"w");
+	if (!f) {
+		write_log (L"Couldn't create '%s'\n", pairprofile_name);
+		return;
+	}
+	fprintf (f, "Total: %lu\n", total);
+	for (i = 0; i < PAIRPROFILE_SIZE && pairprofile[i].count; i++) {
+		uae_u16 op1 = pairprofile[i].pair >> 16;
+		uae_u16 op2 = pairprofile[i].pair;
+		struct mnemolookup *l1, *l2;
+		char *n1, *n2;
+		for (l1 = lookuptab; l1->mnemo != table68k[op1].mnemo; l1++);
+		for (l2 = lookuptab; l2->mnemo != table68k[op2].mnemo; l2++);
+		n1 = ua (l1->name);
+		n2 = ua (l2->name);
+		fprintf (f, "%04x %04x: %lu %s %s\n", op1, op2, (unsigned long)pairprofile[i].count, n1, n2);
+		xfree (n2);
+		xfree (n1);
+	}
+	fclose (f);
+	write_log (L"Instruction pair profile written to '%s'\n", pairprofile_name);
+}
+
+bool pairprofile_enabled (void)
+{
+	return pairprofile != NULL;
+}
+
+/* start profiling, or stop and write the profile if already active */
+bool pairprofile_set (const TCHAR *name)
+{
+	if (pairprofile) {
+		pairprofile_write ();
+		xfree (pairprofile);
+		pairprofile = NULL;
+	} else {
+		_tcscpy (pairprofile_name, name && name[0] ? name : L"frequent_pairs.68k");
+		pairprofile = xcalloc (struct pairprofile, PAIRPROFILE_SIZE);
+		pairprofile_prev = 0;
+	}
+	if (decodecache_tables != want_decodecache ())
+		build_cpufunctbl ();
+	set_cpu_fused ();
+	set_special (SPCFLAG_BRK);
+	return pairprofile != NULL;
+}
+
+static const struct cputbl_fused *fusedtbl;
+static cpuop_func **fused_orig;
+static int fused_active;
+
+/* Fused handlers call do_cycles () between the two instructions, they
+* can't be used if the main loop adjusts returned cycle counts or if
+* JIT or the busy-wait loop detector needs to see each instruction
+* separately.
+*/
+static void set_cpu_fused (void)
+{
+	int i, cnt, enable;
+
+	enable = fusedtbl && fusedtbl[0].handler && !currprefs.cachesize && currprefs.m68k_speed <= 0 && !pairprofile
+		&& !currprefs.cpu_busywait_skip;
+	if (enable == fused_active)
+		return;
+	for (cnt = 0; fusedtbl && fusedtbl[cnt].handler; cnt++);
+	if (enable) {
+		xfree (fused_orig);
+		fused_orig = xmalloc (cpuop_func*, cnt);
+		for (i = 0; i < cnt; i++) {
+			uae_u16 opcode = fusedtbl[i].opcode;
+			fused_orig[i] = cpufunctbl_normal[opcode];
+			if (cpufunctbl_normal[opcode] != op_illg_1 && cpufunctbl_normal[fusedtbl[i].next] != op_illg_1)
+				cpufunctbl_normal[opcode] = fusedtbl[i].handler;
+		}
+		write_log (L"%d fused instruction pairs enabled\n", cnt);
+	} else if (fused_orig) {
+		for (i = 0; i < cnt; i++)
+			cpufunctbl_normal[fusedtbl[i].opcode] = fused_orig[i];
+	}
+	fused_active = enable;
+	decodecache_flush ();
+}
+
+#ifdef CPUEMU_0_L
+/* lazy CZNV tables, interpreter only, JIT reads regflags directly */
+#define CPUTBL(n) (lazy ? op_smalltbl_##n##_l_ff : op_smalltbl_##n##_ff)
+#define FUSEDTBL(n) (lazy ? op_fusedtbl_##n##_l_ff : op_fusedtbl_##n##_ff)
+#else
+#define CPUTBL(n) op_smalltbl_##n##_ff
+#define FUSEDTBL(n) op_fusedtbl_##n##_ff
+#endif
+#ifdef CPUEMU_0_D
+/* generic tables only, decode cache tables have no lazy flags */
+#define GENTBL(n) (decode ? op_smalltbl_##n##_d_ff : CPUTBL(n))
+#define GENFUSEDTBL(n) (decode ? op_fusedtbl_##n##_d_ff : FUSEDTBL(n))
+#else
+#define GENTBL(n) CPUTBL(n)
+#define GENFUSEDTBL(n) FUSEDTBL(n)
+#endif
+
+/* same conditions as m68k_run_2dc selection in m68k_go () */
+static bool want_decodecache (void)
+{
+	return currprefs.cpu_decode_cache && !currprefs.cpu_compatible && !currprefs.cpu_cycle_exact
+		&& !currprefs.cachesize && !currprefs.mmu_model && !currprefs.cpu_busywait_skip && !pairprofile;
+}
+
+/* handlers of tbl and all opcodes merged into them */
+static int fill_cpufunctbl (cpuop_func **ft, uae_u8 *len, const struct cputbl *tbl, const struct cputbl *fputbl, int lvl)
 {
 	int i, opcnt;
 	unsigned long opcode;
-	const struct cputbl *tbl = 0;
+
+	for (opcode = 0; opcode < 65536; opcode++) {
+		ft[opcode] = op_illg_1;
+		if (len)
+			len[opcode] = 0;
+	}
+	for (i = 0; tbl[i].handler != NULL; i++) {
+		opcode = tbl[i].opcode;
+		ft[opcode] = tbl[i].handler;
+		if (len)
+			len[opcode] = tbl[i].length;
+	}
+	if (fputbl) {
+		for (i = 0; fputbl[i].handler != NULL; i++) {
+			if ((fputbl[i].opcode & 0xfe00) == 0xf200) {
+				ft[fputbl[i].opcode] = fputbl[i].handler;
+				if (len)
+					len[fputbl[i].opcode] = 0;
+			}
+		}
+	}
+	opcnt = 0;
+	for (opcode = 0; opcode < 65536; opcode++) {
+		cpuop_func *f;
+
+		if (table68k[opcode].mnemo == i_ILLG)
+			continue;
+		if (fputbl) {
+			/* more hack fpu to 68000/68010 mode */
+			if (table68k[opcode].clev > lvl && (opcode & 0xfe00) != 0xf200)
+				continue;
+		} else if (table68k[opcode].clev > lvl) {
+			continue;
+		}
+
+		if (table68k[opcode].handler != -1) {
+			int idx = table68k[opcode].handler;
+			f = ft[idx];
+			if (f == op_illg_1)
+				abort ();
+			ft[opcode] = f;
+			if (len)
+				len[opcode] = len[idx];
+			opcnt++;
+		}
+	}
+	return opcnt;
+}
+
+static void build_cpufunctbl (void)
+{
+	int opcnt;
+	const struct cputbl *tbl = 0, *fputbl;
+	const struct cputbl_fused *ftbl = NULL;
 	int lvl;
+	bool decode = want_decodecache ();
+	int lazy = currprefs.cpu_lazy_flags && !currprefs.cachesize && !decode;
+
+	/* old handlers may have left CZNV unevaluated */
+	MATERIALIZE_FLAGS ();
 
 	switch (currprefs.cpu_model)
 	{
@@ -928,35 +1261,40 @@ static void build_cpufunctbl (void)
 #ifndef CPUEMU_68000_ONLY
 	case 68060:
 		lvl = 5;
-		tbl = op_smalltbl_0_ff;
+		tbl = GENTBL(0);
+		ftbl = GENFUSEDTBL(0);
 		if (currprefs.cpu_cycle_exact)
-			tbl = op_smalltbl_21_ff;
+			tbl = CPUTBL(21);
 		if (currprefs.mmu_model)
-			tbl = op_smalltbl_31_ff;
+			tbl = CPUTBL(31);
 		break;
 	case 68040:
 		lvl = 4;
-		tbl = op_smalltbl_1_ff;
+		tbl = GENTBL(1);
+		ftbl = GENFUSEDTBL(1);
 		if (currprefs.cpu_cycle_exact)
-			tbl = op_smalltbl_22_ff;
+			tbl = CPUTBL(22);
 		if (currprefs.mmu_model)
-			tbl = op_smalltbl_31_ff;
+			tbl = CPUTBL(31);
 		break;
 	case 68030:
 		lvl = 3;
-		tbl = op_smalltbl_2_ff;
+		tbl = GENTBL(2);
+		ftbl = GENFUSEDTBL(2);
 		if (currprefs.cpu_cycle_exact)
-			tbl = op_smalltbl_23_ff;
+			tbl = CPUTBL(23);
 		break;
 	case 68020:
 		lvl = 2;
-		tbl = op_smalltbl_3_ff;
+		tbl = GENTBL(3);
+		ftbl = GENFUSEDTBL(3);
 		if (currprefs.cpu_cycle_exact)
-			tbl = op_smalltbl_20_ff;
+			tbl = CPUTBL(20);
 		break;
 	case 68010:
 		lvl = 1;
-		tbl = op_smalltbl_4_ff;
+		tbl = GENTBL(4);
+		ftbl = GENFUSEDTBL(4);
 		break;
 #endif
 #endif
@@ -964,14 +1302,15 @@ static void build_cpufunctbl (void)
 		changed_prefs.cpu_model = currprefs.cpu_model = 68000;
 	case 68000:
 		lvl = 0;
-		tbl = op_smalltbl_5_ff;
+		tbl = GENTBL(5);
+		ftbl = GENFUSEDTBL(5);
 #ifdef CPUEMU_11
 		if (currprefs.cpu_compatible)
-			tbl = op_smalltbl_11_ff; /* prefetch */
+			tbl = CPUTBL(11); /* prefetch */
 #endif
 #ifdef CPUEMU_12
 		if (currprefs.cpu_cycle_exact)
-			tbl = op_smalltbl_12_ff; /* prefetch and cycle-exact */
+			tbl = CPUTBL(12); /* prefetch and cycle-exact */
 #endif
 		break;
 	}
@@ -981,44 +1320,22 @@ static void build_cpufunctbl (void)
 		abort ();
 	}
 
-	for (opcode = 0; opcode < 65536; opcode++)
-		cpufunctbl[opcode] = op_illg_1;
-	for (i = 0; tbl[i].handler != NULL; i++) {
-		opcode = tbl[i].opcode;
-		cpufunctbl[opcode] = tbl[i].handler;
-	}
-
 	/* hack fpu to 68000/68010 mode */
-	if (currprefs.fpu_model && currprefs.cpu_model < 68020) {
-		tbl = op_smalltbl_3_ff;
-		for (i = 0; tbl[i].handler != NULL; i++) {
-			if ((tbl[i].opcode & 0xfe00) == 0xf200)
-				cpufunctbl[tbl[i].opcode] = tbl[i].handler;
-		}
-	}
-	opcnt = 0;
-	for (opcode = 0; opcode < 65536; opcode++) {
-		cpuop_func *f;
-
-		if (table68k[opcode].mnemo == i_ILLG)
-			continue;
-		if (currprefs.fpu_model && currprefs.cpu_model < 68020) {
-			/* more hack fpu to 68000/68010 mode */
-			if (table68k[opcode].clev > lvl && (opcode & 0xfe00) != 0xf200)
-				continue;
-		} else if (table68k[opcode].clev > lvl) {
-			continue;
-		}
-
-		if (table68k[opcode].handler != -1) {
-			int idx = table68k[opcode].handler;
-			f = cpufunctbl[idx];
-			if (f == op_illg_1)
-				abort ();
-			cpufunctbl[opcode] = f;
-			opcnt++;
-		}
-	}
+	fputbl = currprefs.fpu_model && currprefs.cpu_model < 68020 ? CPUTBL(3) : NULL;
+	opcnt = fill_cpufunctbl (cpufunctbl_normal, decodecache_len, tbl, fputbl, lvl);
+	decodecache_tables = decode;
+#ifdef CPUEMU_12_T
+	if (can_cpu_tracer ())
+		fill_cpufunctbl (cpufunctbl_tracer, NULL, currprefs.cpu_model == 68000 ? op_smalltbl_12_t_ff : op_smalltbl_20_t_ff, fputbl, lvl);
+#endif
+	set_tracer_tables ();
+
+	/* fused pairs only exist for the plain tables */
+	if (currprefs.cpu_compatible || currprefs.cpu_cycle_exact || currprefs.mmu_model)
+		ftbl = NULL;
+	fusedtbl = ftbl;
+	fused_active = 0;
+	set_cpu_fused ();
 	write_log (L"Building CPU, %d opcodes (%d %d %d)\n",
 		opcnt, lvl,
 		currprefs.cpu_cycle_exact ? -1 : currprefs.cpu_compatible ? 1 : 0, currprefs.address_space_24);
@@ -1089,6 +1406,9 @@ static void prefs_changed_cpu (void)
 	currprefs.fpu_model = changed_prefs.fpu_model;
 	currprefs.mmu_model = changed_prefs.mmu_model;
 	currprefs.cpu_compatible = changed_prefs.cpu_compatible;
+	currprefs.cpu_decode_cache = changed_prefs.cpu_decode_cache;
+	currprefs.cpu_lazy_flags = changed_prefs.cpu_lazy_flags;
+	currprefs.cpu_busywait_skip = changed_prefs.cpu_busywait_skip;
 	currprefs.cpu_cycle_exact = changed_prefs.cpu_cycle_exact;
 	currprefs.blitter_cycle_exact = changed_prefs.cpu_cycle_exact;
 }
@@ -1107,6 +1427,9 @@ void check_prefs_changed_cpu (void)
 		|| currprefs.fpu_model != changed_prefs.fpu_model
 		|| currprefs.mmu_model != changed_prefs.mmu_model
 		|| currprefs.cpu_compatible != changed_prefs.cpu_compatible
+		|| currprefs.cpu_decode_cache != changed_prefs.cpu_decode_cache
+		|| currprefs.cpu_lazy_flags != changed_prefs.cpu_lazy_flags
+		|| currprefs.cpu_busywait_skip != changed_prefs.cpu_busywait_skip
 		|| currprefs.cpu_cycle_exact != changed_prefs.cpu_cycle_exact) {
 
 			prefs_changed_cpu ();
@@ -1122,6 +1445,7 @@ void check_prefs_changed_cpu (void)
 			currprefs.m68k_speed = changed_prefs.m68k_speed;
 			reset_frame_rate_hack ();
 			update_68k_cycles ();
+			set_cpu_fused ();
 			changed = 1;
 	}
 
@@ -1158,9 +1482,9 @@ void init_m68k (void)
 			uae_u32 opcode, count, total;
 			TCHAR name[20];
 			write_log (L"Reading instruction count file...\n");
-			fscanf (f, "Total: %lu\n", &total);
-			while (fscanf (f, "%lx: %lu %s\n", &opcode, &count, name) == 3) {
-				instrcount[opcode] = count;
+			if (fscanf (f, "Total: %lu\n", &total) == 1) {
+				while (fscanf (f, "%lx: %lu %s\n", &opcode, &count, name) == 3 && opcode < 65536)
+					instrcount[opcode] = count;
 			}
 			fclose (f);
 		}
@@ -1185,6 +1509,8 @@ void init_m68k (void)
 		regs.address_space_mask = 0x00ffffff;
 		write_log (L" 24-bit");
 	}
+	if (currprefs.cpu_lazy_flags && !currprefs.cachesize)
+		write_log (L" lazy-flags");
 	write_log (L"\n");
 
 	read_table68k ();
@@ -1206,6 +1532,34 @@ struct regstruct regs, mmu_backup_regs;
 struct flag_struct regflags;
 static long int m68kpc_offset;
 
+/* compute CZNV from operands recorded by the lazy flag handlers */
+void flush_lazy_flags (void)
+{
+	static const uae_u32 masks[] = { 0xff, 0xffff, 0xffffffff, 0xffffffff };
+	uae_u32 lazy = regflags.lazy;
+	uae_u32 mask = masks[lazy & 3];
+	uae_u32 sign = (mask >> 1) + 1;
+	uae_u32 s = regflags.lazy_src & mask;
+	uae_u32 d = regflags.lazy_dst & mask;
+	uae_u32 r = regflags.lazy_res & mask;
+
+	regflags.lazy = 0;
+	CLEAR_CZNV ();
+	SET_ZFLG (r == 0);
+	SET_NFLG (r & sign);
+	switch (lazy >> 2)
+	{
+	case FLAGOP_ADD:
+		SET_VFLG ((s ^ r) & (d ^ r) & sign);
+		SET_CFLG (s > (~d & mask));
+		break;
+	case FLAGOP_SUB:
+		SET_VFLG ((s ^ d) & (r ^ d) & sign);
+		SET_CFLG (s > d);
+		break;
+	}
+}
+
 #define get_ibyte_1(o) get_byte (regs.pc + (regs.pc_p - regs.pc_oldp) + (o) + 1)
 #define get_iword_1(o) get_word (regs.pc + (regs.pc_p - regs.pc_oldp) + (o))
 #define get_ilong_1(o) get_long (regs.pc + (regs.pc_p - regs.pc_oldp) + (o))
@@ -2519,10 +2873,26 @@ int m68k_move2c (int regno, uae_u32 *regp)
 			break;
 
 			/* no differences between 68040 and 68060 */
-		case 4: regs.itt0 = *regp & 0xffffe364; break;
-		case 5: regs.itt1 = *regp & 0xffffe364; break;
-		case 6: regs.dtt0 = *regp & 0xffffe364; break;
-		case 7: regs.dtt1 = *regp & 0xffffe364; break;
+		case 4:
+			regs.itt0 = *regp & 0xffffe364;
+			if (currprefs.mmu_model)
+				mmu_tt_modified ();
+			break;
+		case 5:
+			regs.itt1 = *regp & 0xffffe364;
+			if (currprefs.mmu_model)
+				mmu_tt_modified ();
+			break;
+		case 6:
+			regs.dtt0 = *regp & 0xffffe364;
+			if (currprefs.mmu_model)
+				mmu_tt_modified ();
+			break;
+		case 7:
+			regs.dtt1 = *regp & 0xffffe364;
+			if (currprefs.mmu_model)
+				mmu_tt_modified ();
+			break;
 			/* 68060 only */
 		case 8: regs.buscr = *regp & 0xf0000000; break;
 
@@ -4007,6 +4377,303 @@ static void m68k_run_2p (void)
 	}
 }
 
+/* Register-only delay loops.
+
+   DBcc.W Dn,* and SUBQ #1,Dn + BNE.S back to the SUBQ only change one data
+   register and the flags. Run as many iterations as fit before the next
+   event in one step and charge their cycles with do_cycles (), timing stays
+   the same as if they had been executed one by one.  */
+
+static int delayloop_count (uae_u32 left, int cycles)
+{
+	long avail;
+
+	if (regs.spcflags || !cycles_mask || cycles <= 0)
+		return 0;
+	avail = ((long)(nextevent - get_cycles ()) - 1) / cycles;
+	if (avail <= 0)
+		return 0;
+	return (uae_u32)avail < left ? avail : left;
+}
+
+/* DBcc.W Dn,* branch taken, Dn already decremented */
+void delayloop_dbcc (int reg, int cycles)
+{
+	uae_u32 v = m68k_dreg (regs, reg) & 0xffff;
+	int n = delayloop_count (v, cycles);
+
+	if (n <= 0)
+		return;
+	m68k_dreg (regs, reg) = (m68k_dreg (regs, reg) & ~0xffff) | (v - n);
+	do_cycles (n * cycles);
+}
+
+/* BNE.S back to SUBQ #1,Dn taken, pc points to the SUBQ */
+void delayloop_subq (uaecptr pc, int cycles)
+{
+	addrbank *ab = &get_mem_bank (pc);
+	uae_u32 mask, v, sign;
+	uae_u16 opcode;
+	int reg, n;
+
+	if (ab->flags != ABFLAG_RAM && ab->flags != ABFLAG_ROM)
+		return;
+	opcode = get_word (pc);
+	if (!IS_DELAYLOOP_SUBQ (opcode))
+		return;
+	reg = opcode & 7;
+	switch ((opcode >> 6) & 3)
+	{
+	case 0:
+		mask = 0xff;
+		cycles += 4 * CYCLE_UNIT / 2;
+		break;
+	case 1:
+		mask = 0xffff;
+		cycles += 4 * CYCLE_UNIT / 2;
+		break;
+	default:
+		mask = 0xffffffff;
+		cycles += 8 * CYCLE_UNIT / 2;
+		break;
+	}
+	/* leave the final iteration that reaches zero to the normal code */
+	v = m68k_dreg (regs, reg) & mask;
+	n = delayloop_count (v - 1, cycles);
+	if (n <= 0)
+		return;
+	v -= n;
+	sign = (mask >> 1) + 1;
+	m68k_dreg (regs, reg) = (m68k_dreg (regs, reg) & ~mask) | v;
+	/* flags of the last skipped SUBQ: (v + 1) - 1 */
+	CLEAR_CZNV ();
+	SET_NFLG ((v & sign) != 0);
+	SET_VFLG (v + 1 == sign);
+	COPY_CARRY ();
+	do_cycles (n * cycles);
+}
+
+/* Busy-wait loop skipping.
+
+   A short backward branch marks a loop candidate. The loop body is accepted
+   if it only contains side effect free instructions that write data
+   registers or flags and only reads memory or custom/CIA registers that
+   can't change until the next event fires. If two consecutive iterations
+   start with identical register state and take identical time, all remaining
+   iterations until the next event would do exactly the same thing, so time is
+   simply advanced to just before the event. Iteration time is taken from
+   get_cycles (), so CIA E-clock waits and other do_cycles () calls made by
+   the handlers are included. Fused instruction pairs are never installed
+   while cpu_busywait_skip is set, see set_cpu_fused ().  */
+
+#define BUSYWAIT_MAXLEN 32
+
+static struct {
+	uaecptr head, tail;
+	bool ok, valid;
+	unsigned long start, itercycles;
+	uae_u32 aregs[8];
+	uae_u32 regs[16];
+	uae_u32 cznv, x;
+} busywait;
+
+static bool busywait_custom_ok (uaecptr addr, int size)
+{
+	if (size == sz_long)
+		return busywait_custom_ok (addr, sz_word) && busywait_custom_ok (addr + 2, sz_word);
+	switch (addr & 0x1fe)
+	{
+	case 0x002: /* DMACONR */
+	case 0x004: /* VPOSR */
+	case 0x00a: /* JOY0DAT */
+	case 0x00c: /* JOY1DAT */
+	case 0x010: /* ADKCONR */
+	case 0x016: /* POTGOR */
+	case 0x01c: /* INTENAR */
+	case 0x01e: /* INTREQR */
+		return true;
+	case 0x006: /* VHPOSR, vertical position byte only */
+		return size == sz_byte && !(addr & 1);
+	}
+	return false;
+}
+
+static bool busywait_read_ok (uaecptr addr, int size)
+{
+	addrbank *ab = &get_mem_bank (addr);
+
+	if (ab->flags == ABFLAG_RAM || ab->flags == ABFLAG_ROM)
+		return true;
+	if ((addr & ~0x1ff) == 0xdff000)
+		return busywait_custom_ok (addr, size);
+	if (ab == &cia_bank && size == sz_byte) {
+		int reg = (addr >> 8) & 15;
+		/* PRA and PRB only, reading ICR acknowledges interrupts and
+		timers and TOD latch change on every read */
+		return reg == 0 || reg == 1;
+	}
+	return false;
+}
+
+static bool busywait_ea (uaecptr pc, int *len, int mode, int reg, int size)
+{
+	uaecptr addr;
+
+	switch (mode)
+	{
+	case Dreg:
+	case Areg:
+	case immi:
+		return true;
+	case imm:
+		*len += size == sz_long ? 4 : 2;
+		return true;
+	case imm0:
+	case imm1:
+		*len += 2;
+		return true;
+	case imm2:
+		*len += 4;
+		return true;
+	case Aind:
+		addr = m68k_areg (regs, reg);
+		break;
+	case Ad16:
+		addr = m68k_areg (regs, reg) + (uae_s16)get_word (pc + *len);
+		*len += 2;
+		break;
+	case absw:
+		addr = (uae_s32)(uae_s16)get_word (pc + *len);
+		*len += 2;
+		break;
+	case absl:
+		addr = get_long (pc + *len);
+		*len += 4;
+		break;
+	case PC16:
+		addr = pc + *len + (uae_s16)get_word (pc + *len);
+		*len += 2;
+		break;
+	default:
+		return false;
+	}
+	return busywait_read_ok (addr, size);
+}
+
+static bool busywait_scan (uaecptr head, uaecptr tail)
+{
+	uaecptr pc = head;
+	addrbank *ab = &get_mem_bank (head);
+
+	if (ab->flags != ABFLAG_RAM && ab->flags != ABFLAG_ROM)
+		return false;
+	if (&get_mem_bank (tail) != ab)
+		return false;
+	while (pc < tail) {
+		uae_u16 opcode = get_word (pc);
+		struct instr *dp = table68k + opcode;
+		int len = 2;
+
+		switch (dp->mnemo)
+		{
+		case i_MOVE:
+		case i_AND:
+		case i_OR:
+		case i_EOR:
+		case i_SWAP:
+		case i_EXT:
+		case i_ASR: case i_ASL: case i_LSR: case i_LSL:
+		case i_ROL: case i_ROR: case i_ROXL: case i_ROXR:
+			if ((dp->duse ? dp->dmode : dp->smode) != Dreg)
+				return false;
+			break;
+		case i_TST:
+		case i_CMP:
+		case i_CMPA:
+		case i_BTST:
+		case i_NOP:
+			break;
+		case i_Bcc:
+			len += (opcode & 0xff) == 0 ? 2 : ((opcode & 0xff) == 0xff ? 4 : 0);
+			pc += len;
+			continue;
+		default:
+			return false;
+		}
+		if (dp->suse && !busywait_ea (pc, &len, dp->smode, dp->sreg, dp->size))
+			return false;
+		if (dp->duse && !busywait_ea (pc, &len, dp->dmode, dp->dreg, dp->size))
+			return false;
+		pc += len;
+	}
+	/* must end exactly at the branch that jumped back */
+	return pc == tail && table68k[get_word (tail)].mnemo == i_Bcc;
+}
+
+static void busywait_loop (uaecptr head, uaecptr tail)
+{
+	unsigned long now = get_cycles ();
+	unsigned long cycles = now - busywait.start;
+
+	busywait.start = now;
+	if (head != busywait.head || tail != busywait.tail || memcmp (busywait.aregs, regs.regs + 8, sizeof busywait.aregs)) {
+		busywait.head = head;
+		busywait.tail = tail;
+		memcpy (busywait.aregs, regs.regs + 8, sizeof busywait.aregs);
+		busywait.ok = busywait_scan (head, tail);
+		busywait.valid = false;
+		return;
+	}
+	if (!busywait.ok || !cycles || regs.spcflags) {
+		busywait.valid = false;
+		return;
+	}
+	if (busywait.valid && cycles == busywait.itercycles
+		&& busywait.cznv == GET_CZNV () && busywait.x == GET_XFLG ()
+		&& !memcmp (busywait.regs, regs.regs, sizeof busywait.regs)) {
+			unsigned long left = nextevent - now;
+			unsigned long n = left > cycles ? (left - 1) / cycles : 0;
+			if (n > 0) {
+				do_cycles (n * cycles);
+				busywait.start = get_cycles ();
+			}
+			return;
+	}
+	memcpy (busywait.regs, regs.regs, sizeof busywait.regs);
+	busywait.cznv = GET_CZNV ();
+	busywait.x = GET_XFLG ();
+	busywait.itercycles = cycles;
+	busywait.valid = true;
+}
+
+/* m68k_run_2 with busy-wait loop skipping */
+static void m68k_run_2i (void)
+{
+	struct regstruct *r = &regs;
+	uaecptr lastpc = 0;
+
+	busywait.head = busywait.tail = 0;
+	busywait.start = get_cycles ();
+	for (;;) {
+		uaecptr pc = r->instruction_pc = m68k_getpc ();
+
+		do_cycles (cpu_cycles);
+		if (pc < lastpc && lastpc - pc <= BUSYWAIT_MAXLEN)
+			busywait_loop (pc, lastpc);
+		lastpc = pc;
+		uae_u16 opcode = get_iword (0);
+		count_instr (opcode);
+		cpu_cycles = (*cpufunctbl[opcode])(opcode);
+		cpu_cycles &= cycles_mask;
+		cpu_cycles |= cycles_val;
+		if (r->spcflags) {
+			busywait.head = 0;
+			if (do_specialties (cpu_cycles))
+				return;
+		}
+	}
+}
+
 //static int used[65536];
 
 /* Same thing, but don't use prefetch to get opcode.  */
@@ -4039,6 +4706,50 @@ static void m68k_run_2 (void)
 	}
 }
 
+/* m68k_run_2 with instruction pair profiling */
+static void m68k_run_2_profile (void)
+{
+	struct regstruct *r = &regs;
+
+	for (;;) {
+		r->instruction_pc = m68k_getpc ();
+		uae_u16 opcode = get_iword (0);
+		count_pair (opcode);
+		do_cycles (cpu_cycles);
+		cpu_cycles = (*cpufunctbl[opcode])(opcode);
+		cpu_cycles &= cycles_mask;
+		cpu_cycles |= cycles_val;
+		if (r->spcflags) {
+			if (do_specialties (cpu_cycles))
+				return;
+		}
+	}
+}
+
+/* m68k_run_2 using pre-decoded instruction cache */
+static void m68k_run_2dc (void)
+{
+	struct regstruct *r = &regs;
+
+	for (;;) {
+		struct decodecache *dc = decodecache_get ();
+		uae_u16 opcode = dc->opcode;
+
+		r->instruction_pc = m68k_getpc ();
+		r->dc_ext = dc->ext;
+		count_instr (opcode);
+
+		do_cycles (cpu_cycles);
+		cpu_cycles = (*dc->handler)(opcode);
+		cpu_cycles &= cycles_mask;
+		cpu_cycles |= cycles_val;
+		if (r->spcflags) {
+			if (do_specialties (cpu_cycles))
+				return;
+		}
+	}
+}
+
 /* fake MMU 68k  */
 static void m68k_run_mmu (void)
 {
@@ -4206,8 +4917,17 @@ void m68k_go (int may_quit)
 #endif
 				(currprefs.cpu_model == 68040 || currprefs.cpu_model == 68060) && currprefs.mmu_model ? m68k_run_mmu040 :
 				currprefs.cpu_model >= 68020 && currprefs.cpu_cycle_exact ? m68k_run_2ce :
+				decodecache_tables ? m68k_run_2dc :
+				pairprofile && !currprefs.cpu_compatible ? m68k_run_2_profile :
+				currprefs.cpu_busywait_skip && !currprefs.cpu_compatible ? m68k_run_2i :
 				currprefs.cpu_compatible ? m68k_run_2p : m68k_run_2;
 		}
+		if (decodecache_active != (run_func == m68k_run_2dc)) {
+			decodecache_active = run_func == m68k_run_2dc;
+			decodecache_flush ();
+			if (decodecache_active)
+				write_log (L"CPU decode cache enabled\n");
+		}
 		run_func ();
 	}
 	in_m68k_go--;
@@ -5634,8 +6354,14 @@ uae_u32 get_word_ce030_prefetch (int o)
 	}
 }
 
+/* RAM was written directly (DMA, host side file system), not only
+the 030 data cache but everything that caches code must forget it */
 void flush_dcache (uaecptr addr, int size)
 {
+	if (size > 0 && valid_address (addr, size)) {
+		uae_u8 *p = get_real_address (addr);
+		decodecache_write_range (p, p + size);
+	}
 	if (!currprefs.cpu_cycle_exact)
 		return;
 	if (currprefs.cpu_model >= 68030) {
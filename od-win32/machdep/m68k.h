@@ -13,6 +13,11 @@
 struct flag_struct {
     unsigned int cznv;
     unsigned int x;
+    /* deferred CZNV state, see SET_LAZY_FLAGS */
+    unsigned int lazy;
+    unsigned int lazy_src;
+    unsigned int lazy_dst;
+    unsigned int lazy_res;
 };
 
 extern struct flag_struct regflags;
@@ -43,24 +48,47 @@ extern struct flag_struct regflags;
 #define FLAGVAL_V	(1 << FLAGBIT_V)
 #define FLAGVAL_X	(1 << FLAGBIT_X)
 
-#define SET_ZFLG(y)	(regflags.cznv = (regflags.cznv & ~FLAGVAL_Z) | (((y) ? 1 : 0) << FLAGBIT_Z))
-#define SET_CFLG(y)	(regflags.cznv = (regflags.cznv & ~FLAGVAL_C) | (((y) ? 1 : 0) << FLAGBIT_C))
-#define SET_VFLG(y)	(regflags.cznv = (regflags.cznv & ~FLAGVAL_V) | (((y) ? 1 : 0) << FLAGBIT_V))
-#define SET_NFLG(y)	(regflags.cznv = (regflags.cznv & ~FLAGVAL_N) | (((y) ? 1 : 0) << FLAGBIT_N))
+/*
+ * Lazy CZNV evaluation (the "_l" interpreter tables).
+ *
+ * ADD, SUB, CMP and logical ops only record operation, size and
+ * operands; CZNV is computed by flush_lazy_flags() when something
+ * actually reads the flags. X is always kept up to date.
+ * lazy field: bits 0-1 = size (0=byte,1=word,2=long), bits 2- = FLAGOP_x
+ */
+#define FLAGOP_LOGICAL	1
+#define FLAGOP_ADD	2
+#define FLAGOP_SUB	3
+
+extern void flush_lazy_flags (void);
+
+#define SET_LAZY_FLAGS(op,size,s,d,r) (regflags.lazy = ((op) << 2) | (size), \
+	regflags.lazy_src = (s), regflags.lazy_dst = (d), regflags.lazy_res = (r))
+#ifdef CPU_NOLAZYFLAGS
+/* regular generated handlers, tables are only switched with CZNV evaluated */
+#define MATERIALIZE_FLAGS() ((void)0)
+#else
+#define MATERIALIZE_FLAGS() (regflags.lazy ? flush_lazy_flags () : (void)0)
+#endif
+
+#define SET_ZFLG(y)	(MATERIALIZE_FLAGS (), regflags.cznv = (regflags.cznv & ~FLAGVAL_Z) | (((y) ? 1 : 0) << FLAGBIT_Z))
+#define SET_CFLG(y)	(MATERIALIZE_FLAGS (), regflags.cznv = (regflags.cznv & ~FLAGVAL_C) | (((y) ? 1 : 0) << FLAGBIT_C))
+#define SET_VFLG(y)	(MATERIALIZE_FLAGS (), regflags.cznv = (regflags.cznv & ~FLAGVAL_V) | (((y) ? 1 : 0) << FLAGBIT_V))
+#define SET_NFLG(y)	(MATERIALIZE_FLAGS (), regflags.cznv = (regflags.cznv & ~FLAGVAL_N) | (((y) ? 1 : 0) << FLAGBIT_N))
 #define SET_XFLG(y)	(regflags.x    = ((y) ? 1 : 0) << FLAGBIT_X)
 
-#define GET_ZFLG()	((regflags.cznv >> FLAGBIT_Z) & 1)
-#define GET_CFLG()	((regflags.cznv >> FLAGBIT_C) & 1)
-#define GET_VFLG()	((regflags.cznv >> FLAGBIT_V) & 1)
-#define GET_NFLG()	((regflags.cznv >> FLAGBIT_N) & 1)
+#define GET_ZFLG()	(MATERIALIZE_FLAGS (), (regflags.cznv >> FLAGBIT_Z) & 1)
+#define GET_CFLG()	(MATERIALIZE_FLAGS (), (regflags.cznv >> FLAGBIT_C) & 1)
+#define GET_VFLG()	(MATERIALIZE_FLAGS (), (regflags.cznv >> FLAGBIT_V) & 1)
+#define GET_NFLG()	(MATERIALIZE_FLAGS (), (regflags.cznv >> FLAGBIT_N) & 1)
 #define GET_XFLG()	((regflags.x    >> FLAGBIT_X) & 1)
 
-#define CLEAR_CZNV()	(regflags.cznv  = 0)
-#define GET_CZNV()	(regflags.cznv)
-#define IOR_CZNV(X)	(regflags.cznv |= (X))
-#define SET_CZNV(X)	(regflags.cznv  = (X))
+#define CLEAR_CZNV()	(regflags.lazy = 0, regflags.cznv  = 0)
+#define GET_CZNV()	(MATERIALIZE_FLAGS (), regflags.cznv)
+#define IOR_CZNV(X)	(MATERIALIZE_FLAGS (), regflags.cznv |= (X))
+#define SET_CZNV(X)	(regflags.lazy = 0, regflags.cznv  = (X))
 
-#define COPY_CARRY() (regflags.x = regflags.cznv)
+#define COPY_CARRY() (MATERIALIZE_FLAGS (), regflags.x = regflags.cznv)
 
 
 /*
@@ -68,7 +96,20 @@ extern struct flag_struct regflags;
  */
 STATIC_INLINE int cctrue (int cc)
 {
-    uae_u32 cznv = regflags.cznv;
+    uae_u32 cznv;
+
+#ifndef CPU_NOLAZYFLAGS
+    if (regflags.lazy) {
+	/* EQ/NE straight from the deferred result, anything else needs CZNV */
+	if (cc == 6 || cc == 7) {
+	    static const uae_u32 masks[] = { 0xff, 0xffff, 0xffffffff, 0xffffffff };
+	    int z = (regflags.lazy_res & masks[regflags.lazy & 3]) == 0;
+	    return cc == 7 ? z : !z;
+	}
+	flush_lazy_flags ();
+    }
+#endif
+    cznv = regflags.cznv;
 
     switch (cc) {
 	case 0:  return 1;								/*				T  */
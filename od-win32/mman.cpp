@@ -24,6 +24,13 @@ static uae_u8 *p96mem_offset;
 static int p96mem_size;
 static SYSTEM_INFO si;
 int maxmem;
+#ifdef JIT
+/* Writes to natmem are watched so that the JIT only rechecks blocks on pages that changed */
+static DWORD natmem_reserve = MEM_RESERVE | MEM_WRITE_WATCH;
+#else
+static DWORD natmem_reserve = MEM_RESERVE;
+#endif
+static uae_u32 natmem_watch_size;
 
 static uae_u8 *virtualallocwithlock (LPVOID addr, SIZE_T size, DWORD allocationtype, DWORD protect)
 {
@@ -35,6 +42,25 @@ static void virtualfreewithlock (LPVOID addr, SIZE_T size, DWORD freetype)
 	VirtualFree(addr, size, freetype);
 }
 
+#ifdef CPU_64_BIT
+/* The JIT addresses Amiga memory with 32-bit registers, so the natmem
+* area must end below 4G. Windows never hands out low addresses on its
+* own on 64-bit, walk the low area manually instead. */
+static uae_u8 *virtualalloc_low (SIZE_T size, DWORD allocationtype, DWORD protect)
+{
+	uae_u8 *p;
+	uae_u64 addr;
+
+	for (addr = 0x10000000; addr + size <= 0x100000000ULL; addr += 0x01000000) {
+		p = (uae_u8*)VirtualAlloc ((LPVOID)addr, size, allocationtype, protect);
+		if (p)
+			return p;
+	}
+	write_log (L"NATMEM: %dM area did not fit below 4G, JIT direct memory access disabled\n", (int)(size >> 20));
+	return (uae_u8*)VirtualAlloc (NULL, size, allocationtype, protect);
+}
+#endif
+
 void cache_free (uae_u8 *cache)
 {
 	virtualfreewithlock (cache, 0, MEM_RELEASE);
@@ -99,6 +125,24 @@ void mman_ResetWatch (PVOID lpBaseAddress, SIZE_T dwRegionSize)
 		write_log (L"ResetWriteWatch() failed, %d\n", GetLastError ());
 }
 
+/* Natmem pages written since the previous call. Only the first size bytes
+* are watched, P96 RAM has its own watch. Returns -1 if not watched or if
+* more than maxpages pages were written. */
+int mman_GetNatmemWrites (uae_u8 **pages, int maxpages, uae_u32 *size)
+{
+	ULONG_PTR cnt = maxpages;
+	ULONG ps;
+
+	*size = natmem_watch_size;
+	if (!natmem_watch_size)
+		return -1;
+	if (GetWriteWatch (WRITE_WATCH_FLAG_RESET, natmem_offset, natmem_watch_size, (PVOID*)pages, &cnt, &ps))
+		return -1;
+	if (cnt >= maxpages)
+		return -1;
+	return cnt;
+}
+
 static uae_u64 size64;
 typedef BOOL (CALLBACK* GLOBALMEMORYSTATUSEX)(LPMEMORYSTATUSEX);
 
@@ -200,6 +244,10 @@ int init_shm (void)
 	uae_u32 rtgbarrier, z3chipbarrier, rtgextra;
 	int rounds = 0;
 
+#ifdef JIT
+	/* an earlier init_shm may have dropped it */
+	natmem_reserve |= MEM_WRITE_WATCH;
+#endif
 restart:
 	for (;;) {
 		int lowround = 0;
@@ -211,6 +259,7 @@ restart:
 			VirtualFree (natmem_offset, 0, MEM_RELEASE);
 		natmem_offset = NULL;
 		natmem_offset_end = NULL;
+		natmem_watch_size = 0;
 		canbang = 0;
 
 		z3size = 0;
@@ -250,11 +299,21 @@ restart:
 			rtgbarrier = 0;
 			rtgextra = 0;
 		}
-		blah = (uae_u8*)VirtualAlloc (NULL, natmemsize + rtgbarrier + z3chipbarrier + currprefs.gfxmem_size + rtgextra + 16 * si.dwPageSize, MEM_RESERVE, PAGE_READWRITE);
+#ifdef CPU_64_BIT
+		blah = virtualalloc_low (natmemsize + rtgbarrier + z3chipbarrier + currprefs.gfxmem_size + rtgextra + 16 * si.dwPageSize, natmem_reserve, PAGE_READWRITE);
+#else
+		blah = (uae_u8*)VirtualAlloc (NULL, natmemsize + rtgbarrier + z3chipbarrier + currprefs.gfxmem_size + rtgextra + 16 * si.dwPageSize, natmem_reserve, PAGE_READWRITE);
+#endif
 		if (blah) {
 			natmem_offset = blah;
 			break;
 		}
+		if ((natmem_reserve & MEM_WRITE_WATCH) && GetLastError () == ERROR_INVALID_PARAMETER) {
+			write_log (L"NATMEM: write watch not supported\n");
+			natmem_reserve &= ~MEM_WRITE_WATCH;
+			rounds--;
+			continue;
+		}
 		write_log (L"NATMEM: %dM area failed to allocate, err=%d (Z3=%dM,RTG=%dM)\n",
 			natmemsize >> 20, GetLastError (), (currprefs.z3fastmem_size + currprefs.z3fastmem2_size + currprefs.z3chipmem_size) >> 20, currprefs.gfxmem_size >> 20);
 		if (!lowmem ()) {
@@ -265,7 +324,7 @@ restart:
 	p96mem_size = currprefs.gfxmem_size;
 	if (p96mem_size) {
 		VirtualFree (natmem_offset, 0, MEM_RELEASE);
-		if (!VirtualAlloc (natmem_offset, natmemsize + rtgbarrier + z3chipbarrier, MEM_RESERVE, PAGE_READWRITE)) {
+		if (!VirtualAlloc (natmem_offset, natmemsize + rtgbarrier + z3chipbarrier, natmem_reserve, PAGE_READWRITE)) {
 			write_log (L"VirtualAlloc() part 2 error %d. RTG disabled.\n", GetLastError ());
 			currprefs.gfxmem_size = changed_prefs.gfxmem_size = 0;
 			rtgbarrier = si.dwPageSize;
@@ -291,7 +350,12 @@ restart:
 			p96mem_offset, (uae_u8*)p96mem_offset + currprefs.gfxmem_size,
 			currprefs.gfxmem_size, currprefs.gfxmem_size >> 20);
 		canbang = 1;
-		natmem_offset_end = p96mem_offset + currprefs.gfxmem_size;
+		if (natmem_reserve & MEM_WRITE_WATCH)
+			natmem_watch_size = natmemsize;
+		if (p96mem_offset && currprefs.gfxmem_size)
+			natmem_offset_end = p96mem_offset + currprefs.gfxmem_size;
+		else
+			natmem_offset_end = natmem_offset + natmemsize;
 	}
 
 	resetmem ();
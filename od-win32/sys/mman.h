@@ -34,6 +34,7 @@ int shmdt (const void *shmaddr);
 int shmget (key_t key, size_t size, int shmflg, const TCHAR*);
 int shmctl (int shmid, int cmd, struct shmid_ds *buf);
 int init_shm (void);
+int mman_GetNatmemWrites (uae_u8 **pages, int maxpages, uae_u32 *size);
 
 #define PROT_READ  0x01
 #define PROT_WRITE 0x02
@@ -34,6 +34,7 @@
 #define CD32 /* CD32 emulation */
 #define CDTV /* CDTV emulation */
 #define D3D /* D3D display filter support */
+#define RENDER_THREADS /* multithreaded line drawing */
 //#define OPENGL /* OpenGL display filter support */
 #define PARALLEL_PORT /* parallel port emulation */
 #define PARALLEL_DIRECT /* direct parallel port emulation */
@@ -51,6 +52,15 @@
 #define CPUEMU_20 /* 68020 "cycle-exact" + blitter */
 #define CPUEMU_21 /* 68030 (040/060) "cycle-exact" + blitter */
 #define CPUEMU_31 /* 68040 Aranym MMU */
+#define CPUEMU_12_T /* CPU tracer variants of 12 and 20 */
+#define CPUEMU_20_T
+#define CPUEMU_0_L /* lazy CZNV variants of the above */
+#define CPUEMU_11_L
+#define CPUEMU_12_L
+#define CPUEMU_20_L
+#define CPUEMU_21_L
+#define CPUEMU_31_L
+#define CPUEMU_0_D /* generic tables for the decode cache loop */
 #define ACTION_REPLAY /* Action Replay 1/2/3 support */
 #define PICASSO96 /* Picasso96 display card emulation */
 #define UAEGFX_INTERNAL /* built-in libs:picasso96/uaegfx.card */
@@ -102,7 +112,6 @@
 
 #ifdef WIN64
 #undef X86_MSVC_ASSEMBLY
-#undef JIT
 #define X64_MSVC_ASSEMBLY
 #define CPU_64_BIT
 #define SIZEOF_VOID_P 8
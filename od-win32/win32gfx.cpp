@@ -1944,6 +1944,7 @@ int graphics_setup (void)
 
 void graphics_leave (void)
 {
+	drawing_free ();
 	close_windows ();
 }
 
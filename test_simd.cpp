@@ -0,0 +1,213 @@
+/*
+* UAE - The Un*x Amiga Emulator
+*
+* Standalone check of the SSE2/AVX2 planar to chunky conversion (p2c.h)
+* and blitter area fill (blitfill.h) against the scalar code.
+*
+* Not part of the emulator build, compile it on its own with the emulator
+* include directories, for example
+*   cl /O2 /I od-win32 /I include test_simd.cpp
+*   g++ -O2 -I od-win32 -I include -o test_simd test_simd.cpp
+*/
+
+#include "sysconfig.h"
+#include "sysdeps.h"
+
+#include "blitter.h"
+
+#if defined (HAVE_SSE2_INTRINSICS) && defined (_MSC_VER)
+#include <intrin.h>
+#endif
+
+static uae_u8 *real_bplpt[8];
+
+#include "p2c.h"
+#include "blitfill.h"
+
+static int verbose = 1;
+static unsigned long n_all_tests, n_all_failures;
+static uae_u32 seed = 0x12345678;
+
+static uae_u32 rnd (void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static int simd_level (void)
+{
+#if defined (HAVE_SSE2_INTRINSICS) && defined (__GNUC__)
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2"))
+		return HOST_SIMD_AVX2;
+	return __builtin_cpu_supports ("sse2") ? HOST_SIMD_SSE2 : 0;
+#elif defined (HAVE_SSE2_INTRINSICS)
+	int r1[4], r7[4];
+	__cpuid (r1, 1);
+	__cpuidex (r7, 7, 0);
+	if ((r1[2] & (1 << 27)) && (r1[2] & (1 << 28)) && (_xgetbv (0) & 6) == 6 && (r7[1] & (1 << 5)))
+		return HOST_SIMD_AVX2;
+	return (r1[3] & (1 << 26)) ? HOST_SIMD_SSE2 : 0;
+#else
+	return 0;
+#endif
+}
+
+#define P2C_MAXWORDS 80
+
+/* every plane count, every word count up to P2C_MAXWORDS so that the
+   AVX2 (8 words), SSE2 (4 words) and scalar tails all get used, plane
+   pointers at long and word alignment */
+static void test_p2c (const pfield_doline_func *funcs, const char *name)
+{
+	static uae_u8 planes[8][P2C_MAXWORDS * 4 + 2];
+	static uae_u32 out1[P2C_MAXWORDS * 8], out2[P2C_MAXWORDS * 8];
+	uae_u8 *end1[8];
+	unsigned long n_tests = 0, n_failures = 0;
+	int i, n, count, align, pass;
+
+	printf ("Testing planar to chunky %s ...", name);
+	for (pass = 0; pass < 4; pass++) {
+		for (i = 0; i < 8; i++) {
+			for (n = 0; n < (int)sizeof planes[i]; n++)
+				planes[i][n] = rnd ();
+		}
+		for (n = 1; n < 9; n++) {
+			if (!pfield_doline_scalar[n])
+				continue;
+			for (align = 0; align <= 2; align += 2) {
+				for (count = 0; count <= P2C_MAXWORDS; count++) {
+					memset (out1, 0x55, sizeof out1);
+					memset (out2, 0xaa, sizeof out2);
+					for (i = 0; i < 8; i++)
+						real_bplpt[i] = planes[i] + align;
+					pfield_doline_scalar[n] (out1, count);
+					memcpy (end1, real_bplpt, sizeof end1);
+					for (i = 0; i < 8; i++)
+						real_bplpt[i] = planes[i] + align;
+					funcs[n] (out2, count);
+					n_tests++;
+					if (memcmp (out1, out2, count * 32) || memcmp (end1, real_bplpt, sizeof end1)) {
+						if (verbose)
+							printf ("\n planes=%d words=%d align=%d: mismatch", n, count, align);
+						n_failures++;
+					}
+				}
+			}
+		}
+	}
+	printf (" done %ld/%ld\n", n_tests - n_failures, n_tests);
+	n_all_tests += n_tests;
+	n_all_failures += n_failures;
+}
+
+#ifdef BLITTER_SIMD
+
+#define FILL_MAXLINES 21
+#define FILL_MAXWORDS 9
+#define FILL_MAXMOD 4
+#define FILL_SIZE (FILL_MAXLINES * (FILL_MAXWORDS + FILL_MAXMOD) * 2)
+
+/* same as blitter_fill_area () with blitter_fill_word () only */
+static int fill_generic (uae_u8 *p, int lines, int words, int wordstep, int linestep, int ife, int fci,
+	uae_u16 *lastd, int *lastfc)
+{
+	int ifemode = ife ? 2 : 0;
+	int fc = fci, nz = 0;
+	uae_u16 d = *lastd;
+	int i, j;
+
+	for (j = 0; j < lines; j++) {
+		uae_u8 *q = p + j * linestep;
+		fc = fci;
+		for (i = 0; i < words; i++, q += wordstep) {
+			d = blitter_fill_word (do_get_mem_word ((uae_u16*)q), ifemode, &fc);
+			do_put_mem_word ((uae_u16*)q, d);
+			nz |= d;
+		}
+	}
+	*lastd = d;
+	*lastfc = fc;
+	return nz;
+}
+
+/* exclusive and inclusive fill, FCI set and clear, ascending and
+   descending, with and without D modulo, line counts that leave 0-7
+   lines for the scalar tail */
+static void test_fill (void)
+{
+	static uae_u8 buf1[FILL_SIZE], buf2[FILL_SIZE];
+	unsigned long n_tests = 0, n_failures = 0;
+	int lines, words, mod, ife, fci, desc, pass;
+
+	printf ("Testing blitter fill SSE2 ...");
+	for (pass = 0; pass < 4; pass++) {
+		for (lines = 1; lines <= FILL_MAXLINES; lines++) {
+			for (words = 1; words <= FILL_MAXWORDS; words++) {
+				for (mod = 0; mod <= FILL_MAXMOD; mod += 2) {
+					for (ife = 0; ife < 2; ife++) {
+						for (fci = 0; fci < 2; fci++) {
+							for (desc = 0; desc < 2; desc++) {
+								int linestep = (words * 2 + mod) * (desc ? -1 : 1);
+								int size = lines * (words * 2 + mod);
+								uae_u8 *p1 = desc ? buf1 + size - mod - 2 : buf1;
+								uae_u8 *p2 = desc ? buf2 + size - mod - 2 : buf2;
+								uae_u16 d1, d2;
+								int fc1, fc2, nz1, nz2, i;
+
+								for (i = 0; i < FILL_SIZE; i++) {
+									/* sparse edges like a line drawn outline, sometimes none */
+									uae_u32 r = rnd ();
+									buf1[i] = (pass & 1) ? r : ((r & 0x300) ? 0 : (1 << (r & 7)));
+								}
+								memcpy (buf2, buf1, FILL_SIZE);
+								d1 = d2 = rnd ();
+								nz1 = fill_generic (p1, lines, words, desc ? -2 : 2, linestep, ife, fci, &d1, &fc1);
+								nz2 = blitter_fill_area (p2, lines, words, desc ? -2 : 2, linestep, ife, fci, &d2, &fc2);
+								n_tests++;
+								if (memcmp (buf1, buf2, FILL_SIZE) || d1 != d2 || fc1 != fc2 || !nz1 != !nz2) {
+									if (verbose)
+										printf ("\n lines=%d words=%d mod=%d ife=%d fci=%d desc=%d: mismatch",
+											lines, words, mod, ife, fci, desc);
+									n_failures++;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	printf (" done %ld/%ld\n", n_tests - n_failures, n_tests);
+	n_all_tests += n_tests;
+	n_all_failures += n_failures;
+}
+
+#endif
+
+int main (void)
+{
+	int level = simd_level ();
+
+	n_all_tests = n_all_failures = 0;
+	blitter_filltable_init ();
+
+#ifdef HAVE_SSE2_INTRINSICS
+	if (level >= HOST_SIMD_SSE2)
+		test_p2c (pfield_doline_sse2_funcs, "SSE2");
+#ifdef HAVE_AVX2_INTRINSICS
+	if (level >= HOST_SIMD_AVX2)
+		test_p2c (pfield_doline_avx2_funcs, "AVX2");
+	else
+		printf ("AVX2 not supported by this CPU, skipped\n");
+#endif
+#endif
+#ifdef BLITTER_SIMD
+	if (level >= HOST_SIMD_SSE2)
+		test_fill ();
+#endif
+
+	printf ("\n");
+	printf ("All %ld tests run, %ld failures\n", n_all_tests, n_all_failures);
+	return n_all_failures != 0;
+}